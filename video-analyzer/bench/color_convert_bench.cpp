@@ -0,0 +1,139 @@
+// BGR24 -> I420 conversion cost at the encoder's input: the fixed-point SIMD
+// converter (core::bgrToI420) against the sws_scale path it replaced.
+//
+//   color_convert_bench [--iters 100] [--threads 4]
+//
+// Runs at 720p, 1080p and 4K on a synthetic gradient frame. The swscale
+// column keeps one cached context per size (the old encoder's steady state)
+// and reports the largest per-sample difference to core::bgrToI420; it is
+// only built when FFmpeg is available.
+
+#include "core/color_convert.hpp"
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#ifdef USE_FFMPEG
+extern "C" {
+#include <libswscale/swscale.h>
+}
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Size {
+    const char* name;
+    int width;
+    int height;
+};
+
+std::vector<uint8_t> syntheticBgr(int width, int height) {
+    std::vector<uint8_t> bgr(static_cast<size_t>(width) * static_cast<size_t>(height) * 3);
+    for (int y = 0; y < height; ++y) {
+        uint8_t* row = bgr.data() + static_cast<size_t>(y) * static_cast<size_t>(width) * 3;
+        for (int x = 0; x < width; ++x) {
+            row[x * 3 + 0] = static_cast<uint8_t>((x * 255) / std::max(1, width - 1));
+            row[x * 3 + 1] = static_cast<uint8_t>((y * 255) / std::max(1, height - 1));
+            row[x * 3 + 2] = static_cast<uint8_t>((x + y) * 7);
+        }
+    }
+    return bgr;
+}
+
+double timeMs(int iters, const std::function<void()>& fn) {
+    fn();
+    const auto start = Clock::now();
+    for (int i = 0; i < iters; ++i) {
+        fn();
+    }
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count() / iters;
+}
+
+int maxAbsDiff(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b) {
+    int diff = 0;
+    for (size_t i = 0; i < std::min(a.size(), b.size()); ++i) {
+        diff = std::max(diff, std::abs(static_cast<int>(a[i]) - static_cast<int>(b[i])));
+    }
+    return diff;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int iters = 100;
+    int threads = 4;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--iters" && i + 1 < argc) {
+            iters = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = std::max(1, std::atoi(argv[++i]));
+        } else {
+            std::fprintf(stderr, "usage: %s [--iters N] [--threads N]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    const Size sizes[] = {{"720p", 1280, 720}, {"1080p", 1920, 1080}, {"4K", 3840, 2160}};
+    for (const auto& size : sizes) {
+        const int w = size.width;
+        const int h = size.height;
+        const auto bgr = syntheticBgr(w, h);
+        const size_t bgr_stride = static_cast<size_t>(w) * 3;
+        std::vector<uint8_t> i420(va::core::frameBytes(va::core::PixelFormat::I420, w, h));
+        const auto planes = va::core::i420Planes(i420.data(), w, h);
+
+        const double single_ms = timeMs(iters, [&]() {
+            va::core::bgrToI420(bgr.data(), bgr_stride, w, h, planes, 1);
+        });
+        const double multi_ms = timeMs(iters, [&]() {
+            va::core::bgrToI420(bgr.data(), bgr_stride, w, h, planes, threads);
+        });
+
+        std::vector<uint8_t> cv_i420(i420.size());
+        const cv::Mat src(h, w, CV_8UC3, const_cast<uint8_t*>(bgr.data()));
+        cv::Mat cv_dst(h * 3 / 2, w, CV_8UC1, cv_i420.data());
+        const double cv_ms = timeMs(iters, [&]() {
+            cv::cvtColor(src, cv_dst, cv::COLOR_BGR2YUV_I420);
+        });
+
+        std::printf("%s (%dx%d), %d iterations\n", size.name, w, h, iters);
+        std::printf("  bgrToI420 x1   %7.2f ms\n", single_ms);
+        std::printf("  bgrToI420 x%-3d %7.2f ms\n", threads, multi_ms);
+        std::printf("  cv::cvtColor   %7.2f ms  (max diff %d)\n", cv_ms, maxAbsDiff(i420, cv_i420));
+
+#ifdef USE_FFMPEG
+        SwsContext* sws = sws_getContext(w, h, AV_PIX_FMT_BGR24, w, h, AV_PIX_FMT_YUV420P,
+                                         SWS_BILINEAR, nullptr, nullptr, nullptr);
+        if (!sws) {
+            std::fprintf(stderr, "sws_getContext failed for %s\n", size.name);
+            return 2;
+        }
+        std::vector<uint8_t> sws_i420(i420.size());
+        const auto sws_planes = va::core::i420Planes(sws_i420.data(), w, h);
+        const uint8_t* src_slices[1] = {bgr.data()};
+        const int src_strides[1] = {static_cast<int>(bgr_stride)};
+        uint8_t* dst_slices[3] = {sws_planes.y, sws_planes.u, sws_planes.v};
+        const int dst_strides[3] = {static_cast<int>(sws_planes.y_stride), static_cast<int>(sws_planes.u_stride),
+                                    static_cast<int>(sws_planes.v_stride)};
+        const double sws_ms = timeMs(iters, [&]() {
+            sws_scale(sws, src_slices, src_strides, 0, h, dst_slices, dst_strides);
+        });
+        sws_freeContext(sws);
+        std::printf("  sws_scale      %7.2f ms  (max diff %d, %.1fx slower than x1)\n",
+                    sws_ms, maxAbsDiff(i420, sws_i420), sws_ms / std::max(single_ms, 1e-6));
+#endif
+    }
+    return 0;
+}
@@ -0,0 +1,247 @@
+// Compares YOLO (decode + NMS) with DETR/RT-DETR (top-K, no NMS)
+// postprocessing on heads recorded from the same frame.
+//
+//   postproc_bench [--yolo head.f32 --yolo-shape 1x84x8400]
+//                  [--detr out.f32 --detr-shape 1x300x84 [--detr-boxes boxes.f32]]
+//                  [--activation none|sigmoid|softmax] [--box-units normalized|pixels]
+//                  [--objects 150] [--iters 200] [--conf 0.25]
+//
+// Record heads with test/scripts/record_model_outputs.py. Without recorded
+// tensors a synthetic scene with --objects objects is generated: every object
+// lights up a cluster of overlapping YOLO anchors (the dense-scene NMS cost)
+// and one DETR query.
+
+#include "analyzer/postproc_detr.hpp"
+#include "analyzer/postproc_yolo_det.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Tensor {
+    std::vector<float> data;
+    std::vector<int64_t> shape;
+
+    va::core::TensorView view() const {
+        va::core::TensorView v;
+        v.data = const_cast<float*>(data.data());
+        v.shape = shape;
+        v.dtype = va::core::DType::F32;
+        return v;
+    }
+};
+
+std::vector<int64_t> parseShape(const std::string& text) {
+    std::vector<int64_t> shape;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, 'x')) {
+        shape.push_back(std::stoll(item));
+    }
+    return shape;
+}
+
+bool loadTensor(const std::string& path, const std::string& shape_text, Tensor& tensor) {
+    tensor.shape = parseShape(shape_text);
+    size_t count = 1;
+    for (int64_t dim : tensor.shape) {
+        count *= static_cast<size_t>(dim);
+    }
+    std::ifstream in(path, std::ios::binary);
+    if (!in || tensor.shape.size() != 3) {
+        return false;
+    }
+    tensor.data.resize(count);
+    in.read(reinterpret_cast<char*>(tensor.data.data()), static_cast<std::streamsize>(count * sizeof(float)));
+    return static_cast<size_t>(in.gcount()) == count * sizeof(float);
+}
+
+struct Scene {
+    Tensor yolo;                   // [1, 84, 8400]
+    std::vector<Tensor> detr;      // [1, 300, 84], probabilities
+};
+
+Scene syntheticScene(int objects) {
+    constexpr int kAnchors = 8400;
+    constexpr int kClasses = 80;
+    constexpr int kQueries = 300;
+    constexpr int kCluster = 30;
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> pos(40.0f, 600.0f);
+    std::uniform_real_distribution<float> size(16.0f, 120.0f);
+    std::uniform_real_distribution<float> jitter(-4.0f, 4.0f);
+    std::uniform_real_distribution<float> high(0.4f, 0.95f);
+    std::uniform_real_distribution<float> low(0.0f, 0.02f);
+    std::uniform_int_distribution<int> cls(0, kClasses - 1);
+
+    Scene scene;
+    scene.yolo.shape = {1, 4 + kClasses, kAnchors};
+    scene.yolo.data.assign(static_cast<size_t>(4 + kClasses) * kAnchors, 0.0f);
+    Tensor detr;
+    detr.shape = {1, kQueries, 4 + kClasses};
+    detr.data.assign(static_cast<size_t>(kQueries) * (4 + kClasses), 0.0f);
+
+    auto yolo_at = [&](int attr, int anchor) -> float& {
+        return scene.yolo.data[static_cast<size_t>(attr) * kAnchors + anchor];
+    };
+    for (int a = 0; a < kAnchors; ++a) {
+        for (int c = 0; c < kClasses; ++c) {
+            yolo_at(4 + c, a) = low(rng);
+        }
+    }
+    for (int q = 0; q < kQueries; ++q) {
+        float* row = &detr.data[static_cast<size_t>(q) * (4 + kClasses)];
+        row[0] = row[1] = 0.5f;
+        row[2] = row[3] = 0.05f;
+        for (int c = 0; c < kClasses; ++c) {
+            row[4 + c] = low(rng);
+        }
+    }
+
+    objects = std::min(objects, std::min(kQueries, kAnchors / kCluster));
+    for (int o = 0; o < objects; ++o) {
+        const float cx = pos(rng);
+        const float cy = pos(rng);
+        const float w = size(rng);
+        const float h = size(rng);
+        const int label = cls(rng);
+        const float score = high(rng);
+        for (int k = 0; k < kCluster; ++k) {
+            const int a = o * kCluster + k;
+            yolo_at(0, a) = cx + jitter(rng);
+            yolo_at(1, a) = cy + jitter(rng);
+            yolo_at(2, a) = w + jitter(rng);
+            yolo_at(3, a) = h + jitter(rng);
+            yolo_at(4 + label, a) = score - 0.01f * static_cast<float>(k);
+        }
+        float* row = &detr.data[static_cast<size_t>(o) * (4 + kClasses)];
+        row[0] = cx / 640.0f;
+        row[1] = cy / 640.0f;
+        row[2] = w / 640.0f;
+        row[3] = h / 640.0f;
+        row[4 + label] = score;
+    }
+    scene.detr.push_back(std::move(detr));
+    return scene;
+}
+
+double timeMs(va::analyzer::IPostprocessor& post,
+              const std::vector<va::core::TensorView>& outputs,
+              const va::analyzer::AnalyzerParams& params,
+              int iters,
+              size_t& boxes) {
+    va::core::LetterboxMeta meta;
+    meta.scale = 1.0f;
+    meta.input_width = meta.original_width = 640;
+    meta.input_height = meta.original_height = 640;
+
+    va::core::ModelOutput output;
+    post.run(outputs, meta, params, output);
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iters; ++i) {
+        post.run(outputs, meta, params, output);
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    boxes = output.boxes.size();
+    return std::chrono::duration<double, std::milli>(elapsed).count() / iters;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string yolo_path;
+    std::string yolo_shape = "1x84x8400";
+    std::string detr_path;
+    std::string detr_shape = "1x300x84";
+    std::string detr_boxes_path;
+    std::string activation = "none";
+    std::string box_units = "normalized";
+    int objects = 150;
+    int iters = 200;
+    va::analyzer::AnalyzerParams params;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--yolo" && has_value) {
+            yolo_path = argv[++i];
+        } else if (arg == "--yolo-shape" && has_value) {
+            yolo_shape = argv[++i];
+        } else if (arg == "--detr" && has_value) {
+            detr_path = argv[++i];
+        } else if (arg == "--detr-shape" && has_value) {
+            detr_shape = argv[++i];
+        } else if (arg == "--detr-boxes" && has_value) {
+            detr_boxes_path = argv[++i];
+        } else if (arg == "--activation" && has_value) {
+            activation = argv[++i];
+        } else if (arg == "--box-units" && has_value) {
+            box_units = argv[++i];
+        } else if (arg == "--objects" && has_value) {
+            objects = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--iters" && has_value) {
+            iters = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--conf" && has_value) {
+            params.confidence_threshold = static_cast<float>(std::atof(argv[++i]));
+        } else {
+            std::cerr << "usage: " << argv[0]
+                      << " [--yolo head.f32 --yolo-shape 1x84x8400] [--detr out.f32 --detr-shape 1x300x84"
+                         " [--detr-boxes boxes.f32]] [--activation none|sigmoid|softmax]"
+                         " [--box-units normalized|pixels] [--objects N]"
+                         " [--iters N] [--conf 0.25]" << std::endl;
+            return 2;
+        }
+    }
+
+    Scene scene = syntheticScene(objects);
+    if (!yolo_path.empty() && !loadTensor(yolo_path, yolo_shape, scene.yolo)) {
+        std::cerr << "failed to load " << yolo_path << " as " << yolo_shape << std::endl;
+        return 1;
+    }
+    if (!detr_path.empty()) {
+        scene.detr.assign(1, Tensor{});
+        if (!loadTensor(detr_path, detr_shape, scene.detr[0])) {
+            std::cerr << "failed to load " << detr_path << " as " << detr_shape << std::endl;
+            return 1;
+        }
+        if (!detr_boxes_path.empty()) {
+            const auto shape = parseShape(detr_shape);
+            const std::string boxes_shape = "1x" + std::to_string(shape.size() > 1 ? shape[1] : 0) + "x4";
+            scene.detr.emplace_back();
+            if (!loadTensor(detr_boxes_path, boxes_shape, scene.detr[1])) {
+                std::cerr << "failed to load " << detr_boxes_path << " as " << boxes_shape << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    va::analyzer::YoloDetectionPostprocessor yolo;
+    va::analyzer::DetrPostprocessor::Options options;
+    options.activation = va::analyzer::parseScoreActivation(activation);
+    options.box_units = va::analyzer::parseBoxUnits(box_units);
+    va::analyzer::DetrPostprocessor detr(options);
+
+    std::vector<va::core::TensorView> detr_views;
+    for (const auto& tensor : scene.detr) {
+        detr_views.push_back(tensor.view());
+    }
+
+    size_t yolo_boxes = 0;
+    size_t detr_boxes = 0;
+    const double yolo_ms = timeMs(yolo, {scene.yolo.view()}, params, iters, yolo_boxes);
+    const double detr_ms = timeMs(detr, detr_views, params, iters, detr_boxes);
+    std::printf("yolo  decode+nms  %8.3f ms  boxes %zu\n", yolo_ms, yolo_boxes);
+    std::printf("detr  top-k       %8.3f ms  boxes %zu  (%s)\n", detr_ms, detr_boxes,
+                va::analyzer::scoreActivationName(options.activation));
+    std::printf("detr speedup      %8.2fx\n", detr_ms > 0.0 ? yolo_ms / detr_ms : 0.0);
+    return 0;
+}
@@ -0,0 +1,199 @@
+// Compares the SIMD early-exit YOLO decoder with the scalar reference decoder.
+//
+//   yolo_decode_bench [--tensor raw.f32 --shape 1x84x8400] [--iters 200] [--conf 0.25]
+//
+// --tensor takes a raw little-endian float32 dump of the detection head
+// (numpy: `output.astype(np.float32).tofile(path)`, see
+// test/scripts/record_model_outputs.py). Without it a synthetic 640x640 COCO
+// head is generated. Both layouts are measured: the recorded/synthetic one and
+// its transpose.
+
+#include "analyzer/postproc_yolo_det.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using va::analyzer::YoloDetectionPostprocessor;
+
+struct Tensor {
+    std::vector<float> data;
+    std::vector<int64_t> shape;
+};
+
+std::vector<int64_t> parseShape(const std::string& text) {
+    std::vector<int64_t> shape;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, 'x')) {
+        shape.push_back(std::stoll(item));
+    }
+    return shape;
+}
+
+bool loadTensor(const std::string& path, const std::vector<int64_t>& shape, Tensor& tensor) {
+    size_t count = 1;
+    for (int64_t dim : shape) {
+        count *= static_cast<size_t>(dim);
+    }
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    tensor.data.resize(count);
+    in.read(reinterpret_cast<char*>(tensor.data.data()), static_cast<std::streamsize>(count * sizeof(float)));
+    tensor.shape = shape;
+    return static_cast<size_t>(in.gcount()) == count * sizeof(float);
+}
+
+// Channels-first [1, 4 + classes, anchors] head: background-level scores
+// everywhere and a few hundred confident anchors clustered around objects.
+Tensor syntheticHead(int anchors, int classes) {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> low(0.0f, 0.02f);
+    std::uniform_real_distribution<float> pos(0.0f, 640.0f);
+    std::uniform_real_distribution<float> size(8.0f, 200.0f);
+    std::uniform_real_distribution<float> high(0.3f, 0.95f);
+    std::uniform_int_distribution<int> cls(0, classes - 1);
+
+    Tensor tensor;
+    tensor.shape = {1, 4 + classes, anchors};
+    tensor.data.resize(static_cast<size_t>(4 + classes) * anchors);
+    auto at = [&](int attr, int anchor) -> float& {
+        return tensor.data[static_cast<size_t>(attr) * anchors + anchor];
+    };
+    for (int a = 0; a < anchors; ++a) {
+        at(0, a) = pos(rng);
+        at(1, a) = pos(rng);
+        at(2, a) = size(rng);
+        at(3, a) = size(rng);
+        for (int c = 0; c < classes; ++c) {
+            at(4 + c, a) = low(rng);
+        }
+        if (a % 40 == 0) {
+            at(4 + cls(rng), a) = high(rng);
+        }
+    }
+    return tensor;
+}
+
+Tensor transpose(const Tensor& src) {
+    const int64_t rows = src.shape[1];
+    const int64_t cols = src.shape[2];
+    Tensor dst;
+    dst.shape = {1, cols, rows};
+    dst.data.resize(src.data.size());
+    for (int64_t r = 0; r < rows; ++r) {
+        for (int64_t c = 0; c < cols; ++c) {
+            dst.data[static_cast<size_t>(c * rows + r)] = src.data[static_cast<size_t>(r * cols + c)];
+        }
+    }
+    return dst;
+}
+
+double benchOnce(YoloDetectionPostprocessor& post,
+                 const Tensor& tensor,
+                 const va::analyzer::AnalyzerParams& params,
+                 int iters,
+                 va::core::ModelOutput& output) {
+    va::core::TensorView view;
+    view.data = const_cast<float*>(tensor.data.data());
+    view.shape = tensor.shape;
+    view.dtype = va::core::DType::F32;
+    const std::vector<va::core::TensorView> outputs {view};
+
+    va::core::LetterboxMeta meta;
+    meta.scale = 1.0f;
+    meta.input_width = meta.original_width = 640;
+    meta.input_height = meta.original_height = 640;
+
+    post.run(outputs, meta, params, output);  // warm-up, sizes scratch buffers
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iters; ++i) {
+        post.run(outputs, meta, params, output);
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::milli>(elapsed).count() / iters;
+}
+
+bool sameBoxes(const va::core::ModelOutput& a, const va::core::ModelOutput& b) {
+    if (a.boxes.size() != b.boxes.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.boxes.size(); ++i) {
+        const auto& x = a.boxes[i];
+        const auto& y = b.boxes[i];
+        if (x.cls != y.cls || x.score != y.score || x.x1 != y.x1 || x.y1 != y.y1 || x.x2 != y.x2 || x.y2 != y.y2) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool compare(const char* label, const Tensor& tensor, const va::analyzer::AnalyzerParams& params, int iters) {
+    YoloDetectionPostprocessor scalar({}, YoloDetectionPostprocessor::DecodeMode::Scalar);
+    YoloDetectionPostprocessor simd({}, YoloDetectionPostprocessor::DecodeMode::Simd);
+    va::core::ModelOutput scalar_out;
+    va::core::ModelOutput simd_out;
+    const double scalar_ms = benchOnce(scalar, tensor, params, iters, scalar_out);
+    const double simd_ms = benchOnce(simd, tensor, params, iters, simd_out);
+    const bool match = sameBoxes(scalar_out, simd_out);
+    std::printf("%-24s scalar %8.3f ms  simd %8.3f ms  speedup %5.2fx  boxes %zu  %s\n",
+                label, scalar_ms, simd_ms, simd_ms > 0.0 ? scalar_ms / simd_ms : 0.0,
+                simd_out.boxes.size(), match ? "match" : "MISMATCH");
+    return match;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string tensor_path;
+    std::string shape_text = "1x84x8400";
+    int iters = 200;
+    va::analyzer::AnalyzerParams params;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--tensor" && has_value) {
+            tensor_path = argv[++i];
+        } else if (arg == "--shape" && has_value) {
+            shape_text = argv[++i];
+        } else if (arg == "--iters" && has_value) {
+            iters = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--conf" && has_value) {
+            params.confidence_threshold = static_cast<float>(std::atof(argv[++i]));
+        } else {
+            std::cerr << "usage: " << argv[0]
+                      << " [--tensor raw.f32 --shape 1x84x8400] [--iters N] [--conf 0.25]" << std::endl;
+            return 2;
+        }
+    }
+
+    Tensor tensor;
+    if (!tensor_path.empty()) {
+        const auto shape = parseShape(shape_text);
+        if (shape.size() != 3 || shape[0] != 1 || !loadTensor(tensor_path, shape, tensor)) {
+            std::cerr << "failed to load " << tensor_path << " as " << shape_text << std::endl;
+            return 1;
+        }
+    } else {
+        tensor = syntheticHead(8400, 80);
+    }
+
+    const Tensor transposed = transpose(tensor);
+    const bool first_is_cf = tensor.shape[1] < tensor.shape[2];
+    bool ok = compare(first_is_cf ? "[1, C, N] channels-first" : "[1, N, C] row-major", tensor, params, iters);
+    ok = compare(first_is_cf ? "[1, N, C] row-major" : "[1, C, N] channels-first", transposed, params, iters) && ok;
+    return ok ? 0 : 1;
+}
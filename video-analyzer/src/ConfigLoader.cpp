@@ -1,9 +1,10 @@
 #include "ConfigLoader.hpp"
 
+#include "core/utils.hpp"
+
 #include <yaml-cpp/yaml.h>
 
 #include <algorithm>
-#include <cctype>
 #include <cmath>
 #include <fstream>
 
@@ -139,6 +140,8 @@ ProfileEntry parseProfileEntry(const std::string& name, const YAML::Node& v) {
         entry.enc_gop = e["gop"].as<int>(0);
         entry.enc_bframes = e["bframes"].as<int>(0);
         entry.enc_zero_latency = e["zero_latency"].as<bool>(true);
+        entry.enc_threads = e["threads"].as<std::string>(entry.enc_threads);
+        entry.enc_thread_type = e["thread_type"].as<std::string>("");
         entry.enc_preset = e["preset"].as<std::string>("");
         entry.enc_tune = e["tune"].as<std::string>("");
         entry.enc_profile = e["profile"].as<std::string>("");
@@ -150,6 +153,48 @@ ProfileEntry parseProfileEntry(const std::string& name, const YAML::Node& v) {
         const auto& pub = publish_node;
         entry.publish_whip_template = pub["whip_url_template"].as<std::string>("");
         entry.publish_whep_template = pub["whep_url_template"].as<std::string>("");
+        entry.publish_transport = pub["transport"].as<std::string>(entry.publish_transport);
+    }
+
+    const auto decode_node = v["decode"];
+    if (decode_node && decode_node.IsMap()) {
+        entry.decode_scale = decode_node["scale"].as<std::string>(entry.decode_scale);
+        entry.decode_frame_stride = decode_node["frame_stride"].as<int>(entry.decode_frame_stride);
+        entry.decode_skip_nonref = decode_node["skip_nonref"].as<bool>(entry.decode_skip_nonref);
+    }
+
+    const auto render_node = v["render"];
+    if (render_node && render_node.IsMap()) {
+        entry.render_overlay = render_node["overlay"].as<bool>(entry.render_overlay);
+        entry.render_labels = render_node["labels"].as<bool>(entry.render_labels);
+        entry.render_mask_alpha = render_node["mask_alpha"].as<float>(entry.render_mask_alpha);
+        entry.render_thickness = render_node["thickness"].as<int>(entry.render_thickness);
+    }
+
+    const auto output_node = v["output"];
+    if (output_node && output_node.IsMap()) {
+        entry.output_mode = output_node["mode"].as<std::string>(entry.output_mode);
+        entry.output_format = output_node["format"].as<std::string>(entry.output_format);
+        entry.output_keyframe_interval = output_node["keyframe_interval"].as<int>(entry.output_keyframe_interval);
+    }
+
+    const auto preprocess_node = v["preprocess"];
+    if (preprocess_node && preprocess_node.IsMap()) {
+        entry.preprocess_channel_order = preprocess_node["channel_order"].as<std::string>(entry.preprocess_channel_order);
+        entry.preprocess_threads = preprocess_node["threads"].as<int>(entry.preprocess_threads);
+    }
+
+    const auto postprocess_node = v["postprocess"];
+    if (postprocess_node && postprocess_node.IsMap()) {
+        const auto& post = postprocess_node;
+        entry.postprocess_nms = post["nms"].as<std::string>(entry.postprocess_nms);
+        entry.postprocess_top_k = post["top_k"].as<int>(entry.postprocess_top_k);
+        entry.postprocess_max_detections = post["max_detections"].as<int>(entry.postprocess_max_detections);
+        entry.postprocess_class_agnostic = post["class_agnostic"].as<bool>(entry.postprocess_class_agnostic);
+        entry.postprocess_soft_sigma = post["soft_sigma"].as<float>(entry.postprocess_soft_sigma);
+        entry.postprocess_decode = post["decode"].as<std::string>(entry.postprocess_decode);
+        entry.postprocess_score_activation = post["score_activation"].as<std::string>(entry.postprocess_score_activation);
+        entry.postprocess_box_units = post["box_units"].as<std::string>(entry.postprocess_box_units);
     }
 
     return entry;
@@ -159,6 +204,8 @@ AnalyzerParamsEntry parseAnalyzerParamsEntry(const YAML::Node& v) {
     AnalyzerParamsEntry entry;
     entry.conf = v["conf"].as<float>(v["confidence_threshold"].as<float>(entry.conf));
     entry.iou = v["iou"].as<float>(v["nms_threshold"].as<float>(entry.iou));
+    entry.mask_threshold = v["mask_threshold"].as<float>(entry.mask_threshold);
+    entry.max_detections = v["max_detections"].as<int>(v["max_det"].as<int>(entry.max_detections));
 
     const auto class_whitelist = v["class_whitelist"];
     if (class_whitelist && class_whitelist.IsSequence()) {
@@ -206,6 +253,15 @@ AppConfigPayload parseAppConfig(const YAML::Node& v) {
                 opts.tensorrt_min_subgraph_size);
             opts.io_binding_input_bytes = parseByteOption(options_node, "io_binding_input_bytes", "io_binding_input_mb", opts.io_binding_input_bytes);
             opts.io_binding_output_bytes = parseByteOption(options_node, "io_binding_output_bytes", "io_binding_output_mb", opts.io_binding_output_bytes);
+            opts.intra_op_threads = options_node["intra_op_threads"].as<int>(opts.intra_op_threads);
+        }
+
+        const auto batching_node = eng["batching"];
+        if (batching_node && batching_node.IsMap()) {
+            auto& opts = payload.engine.options;
+            opts.batching_enabled = batching_node["enabled"].as<bool>(true);
+            opts.max_batch_size = batching_node["max_batch_size"].as<int>(opts.max_batch_size);
+            opts.max_batch_wait_us = batching_node["max_wait_us"].as<int>(opts.max_batch_wait_us);
         }
     }
     const auto sfu_node = v["sfu"];
@@ -214,6 +270,52 @@ AppConfigPayload parseAppConfig(const YAML::Node& v) {
         payload.sfu_whip_base = sfu["whip_base"].as<std::string>("");
         payload.sfu_whep_base = sfu["whep_base"].as<std::string>("");
     }
+    const auto webrtc_node = v["webrtc"];
+    if (webrtc_node && webrtc_node.IsMap()) {
+        payload.webrtc_ice_port_min = webrtc_node["ice_port_min"].as<int>(payload.webrtc_ice_port_min);
+        payload.webrtc_ice_port_max = webrtc_node["ice_port_max"].as<int>(payload.webrtc_ice_port_max);
+    }
+    const auto decoder_node = v["defaults"] ? v["defaults"]["decoder"] : YAML::Node();
+    if (decoder_node && decoder_node.IsMap()) {
+        auto& dec = payload.decoder;
+        dec.impl = decoder_node["impl"].as<std::string>(dec.impl);
+        dec.low_delay = decoder_node["low_delay"].as<bool>(dec.low_delay);
+        dec.threads = decoder_node["threads"].as<int>(dec.threads);
+        dec.thread_type = decoder_node["thread_type"].as<std::string>(dec.thread_type);
+        dec.output = decoder_node["output"].as<std::string>(dec.output);
+        const auto rtsp_node = decoder_node["rtsp"];
+        if (rtsp_node && rtsp_node.IsMap()) {
+            dec.rtsp_prefer_tcp = rtsp_node["prefer_tcp"].as<bool>(dec.rtsp_prefer_tcp);
+            dec.rtsp_timeout_ms = rtsp_node["timeout_ms"].as<int>(dec.rtsp_timeout_ms);
+        }
+        const auto buffer_node = decoder_node["buffer"];
+        if (buffer_node && buffer_node.IsMap()) {
+            dec.buffer_depth = buffer_node["depth"].as<int>(dec.buffer_depth);
+            dec.buffer_policy = buffer_node["policy"].as<std::string>(dec.buffer_policy);
+        }
+        const auto reconnect_node = decoder_node["reconnect"];
+        if (reconnect_node && reconnect_node.IsMap()) {
+            dec.reconnect_initial_ms = reconnect_node["initial_ms"].as<int>(dec.reconnect_initial_ms);
+            dec.reconnect_max_ms = reconnect_node["max_ms"].as<int>(dec.reconnect_max_ms);
+            dec.reconnect_jitter = reconnect_node["jitter"].as<double>(dec.reconnect_jitter);
+            dec.reconnect_max_attempts = reconnect_node["max_attempts"].as<int>(dec.reconnect_max_attempts);
+            dec.stall_timeout_ms = reconnect_node["stall_timeout_ms"].as<int>(dec.stall_timeout_ms);
+        }
+    }
+    const auto pipeline_node = v["defaults"] ? v["defaults"]["pipeline"] : YAML::Node();
+    if (pipeline_node && pipeline_node.IsMap()) {
+        auto& pipe = payload.pipeline;
+        pipe.execution_mode = pipeline_node["mode"].as<std::string>(pipe.execution_mode);
+        pipe.queue_depth = pipeline_node["queue_depth"].as<int>(pipe.queue_depth);
+    }
+    const auto limits_node = v["security"] ? v["security"]["switch_limits"] : YAML::Node();
+    if (limits_node && limits_node.IsMap()) {
+        auto& limits = payload.security.switch_limits;
+        limits.source_per_stream_per_sec = limits_node["source_per_stream_per_sec"].as<double>(
+            limits.source_per_stream_per_sec);
+        limits.model_per_stream_per_sec = limits_node["model_per_stream_per_sec"].as<double>(
+            limits.model_per_stream_per_sec);
+    }
     const auto observability_node = v["observability"];
     if (observability_node && observability_node.IsMap()) {
         auto& obs = payload.observability;
@@ -323,8 +425,7 @@ std::map<std::string, AnalyzerParamsEntry> ConfigLoader::loadAnalyzerParams(cons
         if (!task_value.IsMap()) {
             continue;
         }
-        std::string key = task_name;
-        std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c){ return static_cast<char>(std::tolower(c)); });
+        std::string key = va::core::toLower(task_name);
         params.emplace(key, parseAnalyzerParamsEntry(task_value));
     }
     return params;
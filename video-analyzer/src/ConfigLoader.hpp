@@ -32,6 +32,9 @@ struct ProfileEntry {
     std::string model_path;
     int input_width {0};
     int input_height {0};
+    std::string decode_scale {"auto"};   // "auto": decode to the size the pipeline uses; "stretch"; "native"
+    int decode_frame_stride {1};         // deliver every Nth decoded frame
+    bool decode_skip_nonref {true};      // with a stride, let the decoder drop non-reference frames
     int enc_width {0};
     int enc_height {0};
     int enc_fps {0};
@@ -39,17 +42,39 @@ struct ProfileEntry {
     int enc_gop {0};
     int enc_bframes {0};
     bool enc_zero_latency {true};
+    std::string enc_threads {"auto"};  // "auto" or a thread count
+    std::string enc_thread_type;        // "slice" / "frame"; empty follows zero_latency
     std::string enc_preset;
     std::string enc_tune;
     std::string enc_profile;
     std::string enc_codec;
     std::string publish_whip_template;
     std::string publish_whep_template;
+    std::string publish_transport {"datachannel"};
+    std::string preprocess_channel_order {"rgb"};
+    int preprocess_threads {0};
+    std::string postprocess_nms {"hard"};
+    int postprocess_top_k {1000};
+    int postprocess_max_detections {300};
+    bool postprocess_class_agnostic {false};
+    float postprocess_soft_sigma {0.5f};
+    std::string postprocess_decode {"simd"};
+    std::string postprocess_score_activation {"sigmoid"};
+    std::string postprocess_box_units {"normalized"};
+    bool render_overlay {true};
+    bool render_labels {true};
+    float render_mask_alpha {0.45f};
+    int render_thickness {2};
+    std::string output_mode {"video"};
+    std::string output_format {"binary"};
+    int output_keyframe_interval {30};
 };
 
 struct AnalyzerParamsEntry {
     float conf {0.0f};
     float iou {0.0f};
+    float mask_threshold {0.5f};
+    int max_detections {0};
     std::vector<std::string> class_whitelist;
     std::optional<std::string> classes_literal;
 };
@@ -66,6 +91,10 @@ struct EngineOptions {
     int tensorrt_min_subgraph_size {0};
     size_t io_binding_input_bytes {0};
     size_t io_binding_output_bytes {0};
+    bool batching_enabled {false};
+    int max_batch_size {1};
+    int max_batch_wait_us {0};
+    int intra_op_threads {1};
 };
 
 struct AppEngineSpec {
@@ -75,6 +104,37 @@ struct AppEngineSpec {
     EngineOptions options;
 };
 
+struct DecoderDefaults {
+    std::string impl {"ffmpeg"};
+    bool rtsp_prefer_tcp {true};
+    int rtsp_timeout_ms {5000};
+    bool low_delay {true};
+    int threads {0};
+    std::string thread_type {"frame"};
+    std::string output {"bgr"};
+    int buffer_depth {2};
+    std::string buffer_policy {"latest"};
+    int reconnect_initial_ms {500};
+    int reconnect_max_ms {30000};
+    double reconnect_jitter {0.2};
+    int reconnect_max_attempts {0};   // 0 = retry forever
+    int stall_timeout_ms {3000};
+};
+
+struct PipelineDefaults {
+    std::string execution_mode {"staged"};
+    int queue_depth {2};
+};
+
+struct SwitchLimits {
+    double source_per_stream_per_sec {0.0}; // 0 = unlimited
+    double model_per_stream_per_sec {0.0};
+};
+
+struct SecurityConfig {
+    SwitchLimits switch_limits;
+};
+
 struct ObservabilityConfig {
     std::string log_level {"info"};
     bool console {true};
@@ -89,6 +149,11 @@ struct AppConfigPayload {
     AppEngineSpec engine;
     std::string sfu_whip_base;
     std::string sfu_whep_base;
+    int webrtc_ice_port_min {10000};
+    int webrtc_ice_port_max {10100};
+    DecoderDefaults decoder;
+    PipelineDefaults pipeline;
+    SecurityConfig security;
     ObservabilityConfig observability;
 };
 
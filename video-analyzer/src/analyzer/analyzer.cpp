@@ -1,5 +1,8 @@
 #include "analyzer/analyzer.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
 #include <utility>
 
 namespace va::analyzer {
@@ -37,23 +40,58 @@ bool Analyzer::analyze(const core::Frame& in, core::Frame& out) {
         return false;
     }
 
+    core::ModelOutput model_output;
+    if (!infer(tensor, meta, model_output)) {
+        return false;
+    }
+
+    return renderer_->draw(in, model_output, out);
+}
+
+bool Analyzer::preprocess(const core::Frame& in,
+                          std::vector<float>& storage,
+                          core::TensorView& tensor,
+                          core::LetterboxMeta& meta) {
+    if (!preprocessor_) {
+        return false;
+    }
+    return preprocessor_->runInto(in, storage, tensor, meta);
+}
+
+bool Analyzer::infer(const core::TensorView& tensor, const core::LetterboxMeta& meta, core::ModelOutput& output) {
+    if (!session_ || !postprocessor_) {
+        return false;
+    }
+
     std::vector<core::TensorView> outputs;
     if (!session_->run(tensor, outputs)) {
         return false;
     }
 
-    core::ModelOutput model_output;
-    if (!postprocessor_->run(outputs, meta, model_output)) {
+    static const AnalyzerParams kDefaultParams;
+    const auto params = std::atomic_load(&params_);
+    if (!postprocessor_->run(outputs, meta, params ? *params : kDefaultParams, output)) {
         return false;
     }
 
-    if (params_) {
-        for (auto& box : model_output.boxes) {
-            box.score = std::min(std::max(box.score, 0.0f), 1.0f);
-        }
+    for (auto& box : output.boxes) {
+        box.score = std::min(std::max(box.score, 0.0f), 1.0f);
     }
+    return true;
+}
 
-    return renderer_->draw(in, model_output, out);
+bool Analyzer::render(const core::Frame& in, const core::ModelOutput& output, core::Frame& out) {
+    if (!renderer_) {
+        return false;
+    }
+    return renderer_->draw(in, output, out);
+}
+
+bool Analyzer::renderInPlace(core::Frame& frame, const core::ModelOutput& output) {
+    if (!renderer_) {
+        return false;
+    }
+    return renderer_->drawInPlace(frame, output);
 }
 
 bool Analyzer::switchModel(const std::string& model_id) {
@@ -72,8 +110,16 @@ bool Analyzer::switchTask(const std::string& /*task_id*/) {
 }
 
 bool Analyzer::updateParams(std::shared_ptr<AnalyzerParams> params) {
-    params_ = std::move(params);
-    return static_cast<bool>(params_);
+    if (!params) {
+        return false;
+    }
+    std::shared_ptr<const AnalyzerParams> next = std::move(params);
+    std::atomic_store(&params_, std::move(next));
+    return true;
+}
+
+std::shared_ptr<const AnalyzerParams> Analyzer::params() const {
+    return std::atomic_load(&params_);
 }
 
 } // namespace va::analyzer
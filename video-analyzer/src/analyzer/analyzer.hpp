@@ -4,14 +4,10 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace va::analyzer {
 
-struct AnalyzerParams {
-    float confidence_threshold {0.25f};
-    float iou_threshold {0.45f};
-};
-
 class Analyzer : public IFrameFilter {
 public:
     Analyzer();
@@ -24,18 +20,31 @@ public:
 
     bool analyze(const core::Frame& in, core::Frame& out);
 
+    // Stage-wise entry points used by the staged pipeline. Each one may run on a
+    // different thread, but a given stage must not be called concurrently.
+    bool preprocess(const core::Frame& in,
+                    std::vector<float>& storage,
+                    core::TensorView& tensor,
+                    core::LetterboxMeta& meta);
+    bool infer(const core::TensorView& tensor, const core::LetterboxMeta& meta, core::ModelOutput& output);
+    bool render(const core::Frame& in, const core::ModelOutput& output, core::Frame& out);
+    bool renderInPlace(core::Frame& frame, const core::ModelOutput& output);
+
     bool process(const core::Frame& in, core::Frame& out) override { return analyze(in, out); }
 
     bool switchModel(const std::string& model_id);
     bool switchTask(const std::string& task_id);
     bool updateParams(std::shared_ptr<AnalyzerParams> params);
+    std::shared_ptr<const AnalyzerParams> params() const;
 
 private:
     std::shared_ptr<IPreprocessor> preprocessor_;
     std::shared_ptr<IModelSession> session_;
     std::shared_ptr<IPostprocessor> postprocessor_;
     std::shared_ptr<IRenderer> renderer_;
-    std::shared_ptr<AnalyzerParams> params_;
+    // Swapped by REST threads while the infer stage reads it; always accessed
+    // through std::atomic_load/atomic_store.
+    std::shared_ptr<const AnalyzerParams> params_;
     bool use_gpu_hint_ {false};
 };
 
@@ -0,0 +1,81 @@
+#include "analyzer/class_names.hpp"
+
+#include "core/logger.hpp"
+
+#include <algorithm>
+#include <cctype>
+
+namespace va::analyzer {
+
+namespace {
+
+std::string normalizeName(const std::string& value) {
+    std::string out;
+    out.reserve(value.size());
+    for (unsigned char c : value) {
+        if (c == '_' || c == '-') {
+            c = ' ';
+        }
+        out.push_back(static_cast<char>(std::tolower(c)));
+    }
+    const auto first = out.find_first_not_of(' ');
+    const auto last = out.find_last_not_of(' ');
+    return first == std::string::npos ? std::string{} : out.substr(first, last - first + 1);
+}
+
+} // namespace
+
+const std::vector<std::string>& cocoClassNames() {
+    static const std::vector<std::string> names = {
+        "person", "bicycle", "car", "motorcycle", "airplane", "bus", "train", "truck", "boat",
+        "traffic light", "fire hydrant", "stop sign", "parking meter", "bench", "bird", "cat",
+        "dog", "horse", "sheep", "cow", "elephant", "bear", "zebra", "giraffe", "backpack",
+        "umbrella", "handbag", "tie", "suitcase", "frisbee", "skis", "snowboard", "sports ball",
+        "kite", "baseball bat", "baseball glove", "skateboard", "surfboard", "tennis racket",
+        "bottle", "wine glass", "cup", "fork", "knife", "spoon", "bowl", "banana", "apple",
+        "sandwich", "orange", "broccoli", "carrot", "hot dog", "pizza", "donut", "cake", "chair",
+        "couch", "potted plant", "bed", "dining table", "toilet", "tv", "laptop", "mouse",
+        "remote", "keyboard", "cell phone", "microwave", "oven", "toaster", "sink",
+        "refrigerator", "book", "clock", "vase", "scissors", "teddy bear", "hair drier",
+        "toothbrush"
+    };
+    return names;
+}
+
+int resolveClassId(const std::string& token) {
+    const std::string name = normalizeName(token);
+    if (name.empty()) {
+        return -1;
+    }
+    if (std::all_of(name.begin(), name.end(), [](unsigned char c) { return std::isdigit(c); })) {
+        try {
+            return std::stoi(name);
+        } catch (...) {
+            return -1;
+        }
+    }
+    const auto& names = cocoClassNames();
+    auto it = std::find(names.begin(), names.end(), name);
+    return it == names.end() ? -1 : static_cast<int>(it - names.begin());
+}
+
+std::vector<int> resolveClassWhitelist(const std::vector<std::string>& tokens) {
+    std::vector<int> ids;
+    for (const auto& token : tokens) {
+        const std::string name = normalizeName(token);
+        if (name == "all" || name == "*") {
+            return {};
+        }
+        const int id = resolveClassId(name);
+        if (id < 0) {
+            VA_LOG_WARN() << "[Analyzer] ignoring unknown class '" << token << "' in class whitelist";
+            continue;
+        }
+        ids.push_back(id);
+    }
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    return ids;
+}
+
+} // namespace va::analyzer
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace va::analyzer {
+
+// COCO-80 label set used by the bundled YOLO/DETR exports.
+const std::vector<std::string>& cocoClassNames();
+
+// Accepts a numeric id ("0") or a COCO name ("person", "traffic light" /
+// "traffic_light"); returns -1 when the token is not recognised.
+int resolveClassId(const std::string& token);
+
+// Maps config/REST class filters to ids. An empty result means "all classes"
+// (also returned for the literals "all" and "*"); unknown tokens are skipped.
+std::vector<int> resolveClassWhitelist(const std::vector<std::string>& tokens);
+
+} // namespace va::analyzer
@@ -2,6 +2,7 @@
 
 #include "core/utils.hpp"
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <vector>
@@ -13,9 +14,31 @@ using va::core::LetterboxMeta;
 using va::core::ModelOutput;
 using va::core::TensorView;
 
+// Runtime-tunable analysis parameters. Postprocessors apply them during decode
+// so raising a threshold also reduces the work done per frame.
+struct AnalyzerParams {
+    float confidence_threshold {0.25f};
+    float iou_threshold {0.45f};
+    // Caps detections per frame; 0 keeps the profile's postprocess.max_detections.
+    int max_detections {0};
+    // Sorted class ids to keep; empty keeps every class.
+    std::vector<int> class_whitelist;
+    float mask_threshold {0.5f};
+
+    bool allowsClass(int cls) const {
+        return class_whitelist.empty()
+            || std::binary_search(class_whitelist.begin(), class_whitelist.end(), cls);
+    }
+};
+
 struct IPreprocessor {
     virtual ~IPreprocessor() = default;
     virtual bool run(const Frame& in, TensorView& out, LetterboxMeta& meta) = 0;
+    // Variant writing into caller-owned storage so several frames can be in flight
+    // at once. Implementations that reuse an internal buffer must override it.
+    virtual bool runInto(const Frame& in, std::vector<float>& /*storage*/, TensorView& out, LetterboxMeta& meta) {
+        return run(in, out, meta);
+    }
 };
 
 struct IModelSession {
@@ -28,12 +51,19 @@ struct IPostprocessor {
     virtual ~IPostprocessor() = default;
     virtual bool run(const std::vector<TensorView>& raw_outputs,
                      const LetterboxMeta& meta,
+                     const AnalyzerParams& params,
                      ModelOutput& output) = 0;
 };
 
 struct IRenderer {
     virtual ~IRenderer() = default;
     virtual bool draw(const Frame& in, const ModelOutput& output, Frame& out) = 0;
+    // Draws onto `frame` itself. Renderers that write pixels must go through
+    // FrameBuffer::makeWritable() so buffers still shared elsewhere are copied.
+    virtual bool drawInPlace(Frame& frame, const ModelOutput& output) {
+        const Frame in = frame;
+        return draw(in, output, frame);
+    }
 };
 
 struct IFrameFilter {
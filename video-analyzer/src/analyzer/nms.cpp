@@ -0,0 +1,322 @@
+#include "analyzer/nms.hpp"
+
+#include "core/simd.hpp"
+#include "core/utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace va::analyzer {
+
+namespace {
+
+constexpr float kUnionEpsilon = 1e-9f;
+
+// Candidate boxes in SoA form and the IoU row being filled.
+struct IouRow {
+    const float* x1;
+    const float* y1;
+    const float* x2;
+    const float* y2;
+    const float* area;
+    const int32_t* cls;
+    float* iou;
+};
+
+#if defined(VA_SIMD_AVX2)
+// IoU of box i against [j, end) eight at a time; returns where the tail starts.
+VA_TARGET_AVX2 size_t iouRowAvx2(const IouRow& row, size_t i, size_t j, size_t end) {
+    const __m256 vx1 = _mm256_set1_ps(row.x1[i]);
+    const __m256 vy1 = _mm256_set1_ps(row.y1[i]);
+    const __m256 vx2 = _mm256_set1_ps(row.x2[i]);
+    const __m256 vy2 = _mm256_set1_ps(row.y2[i]);
+    const __m256 varea = _mm256_set1_ps(row.area[i]);
+    const __m256i vcls = _mm256_set1_epi32(row.cls[i]);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 eps = _mm256_set1_ps(kUnionEpsilon);
+    for (; j + 8 <= end; j += 8) {
+        const __m256 ix1 = _mm256_max_ps(vx1, _mm256_loadu_ps(row.x1 + j));
+        const __m256 iy1 = _mm256_max_ps(vy1, _mm256_loadu_ps(row.y1 + j));
+        const __m256 ix2 = _mm256_min_ps(vx2, _mm256_loadu_ps(row.x2 + j));
+        const __m256 iy2 = _mm256_min_ps(vy2, _mm256_loadu_ps(row.y2 + j));
+        const __m256 w = _mm256_max_ps(zero, _mm256_sub_ps(ix2, ix1));
+        const __m256 h = _mm256_max_ps(zero, _mm256_sub_ps(iy2, iy1));
+        const __m256 inter = _mm256_mul_ps(w, h);
+        const __m256 uni = _mm256_sub_ps(_mm256_add_ps(varea, _mm256_loadu_ps(row.area + j)), inter);
+        const __m256 same = _mm256_castsi256_ps(_mm256_cmpeq_epi32(
+            vcls, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row.cls + j))));
+        _mm256_storeu_ps(row.iou + j, _mm256_and_ps(same, _mm256_div_ps(inter, _mm256_max_ps(uni, eps))));
+    }
+    return j;
+}
+#endif
+
+#if defined(VA_SIMD_SSE41)
+VA_TARGET_SSE41 size_t iouRowSse41(const IouRow& row, size_t i, size_t j, size_t end) {
+    const __m128 sx1 = _mm_set1_ps(row.x1[i]);
+    const __m128 sy1 = _mm_set1_ps(row.y1[i]);
+    const __m128 sx2 = _mm_set1_ps(row.x2[i]);
+    const __m128 sy2 = _mm_set1_ps(row.y2[i]);
+    const __m128 sarea = _mm_set1_ps(row.area[i]);
+    const __m128i scls = _mm_set1_epi32(row.cls[i]);
+    const __m128 szero = _mm_setzero_ps();
+    const __m128 seps = _mm_set1_ps(kUnionEpsilon);
+    for (; j + 4 <= end; j += 4) {
+        const __m128 ix1 = _mm_max_ps(sx1, _mm_loadu_ps(row.x1 + j));
+        const __m128 iy1 = _mm_max_ps(sy1, _mm_loadu_ps(row.y1 + j));
+        const __m128 ix2 = _mm_min_ps(sx2, _mm_loadu_ps(row.x2 + j));
+        const __m128 iy2 = _mm_min_ps(sy2, _mm_loadu_ps(row.y2 + j));
+        const __m128 w = _mm_max_ps(szero, _mm_sub_ps(ix2, ix1));
+        const __m128 h = _mm_max_ps(szero, _mm_sub_ps(iy2, iy1));
+        const __m128 inter = _mm_mul_ps(w, h);
+        const __m128 uni = _mm_sub_ps(_mm_add_ps(sarea, _mm_loadu_ps(row.area + j)), inter);
+        const __m128 same = _mm_castsi128_ps(_mm_cmpeq_epi32(
+            scls, _mm_loadu_si128(reinterpret_cast<const __m128i*>(row.cls + j))));
+        _mm_storeu_ps(row.iou + j, _mm_and_ps(same, _mm_div_ps(inter, _mm_max_ps(uni, seps))));
+    }
+    return j;
+}
+#endif
+
+} // namespace
+
+NmsMethod parseNmsMethod(const std::string& value) {
+    const std::string lower = core::toLower(value);
+    if (lower == "soft" || lower == "soft_nms" || lower == "soft-nms") {
+        return NmsMethod::Soft;
+    }
+    if (lower == "matrix" || lower == "matrix_nms" || lower == "matrix-nms") {
+        return NmsMethod::Matrix;
+    }
+    return NmsMethod::Hard;
+}
+
+const char* nmsMethodName(NmsMethod method) {
+    switch (method) {
+    case NmsMethod::Soft:
+        return "soft";
+    case NmsMethod::Matrix:
+        return "matrix";
+    case NmsMethod::Hard:
+    default:
+        return "hard";
+    }
+}
+
+void BoxSoA::clear() {
+    x1.clear();
+    y1.clear();
+    x2.clear();
+    y2.clear();
+    score.clear();
+    cls.clear();
+}
+
+void BoxSoA::reserve(size_t count) {
+    x1.reserve(count);
+    y1.reserve(count);
+    x2.reserve(count);
+    y2.reserve(count);
+    score.reserve(count);
+    cls.reserve(count);
+}
+
+void BoxSoA::push(float bx1, float by1, float bx2, float by2, float box_score, int box_cls) {
+    x1.push_back(bx1);
+    y1.push_back(by1);
+    x2.push_back(bx2);
+    y2.push_back(by2);
+    score.push_back(box_score);
+    cls.push_back(box_cls);
+}
+
+NmsEngine::NmsEngine(NmsConfig config)
+    : config_(config) {}
+
+void NmsEngine::run(BoxSoA& boxes, std::vector<int>& keep) {
+    keep.clear();
+    if (boxes.empty()) {
+        return;
+    }
+
+    selectCandidates(boxes);
+    switch (config_.method) {
+    case NmsMethod::Soft:
+        runSoft(boxes, keep);
+        break;
+    case NmsMethod::Matrix:
+        runMatrix(boxes, keep);
+        break;
+    case NmsMethod::Hard:
+    default:
+        runHard(keep);
+        break;
+    }
+}
+
+void NmsEngine::selectCandidates(const BoxSoA& boxes) {
+    const size_t count = boxes.size();
+    order_.resize(count);
+    std::iota(order_.begin(), order_.end(), 0);
+
+    auto by_score = [&boxes](int lhs, int rhs) { return boxes.score[lhs] > boxes.score[rhs]; };
+    if (config_.top_k > 0 && count > static_cast<size_t>(config_.top_k)) {
+        std::nth_element(order_.begin(), order_.begin() + config_.top_k, order_.end(), by_score);
+        order_.resize(static_cast<size_t>(config_.top_k));
+    }
+    std::sort(order_.begin(), order_.end(), by_score);
+
+    // Every candidate carries its class, and pairs of different classes get
+    // IoU 0, so a single sweep behaves exactly like per-class NMS. IoU uses
+    // the boxes' own coordinates, not class-shifted ones, so it is not
+    // rounded differently per class.
+    const size_t m = order_.size();
+    x1_.resize(m);
+    y1_.resize(m);
+    x2_.resize(m);
+    y2_.resize(m);
+    area_.resize(m);
+    cls_.resize(m);
+    scores_.resize(m);
+    iou_.resize(m);
+    for (size_t k = 0; k < m; ++k) {
+        const int idx = order_[k];
+        x1_[k] = boxes.x1[idx];
+        y1_[k] = boxes.y1[idx];
+        x2_[k] = boxes.x2[idx];
+        y2_[k] = boxes.y2[idx];
+        area_[k] = std::max(0.0f, boxes.x2[idx] - boxes.x1[idx]) * std::max(0.0f, boxes.y2[idx] - boxes.y1[idx]);
+        cls_[k] = config_.class_agnostic ? 0 : static_cast<int32_t>(boxes.cls[idx]);
+        scores_[k] = boxes.score[idx];
+    }
+}
+
+void NmsEngine::iouRow(size_t i, size_t begin, size_t end) {
+    const float ax1 = x1_[i];
+    const float ay1 = y1_[i];
+    const float ax2 = x2_[i];
+    const float ay2 = y2_[i];
+    const float aarea = area_[i];
+    const int32_t acls = cls_[i];
+
+    size_t j = begin;
+#if defined(VA_SIMD_SSE41)
+    const IouRow row {x1_.data(), y1_.data(), x2_.data(), y2_.data(), area_.data(), cls_.data(), iou_.data()};
+#endif
+#if defined(VA_SIMD_AVX2)
+    if (core::simd::hasAvx2()) {
+        j = iouRowAvx2(row, i, j, end);
+    }
+#endif
+#if defined(VA_SIMD_SSE41)
+    if (core::simd::hasSse41()) {
+        j = iouRowSse41(row, i, j, end);
+    }
+#endif
+    for (; j < end; ++j) {
+        const float w = std::max(0.0f, std::min(ax2, x2_[j]) - std::max(ax1, x1_[j]));
+        const float h = std::max(0.0f, std::min(ay2, y2_[j]) - std::max(ay1, y1_[j]));
+        const float inter = w * h;
+        iou_[j] = cls_[j] == acls ? inter / std::max(aarea + area_[j] - inter, kUnionEpsilon) : 0.0f;
+    }
+}
+
+void NmsEngine::runHard(std::vector<int>& keep) {
+    const size_t m = order_.size();
+    const size_t limit = config_.max_detections > 0 ? static_cast<size_t>(config_.max_detections) : m;
+    const float threshold = config_.iou_threshold;
+    suppressed_.assign(m, 0);
+
+    for (size_t i = 0; i < m && keep.size() < limit; ++i) {
+        if (suppressed_[i]) {
+            continue;
+        }
+        keep.push_back(order_[i]);
+        iouRow(i, i + 1, m);
+        for (size_t j = i + 1; j < m; ++j) {
+            suppressed_[j] |= static_cast<uint8_t>(iou_[j] > threshold);
+        }
+    }
+}
+
+void NmsEngine::runSoft(BoxSoA& boxes, std::vector<int>& keep) {
+    const size_t m = order_.size();
+    const size_t limit = config_.max_detections > 0 ? static_cast<size_t>(config_.max_detections) : m;
+    const float inv_sigma = 1.0f / std::max(config_.soft_sigma, 1e-6f);
+    suppressed_.assign(m, 0);
+
+    while (keep.size() < limit) {
+        // Scores change every round, so the next box is re-selected each time.
+        size_t best = m;
+        for (size_t j = 0; j < m; ++j) {
+            if (!suppressed_[j] && (best == m || scores_[j] > scores_[best])) {
+                best = j;
+            }
+        }
+        if (best == m || scores_[best] < config_.score_threshold) {
+            break;
+        }
+
+        suppressed_[best] = 1;
+        keep.push_back(order_[best]);
+        boxes.score[order_[best]] = scores_[best];
+
+        iouRow(best, 0, m);
+        for (size_t j = 0; j < m; ++j) {
+            if (suppressed_[j]) {
+                continue;
+            }
+            scores_[j] *= std::exp(-(iou_[j] * iou_[j]) * inv_sigma);
+            if (scores_[j] < config_.score_threshold) {
+                suppressed_[j] = 1;
+            }
+        }
+    }
+}
+
+void NmsEngine::runMatrix(BoxSoA& boxes, std::vector<int>& keep) {
+    const size_t m = order_.size();
+    const float sigma = config_.matrix_sigma;
+
+    // compensate_[j]: largest IoU box j has with any higher-scoring box.
+    compensate_.assign(m, 0.0f);
+    for (size_t i = 0; i + 1 < m; ++i) {
+        iouRow(i, i + 1, m);
+        for (size_t j = i + 1; j < m; ++j) {
+            compensate_[j] = std::max(compensate_[j], iou_[j]);
+        }
+    }
+
+    decay_.assign(m, 1.0f);
+    for (size_t i = 0; i + 1 < m; ++i) {
+        iouRow(i, i + 1, m);
+        const float comp = compensate_[i] * compensate_[i];
+        for (size_t j = i + 1; j < m; ++j) {
+            decay_[j] = std::min(decay_[j], std::exp(-sigma * (iou_[j] * iou_[j] - comp)));
+        }
+    }
+
+    auto& survivors = survivors_;
+    survivors.clear();
+    for (size_t k = 0; k < m; ++k) {
+        scores_[k] *= decay_[k];
+        if (scores_[k] >= config_.score_threshold) {
+            survivors.push_back(k);
+        }
+    }
+    std::stable_sort(survivors.begin(), survivors.end(), [this](size_t lhs, size_t rhs) {
+        return scores_[lhs] > scores_[rhs];
+    });
+    if (config_.max_detections > 0 && survivors.size() > static_cast<size_t>(config_.max_detections)) {
+        survivors.resize(static_cast<size_t>(config_.max_detections));
+    }
+
+    keep.reserve(survivors.size());
+    for (size_t k : survivors) {
+        boxes.score[order_[k]] = scores_[k];
+        keep.push_back(order_[k]);
+    }
+}
+
+} // namespace va::analyzer
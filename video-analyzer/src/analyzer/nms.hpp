@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace va::analyzer {
+
+enum class NmsMethod {
+    Hard,
+    Soft,    // Gaussian Soft-NMS: overlapping boxes are down-weighted, not removed
+    Matrix   // Matrix NMS: one parallel decay pass instead of a sequential sweep
+};
+
+NmsMethod parseNmsMethod(const std::string& value);
+const char* nmsMethodName(NmsMethod method);
+
+struct NmsConfig {
+    NmsMethod method {NmsMethod::Hard};
+    float iou_threshold {0.45f};
+    // Highest-scoring candidates kept before suppression; 0 keeps all.
+    int top_k {1000};
+    // Upper bound on returned detections; 0 means unlimited.
+    int max_detections {300};
+    // When false boxes only suppress boxes of their own class.
+    bool class_agnostic {false};
+    float soft_sigma {0.5f};
+    float matrix_sigma {2.0f};
+    // Soft/Matrix NMS drop boxes whose decayed score falls below this.
+    float score_threshold {0.0f};
+};
+
+// Structure-of-arrays candidate list so IoU rows can be evaluated with SIMD.
+struct BoxSoA {
+    std::vector<float> x1;
+    std::vector<float> y1;
+    std::vector<float> x2;
+    std::vector<float> y2;
+    std::vector<float> score;
+    std::vector<int> cls;
+
+    size_t size() const { return score.size(); }
+    bool empty() const { return score.empty(); }
+    void clear();
+    void reserve(size_t count);
+    void push(float bx1, float by1, float bx2, float by2, float box_score, int box_cls);
+};
+
+// Class-aware batched NMS. Boxes of different classes are shifted apart by a
+// per-class coordinate offset so one suppression pass handles every class.
+// Scratch buffers are kept between calls; an engine must not be shared across
+// threads.
+class NmsEngine {
+public:
+    explicit NmsEngine(NmsConfig config = {});
+
+    void setConfig(const NmsConfig& config) { config_ = config; }
+    const NmsConfig& config() const { return config_; }
+
+    // Fills `keep` with indices into `boxes` in descending score order. Soft
+    // and Matrix NMS write the decayed scores back into boxes.score.
+    void run(BoxSoA& boxes, std::vector<int>& keep);
+
+private:
+    void selectCandidates(const BoxSoA& boxes);
+    void runHard(std::vector<int>& keep);
+    void runSoft(BoxSoA& boxes, std::vector<int>& keep);
+    void runMatrix(BoxSoA& boxes, std::vector<int>& keep);
+    // iou_[j] = IoU(candidate i, candidate j) for j in [begin, end), or 0
+    // when the two belong to different classes.
+    void iouRow(size_t i, size_t begin, size_t end);
+
+    NmsConfig config_;
+    std::vector<int> order_;
+    std::vector<float> x1_;
+    std::vector<float> y1_;
+    std::vector<float> x2_;
+    std::vector<float> y2_;
+    std::vector<float> area_;
+    std::vector<int32_t> cls_;  // all 0 when class_agnostic
+    std::vector<float> scores_;
+    std::vector<float> iou_;
+    std::vector<float> compensate_;
+    std::vector<float> decay_;
+    std::vector<size_t> survivors_;
+    std::vector<uint8_t> suppressed_;
+};
+
+} // namespace va::analyzer
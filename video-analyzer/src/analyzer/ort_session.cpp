@@ -1,9 +1,9 @@
 #include "analyzer/ort_session.hpp"
 
 #include "core/logger.hpp"
+#include "core/utils.hpp"
 
 #include <algorithm>
-#include <cctype>
 #include <cstddef>
 #include <mutex>
 #include <numeric>
@@ -35,13 +35,6 @@ namespace va::analyzer {
 #ifdef USE_ONNXRUNTIME
 
 namespace {
-inline std::string toLower(std::string value) {
-    std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) {
-        return static_cast<char>(std::tolower(c));
-    });
-    return value;
-}
-
 #if VA_HAS_CUDA_RUNTIME
 inline void releaseCudaBuffer(void*& pointer, size_t& capacity_bytes) {
     if (pointer) {
@@ -100,6 +93,7 @@ struct OrtModelSession::Impl {
     bool io_binding_enabled {false};
     bool device_binding_active {false};
     bool cpu_fallback {false};
+    bool dynamic_batch {false};
 };
 
 OrtModelSession::OrtModelSession() = default;
@@ -133,13 +127,13 @@ bool OrtModelSession::loadModel(const std::string& model_path, bool use_gpu) {
 
     impl_->session_options = std::make_unique<Ort::SessionOptions>();
     impl_->session_options->SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
-    impl_->session_options->SetIntraOpNumThreads(1);
+    impl_->session_options->SetIntraOpNumThreads(std::max(1, impl_->options.intra_op_threads));
 
     if (impl_->options.enable_profiling) {
         impl_->session_options->EnableProfiling(L"ort_profile_");
     }
 
-    std::string provider = toLower(impl_->options.provider);
+    std::string provider = core::toLower(impl_->options.provider);
     if (provider == "ort-trt" || provider == "ort_tensor_rt" || provider == "ort-tensorrt") {
         provider = "tensorrt";
     } else if (provider == "ort-cuda" || provider == "ort-gpu") {
@@ -298,6 +292,12 @@ bool OrtModelSession::loadModel(const std::string& model_path, bool use_gpu) {
         impl_->output_names.emplace_back(impl_->output_names_storage.back().c_str());
     }
 
+    impl_->dynamic_batch = false;
+    if (input_count > 0) {
+        const auto input_shape = impl_->session->GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape();
+        impl_->dynamic_batch = !input_shape.empty() && input_shape.front() < 0;
+    }
+
     impl_->resolved_provider = provider_appended ? provider : std::string{"cpu"};
     impl_->cpu_fallback = gpu_requested && !provider_appended;
 
@@ -518,6 +518,14 @@ OrtModelSession::RuntimeInfo OrtModelSession::runtimeInfo() const {
     return info;
 }
 
+bool OrtModelSession::supportsDynamicBatch() const {
+    if (!impl_) {
+        return false;
+    }
+    std::scoped_lock lock(impl_->mutex);
+    return impl_->dynamic_batch;
+}
+
 #else // USE_ONNXRUNTIME
 
 struct OrtModelSession::Impl {};
@@ -535,6 +543,14 @@ bool OrtModelSession::run(const core::TensorView&, std::vector<core::TensorView>
     return loaded_;
 }
 
+OrtModelSession::RuntimeInfo OrtModelSession::runtimeInfo() const {
+    return {};
+}
+
+bool OrtModelSession::supportsDynamicBatch() const {
+    return false;
+}
+
 #endif // USE_ONNXRUNTIME
 
 } // namespace va::analyzer
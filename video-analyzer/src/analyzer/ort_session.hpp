@@ -26,6 +26,7 @@ public:
         int tensorrt_min_subgraph_size {0};
         size_t io_binding_input_bytes {0};
         size_t io_binding_output_bytes {0};
+        int intra_op_threads {1};
     };
 
     void setOptions(const Options& options);
@@ -46,6 +47,8 @@ public:
     bool run(const core::TensorView& input, std::vector<core::TensorView>& outputs) override;
 
     RuntimeInfo runtimeInfo() const;
+    // True when the model's first input has a symbolic batch dimension.
+    bool supportsDynamicBatch() const;
 
 private:
     struct Impl;
@@ -1,12 +1,209 @@
 #include "analyzer/postproc_detr.hpp"
 
+#include "core/utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+
 namespace va::analyzer {
 
-bool DetrPostprocessor::run(const std::vector<core::TensorView>& /*raw_outputs*/,
-                            const core::LetterboxMeta& /*meta*/,
+namespace {
+
+float sigmoid(float v) {
+    return 1.0f / (1.0f + std::exp(-v));
+}
+
+float clamp(float v, float lo, float hi) {
+    return std::max(lo, std::min(v, hi));
+}
+
+} // namespace
+
+ScoreActivation parseScoreActivation(const std::string& value) {
+    const std::string lower = core::toLower(value);
+    if (lower == "softmax") {
+        return ScoreActivation::Softmax;
+    }
+    if (lower == "none" || lower == "identity") {
+        return ScoreActivation::None;
+    }
+    return ScoreActivation::Sigmoid;
+}
+
+const char* scoreActivationName(ScoreActivation activation) {
+    switch (activation) {
+    case ScoreActivation::Softmax:
+        return "softmax";
+    case ScoreActivation::None:
+        return "none";
+    case ScoreActivation::Sigmoid:
+    default:
+        return "sigmoid";
+    }
+}
+
+BoxUnits parseBoxUnits(const std::string& value) {
+    const std::string lower = core::toLower(value);
+    if (lower == "pixels" || lower == "pixel") {
+        return BoxUnits::Pixels;
+    }
+    return BoxUnits::Normalized;
+}
+
+const char* boxUnitsName(BoxUnits units) {
+    return units == BoxUnits::Pixels ? "pixels" : "normalized";
+}
+
+DetrPostprocessor::DetrPostprocessor()
+    : DetrPostprocessor(Options{}) {}
+
+DetrPostprocessor::DetrPostprocessor(Options options)
+    : options_(options) {}
+
+bool DetrPostprocessor::run(const std::vector<core::TensorView>& raw_outputs,
+                            const core::LetterboxMeta& meta,
+                            const AnalyzerParams& params,
                             core::ModelOutput& output) {
     output.boxes.clear();
     output.masks.clear();
+    output.track_ids.clear();
+
+    auto valid = [](const core::TensorView& t) {
+        return t.data && t.shape.size() == 3 && t.shape[0] == 1 && t.shape[1] > 0 && t.shape[2] > 0;
+    };
+
+    // Resolve boxes/logits pointers and their row strides.
+    const float* boxes = nullptr;
+    const float* logits = nullptr;
+    int64_t num_queries = 0;
+    int64_t box_stride = 0;
+    int64_t logit_stride = 0;
+    int64_t num_logits = 0;
+    if (raw_outputs.size() >= 2 && valid(raw_outputs[0]) && valid(raw_outputs[1])) {
+        const bool boxes_first = raw_outputs[0].shape[2] == 4 && raw_outputs[1].shape[2] != 4;
+        const core::TensorView& box_view = raw_outputs[boxes_first ? 0 : 1];
+        const core::TensorView& logit_view = raw_outputs[boxes_first ? 1 : 0];
+        if (box_view.shape[2] != 4 || box_view.shape[1] != logit_view.shape[1]) {
+            return false;
+        }
+        boxes = static_cast<const float*>(box_view.data);
+        logits = static_cast<const float*>(logit_view.data);
+        num_queries = box_view.shape[1];
+        box_stride = 4;
+        logit_stride = logit_view.shape[2];
+        num_logits = logit_view.shape[2];
+    } else if (!raw_outputs.empty() && valid(raw_outputs[0]) && raw_outputs[0].shape[2] > 4) {
+        const core::TensorView& view = raw_outputs[0];
+        boxes = static_cast<const float*>(view.data);
+        logits = boxes + 4;
+        num_queries = view.shape[1];
+        box_stride = view.shape[2];
+        logit_stride = view.shape[2];
+        num_logits = view.shape[2] - 4;
+    } else {
+        return false;
+    }
+
+    // Softmax heads reserve their last logit for "no object".
+    const bool softmax = options_.activation == ScoreActivation::Softmax;
+    const int num_classes = static_cast<int>(softmax ? num_logits - 1 : num_logits);
+    if (num_classes < 1) {
+        return false;
+    }
+
+    allowed_classes_.assign(static_cast<size_t>(num_classes), params.class_whitelist.empty() ? 1 : 0);
+    for (int cls : params.class_whitelist) {
+        if (cls >= 0 && cls < num_classes) {
+            allowed_classes_[static_cast<size_t>(cls)] = 1;
+        }
+    }
+
+    // Sigmoid is monotonic, so candidates are filtered on raw logits and only
+    // the final top-K pay for the exp().
+    const float conf = clamp(params.confidence_threshold, 0.0f, 1.0f - 1e-6f);
+    const float logit_threshold = conf > 0.0f ? std::log(conf / (1.0f - conf)) : -INFINITY;
+
+    candidates_.clear();
+    for (int64_t q = 0; q < num_queries; ++q) {
+        const float* row = logits + q * logit_stride;
+        switch (options_.activation) {
+        case ScoreActivation::Softmax: {
+            const float peak = *std::max_element(row, row + num_logits);
+            float denom = 0.0f;
+            for (int64_t c = 0; c < num_logits; ++c) {
+                denom += std::exp(row[c] - peak);
+            }
+            int best = -1;
+            for (int c = 0; c < num_classes; ++c) {
+                if (allowed_classes_[static_cast<size_t>(c)] && (best < 0 || row[c] > row[best])) {
+                    best = c;
+                }
+            }
+            if (best >= 0) {
+                const float score = std::exp(row[best] - peak) / denom;
+                if (score >= conf) {
+                    candidates_.push_back({score, static_cast<int32_t>(q), best});
+                }
+            }
+            break;
+        }
+        case ScoreActivation::Sigmoid:
+        case ScoreActivation::None: {
+            const float threshold = options_.activation == ScoreActivation::Sigmoid ? logit_threshold : conf;
+            for (int c = 0; c < num_classes; ++c) {
+                if (row[c] >= threshold && allowed_classes_[static_cast<size_t>(c)]) {
+                    candidates_.push_back({row[c], static_cast<int32_t>(q), c});
+                }
+            }
+            break;
+        }
+        }
+    }
+
+    if (candidates_.empty()) {
+        return true;
+    }
+
+    const int limit = params.max_detections > 0 ? params.max_detections : options_.max_detections;
+    auto by_score = [](const Candidate& lhs, const Candidate& rhs) { return lhs.score > rhs.score; };
+    if (limit > 0 && candidates_.size() > static_cast<size_t>(limit)) {
+        std::nth_element(candidates_.begin(), candidates_.begin() + limit, candidates_.end(), by_score);
+        candidates_.resize(static_cast<size_t>(limit));
+    }
+    std::sort(candidates_.begin(), candidates_.end(), by_score);
+
+    const bool normalized = options_.box_units == BoxUnits::Normalized;
+    const float input_w = normalized ? static_cast<float>(meta.input_width) : 1.0f;
+    const float input_h = normalized ? static_cast<float>(meta.input_height) : 1.0f;
+
+    const float scale = meta.scale == 0.0f ? 1.0f : meta.scale;
+    const float pad_x = static_cast<float>(meta.pad_x);
+    const float pad_y = static_cast<float>(meta.pad_y);
+    const float max_w = meta.original_width > 0 ? static_cast<float>(meta.original_width) : static_cast<float>(meta.input_width);
+    const float max_h = meta.original_height > 0 ? static_cast<float>(meta.original_height) : static_cast<float>(meta.input_height);
+    const float max_x = std::max(0.0f, max_w - 1.0f);
+    const float max_y = std::max(0.0f, max_h - 1.0f);
+
+    output.boxes.reserve(candidates_.size());
+    for (const auto& cand : candidates_) {
+        const float* b = boxes + cand.query * box_stride;
+        const float cx = b[0] * input_w;
+        const float cy = b[1] * input_h;
+        const float w = b[2] * input_w;
+        const float h = b[3] * input_h;
+
+        core::Box box;
+        box.x1 = clamp((cx - w * 0.5f - pad_x) / scale, 0.0f, max_x);
+        box.y1 = clamp((cy - h * 0.5f - pad_y) / scale, 0.0f, max_y);
+        box.x2 = clamp((cx + w * 0.5f - pad_x) / scale, 0.0f, max_x);
+        box.y2 = clamp((cy + h * 0.5f - pad_y) / scale, 0.0f, max_y);
+        if (box.x2 <= box.x1 || box.y2 <= box.y1) {
+            continue;
+        }
+        box.score = options_.activation == ScoreActivation::Sigmoid ? sigmoid(cand.score) : cand.score;
+        box.cls = cand.cls;
+        output.boxes.emplace_back(box);
+    }
     return true;
 }
 
@@ -2,13 +2,66 @@
 
 #include "analyzer/interfaces.hpp"
 
+#include <cstdint>
+#include <string>
+#include <vector>
+
 namespace va::analyzer {
 
+// How raw class outputs turn into scores.
+enum class ScoreActivation {
+    Sigmoid,  // independent per-class logits (RT-DETR, Deformable DETR)
+    Softmax,  // per-query softmax whose last class is "no object" (DETR)
+    None      // exports that already emit probabilities (Ultralytics RT-DETR)
+};
+
+ScoreActivation parseScoreActivation(const std::string& value);
+const char* scoreActivationName(ScoreActivation activation);
+
+// Scale of the exported cxcywh boxes.
+enum class BoxUnits {
+    Normalized,  // fractions of the model input (DETR, RT-DETR, Ultralytics exports)
+    Pixels       // model input pixels
+};
+
+BoxUnits parseBoxUnits(const std::string& value);
+const char* boxUnitsName(BoxUnits units);
+
+// Set-prediction heads (DETR, RT-DETR) emit one box per query and are trained
+// not to produce duplicates, so decoding is a partial top-K over the query
+// scores with no NMS. Accepted layouts:
+//   one output   [1, Q, 4 + C]              boxes then class scores
+//   two outputs  [1, Q, C] and [1, Q, 4]    logits and boxes, either order
+// Boxes are cxcywh, normalised to the model input or in its pixels as
+// Options::box_units says.
 class DetrPostprocessor : public IPostprocessor {
 public:
+    struct Options {
+        ScoreActivation activation {ScoreActivation::Sigmoid};
+        BoxUnits box_units {BoxUnits::Normalized};
+        // Upper bound on returned detections; AnalyzerParams::max_detections
+        // overrides it when set.
+        int max_detections {300};
+    };
+
+    DetrPostprocessor();
+    explicit DetrPostprocessor(Options options);
+
     bool run(const std::vector<core::TensorView>& raw_outputs,
              const core::LetterboxMeta& meta,
+             const AnalyzerParams& params,
              core::ModelOutput& output) override;
+
+private:
+    struct Candidate {
+        float score;
+        int32_t query;
+        int32_t cls;
+    };
+
+    Options options_;
+    std::vector<Candidate> candidates_;
+    std::vector<uint8_t> allowed_classes_;
 };
 
 } // namespace va::analyzer
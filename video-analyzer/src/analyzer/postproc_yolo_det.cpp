@@ -1,179 +1,378 @@
 #include "analyzer/postproc_yolo_det.hpp"
 
+#include "core/simd.hpp"
+#include "core/utils.hpp"
+
 #include <algorithm>
 #include <cmath>
-#include <functional>
-#include <numeric>
 #include <vector>
 
 namespace {
 
-constexpr float kScoreThreshold = 0.25f;
-constexpr float kNMSThreshold = 0.45f;
-
 float clamp(float v, float lo, float hi) {
     return std::max(lo, std::min(v, hi));
 }
 
-float iou(const va::core::Box& a, const va::core::Box& b) {
-    const float x1 = std::max(a.x1, b.x1);
-    const float y1 = std::max(a.y1, b.y1);
-    const float x2 = std::min(a.x2, b.x2);
-    const float y2 = std::min(a.y2, b.y2);
-
-    const float w = std::max(0.0f, x2 - x1);
-    const float h = std::max(0.0f, y2 - y1);
-    const float inter = w * h;
-    const float union_area = (a.x2 - a.x1) * (a.y2 - a.y1) + (b.x2 - b.x1) * (b.y2 - b.y1) - inter;
-    if (union_area <= 0.0f) {
-        return 0.0f;
+#if defined(VA_SIMD_AVX2)
+// Maximum of scores[0, n) for the largest n that is a multiple of 8; returns n.
+VA_TARGET_AVX2 int maxScoreAvx2(const float* scores, int count, float& best) {
+    if (count < 8) {
+        return 0;
+    }
+    __m256 acc = _mm256_loadu_ps(scores);
+    int i = 8;
+    for (; i + 8 <= count; i += 8) {
+        acc = _mm256_max_ps(acc, _mm256_loadu_ps(scores + i));
     }
-    return inter / union_area;
+    __m128 m = _mm_max_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+    m = _mm_max_ss(m, _mm_shuffle_ps(m, m, 0x1));
+    best = _mm_cvtss_f32(m);
+    return i;
 }
+#endif
 
-void nonMaxSuppression(std::vector<va::core::Box>& boxes) {
-    std::vector<size_t> order(boxes.size());
-    std::iota(order.begin(), order.end(), 0);
-    std::sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) {
-        return boxes[lhs].score > boxes[rhs].score;
-    });
-
-    std::vector<bool> suppressed(boxes.size(), false);
-    std::vector<va::core::Box> result;
-    for (size_t i = 0; i < order.size(); ++i) {
-        const size_t idx = order[i];
-        if (suppressed[idx]) {
-            continue;
-        }
-        const va::core::Box& candidate = boxes[idx];
-        result.push_back(candidate);
-        for (size_t j = i + 1; j < order.size(); ++j) {
-            const size_t idx2 = order[j];
-            if (suppressed[idx2]) {
-                continue;
-            }
-            if (candidate.cls != boxes[idx2].cls) {
-                continue;
-            }
-            if (iou(candidate, boxes[idx2]) > kNMSThreshold) {
-                suppressed[idx2] = true;
-            }
-        }
+#if defined(VA_SIMD_SSE41)
+VA_TARGET_SSE41 int maxScoreSse41(const float* scores, int count, float& best) {
+    if (count < 4) {
+        return 0;
     }
-
-    boxes.swap(result);
+    __m128 acc = _mm_loadu_ps(scores);
+    int i = 4;
+    for (; i + 4 <= count; i += 4) {
+        acc = _mm_max_ps(acc, _mm_loadu_ps(scores + i));
+    }
+    acc = _mm_max_ps(acc, _mm_movehl_ps(acc, acc));
+    acc = _mm_max_ss(acc, _mm_shuffle_ps(acc, acc, 0x1));
+    best = _mm_cvtss_f32(acc);
+    return i;
+}
+#endif
+
+#if defined(VA_SIMD_AVX2)
+// Class maximum of anchors [i, i + 8) of a channels-first head. Returns the
+// mask of lanes at or above threshold; lane_max is written when it is not 0.
+VA_TARGET_AVX2 int blockMaxAvx2(const float* scores, int64_t num_det, const int* classes, size_t class_count,
+                                int64_t i, float threshold, float* lane_max) {
+    __m256 acc = _mm256_loadu_ps(scores + classes[0] * num_det + i);
+    for (size_t k = 1; k < class_count; ++k) {
+        acc = _mm256_max_ps(acc, _mm256_loadu_ps(scores + classes[k] * num_det + i));
+    }
+    const int mask = _mm256_movemask_ps(_mm256_cmp_ps(acc, _mm256_set1_ps(threshold), _CMP_GE_OQ));
+    if (mask != 0) {
+        _mm256_storeu_ps(lane_max, acc);
+    }
+    return mask;
+}
+#endif
+
+#if defined(VA_SIMD_SSE41)
+// Same for anchors [i, i + 4).
+VA_TARGET_SSE41 int blockMaxSse41(const float* scores, int64_t num_det, const int* classes, size_t class_count,
+                                  int64_t i, float threshold, float* lane_max) {
+    __m128 acc = _mm_loadu_ps(scores + classes[0] * num_det + i);
+    for (size_t k = 1; k < class_count; ++k) {
+        acc = _mm_max_ps(acc, _mm_loadu_ps(scores + classes[k] * num_det + i));
+    }
+    const int mask = _mm_movemask_ps(_mm_cmpge_ps(acc, _mm_set1_ps(threshold)));
+    if (mask != 0) {
+        _mm_storeu_ps(lane_max, acc);
+    }
+    return mask;
+}
+#endif
+
+// Largest of count contiguous scores.
+float maxScore(const float* scores, int count) {
+    int i = 0;
+    float best = -INFINITY;
+#if defined(VA_SIMD_AVX2)
+    if (va::core::simd::hasAvx2()) {
+        i = maxScoreAvx2(scores, count, best);
+    }
+#endif
+#if defined(VA_SIMD_SSE41)
+    if (i == 0 && va::core::simd::hasSse41()) {
+        i = maxScoreSse41(scores, count, best);
+    }
+#endif
+    for (; i < count; ++i) {
+        best = std::max(best, scores[i]);
+    }
+    return best;
 }
 
 } // namespace
 
 namespace va::analyzer {
 
-bool YoloDetectionPostprocessor::run(const std::vector<core::TensorView>& raw_outputs,
-                                     const core::LetterboxMeta& meta,
-                                     core::ModelOutput& output) {
-    output.boxes.clear();
-    output.masks.clear();
-
-    if (raw_outputs.empty()) {
-        return false;
-    }
-
-    const core::TensorView& tensor = raw_outputs.front();
-    if (!tensor.data || tensor.shape.size() < 3) {
-        return false;
-    }
-
-    const float* data = static_cast<const float*>(tensor.data);
-    int64_t dim0 = tensor.shape[0];
-    int64_t dim1 = tensor.shape[1];
-    int64_t dim2 = tensor.shape[2];
-
-    if (dim0 != 1) {
-        return false;
-    }
+YoloDetectionPostprocessor::DecodeMode YoloDetectionPostprocessor::parseDecodeMode(const std::string& value) {
+    const std::string lower = core::toLower(value);
+    return lower == "scalar" ? DecodeMode::Scalar : DecodeMode::Simd;
+}
 
-    int64_t num_det = 0;
-    int64_t num_attrs = 0;
-    bool channels_first = false; // indicates layout [C, N]
+YoloDetectionPostprocessor::BoxMapper::BoxMapper(const core::LetterboxMeta& meta)
+    : pad_x(static_cast<float>(meta.pad_x)),
+      pad_y(static_cast<float>(meta.pad_y)),
+      scale(meta.scale == 0.0f ? 1.0f : meta.scale) {
+    const float max_w = meta.original_width > 0 ? static_cast<float>(meta.original_width) : static_cast<float>(meta.input_width);
+    const float max_h = meta.original_height > 0 ? static_cast<float>(meta.original_height) : static_cast<float>(meta.input_height);
+    max_x = std::max(0.0f, max_w - 1.0f);
+    max_y = std::max(0.0f, max_h - 1.0f);
+}
 
-    if (dim1 <= dim2) {
-        num_det = dim1;
-        num_attrs = dim2;
-    } else {
-        num_det = dim2;
-        num_attrs = dim1;
-        channels_first = true;
+bool YoloDetectionPostprocessor::BoxMapper::push(BoxSoA& boxes,
+                                                 float cx, float cy, float w, float h,
+                                                 float score, int cls) const {
+    const float bx1 = clamp((cx - w * 0.5f - pad_x) / scale, 0.0f, max_x);
+    const float by1 = clamp((cy - h * 0.5f - pad_y) / scale, 0.0f, max_y);
+    const float bx2 = clamp((cx + w * 0.5f - pad_x) / scale, 0.0f, max_x);
+    const float by2 = clamp((cy + h * 0.5f - pad_y) / scale, 0.0f, max_y);
+    if (bx2 > bx1 && by2 > by1) {
+        boxes.push(bx1, by1, bx2, by2, score, cls);
+        return true;
     }
+    return false;
+}
 
-    if (num_attrs < 5) {
+bool YoloDetectionPostprocessor::headLayout(const core::TensorView& head, int extra_attrs, HeadLayout& layout) {
+    if (!head.data || head.shape.size() < 3 || head.shape[0] != 1) {
         return false;
     }
 
-    const int num_classes = static_cast<int>(num_attrs - 4);
-    const float scale = meta.scale == 0.0f ? 1.0f : meta.scale;
-
-    std::vector<core::Box> boxes;
-    boxes.reserve(static_cast<size_t>(num_det));
+    // Detection heads always have far more anchors than attributes, so the
+    // smaller axis holds the box + class attributes: [1, 8400, 84] is
+    // row-major (YOLOv5 style), [1, 84, 8400] is channels-first (YOLOv8+).
+    const int64_t dim1 = head.shape[1];
+    const int64_t dim2 = head.shape[2];
+    layout.channels_first = dim1 < dim2;
+    layout.num_det = layout.channels_first ? dim2 : dim1;
+    layout.num_attrs = layout.channels_first ? dim1 : dim2;
+    layout.num_classes = static_cast<int>(layout.num_attrs - 4 - extra_attrs);
+    return layout.num_det > 0 && extra_attrs >= 0 && layout.num_classes >= 1;
+}
 
+YoloDetectionPostprocessor::YoloDetectionPostprocessor(NmsConfig nms, DecodeMode decode_mode)
+    : base_nms_(nms), nms_(nms), decode_mode_(decode_mode) {}
+
+// Reference decoder: one pass over every class score of every anchor. Kept for
+// benchmarking and as a fallback (`postprocess.decode: scalar`).
+void YoloDetectionPostprocessor::decodeScalar(const float* data,
+                                              const HeadLayout& layout,
+                                              float threshold,
+                                              const BoxMapper& mapper) {
+    const int64_t num_det = layout.num_det;
+    const int64_t num_attrs = layout.num_attrs;
     for (int64_t i = 0; i < num_det; ++i) {
         auto value_at = [&](int64_t attr) -> float {
-            if (channels_first) {
+            if (layout.channels_first) {
                 return data[attr * num_det + i];
             }
             return data[i * num_attrs + attr];
         };
 
-        const float cx = value_at(0);
-        const float cy = value_at(1);
-        const float w = value_at(2);
-        const float h = value_at(3);
-
-        float best_score = 0.0f;
+        // Filtered classes and sub-threshold scores never become candidates.
+        float best_score = threshold;
         int best_class = -1;
-        for (int cls = 0; cls < num_classes; ++cls) {
+        for (int cls = 0; cls < layout.num_classes; ++cls) {
             const float cls_score = value_at(4 + cls);
-            if (cls_score > best_score) {
+            if (cls_score >= best_score && allowed_classes_[static_cast<size_t>(cls)]
+                && (best_class < 0 || cls_score > best_score)) {
                 best_score = cls_score;
                 best_class = cls;
             }
         }
 
-        if (best_class < 0 || best_score < kScoreThreshold) {
+        if (best_class >= 0
+            && mapper.push(candidates_, value_at(0), value_at(1), value_at(2), value_at(3), best_score, best_class)) {
+            anchors_.push_back(i);
+        }
+    }
+}
+
+// [N, 4 + C]: each anchor's class scores are contiguous. A SIMD max decides
+// whether the anchor can pass at all; only survivors pay for the argmax and
+// the box read.
+void YoloDetectionPostprocessor::decodeRowMajor(const float* data,
+                                                const HeadLayout& layout,
+                                                float threshold,
+                                                const BoxMapper& mapper) {
+    const int num_classes = layout.num_classes;
+    const bool all_classes = allowed_list_.size() == static_cast<size_t>(num_classes);
+    for (int64_t i = 0; i < layout.num_det; ++i) {
+        const float* row = data + i * layout.num_attrs;
+        const float* scores = row + 4;
+        const float top = maxScore(scores, num_classes);
+        if (top < threshold) {
             continue;
         }
 
-        const float x1 = cx - w * 0.5f;
-        const float y1 = cy - h * 0.5f;
-        const float x2 = cx + w * 0.5f;
-        const float y2 = cy + h * 0.5f;
+        float best_score = threshold;
+        int best_class = -1;
+        if (all_classes) {
+            best_score = top;
+            best_class = static_cast<int>(std::find(scores, scores + num_classes, best_score) - scores);
+        } else {
+            for (int cls : allowed_list_) {
+                if (scores[cls] >= best_score && (best_class < 0 || scores[cls] > best_score)) {
+                    best_score = scores[cls];
+                    best_class = cls;
+                }
+            }
+        }
+        if (best_class >= 0 && mapper.push(candidates_, row[0], row[1], row[2], row[3], best_score, best_class)) {
+            anchors_.push_back(i);
+        }
+    }
+}
 
-        const float orig_x1 = (x1 - static_cast<float>(meta.pad_x)) / scale;
-        const float orig_y1 = (y1 - static_cast<float>(meta.pad_y)) / scale;
-        const float orig_x2 = (x2 - static_cast<float>(meta.pad_x)) / scale;
-        const float orig_y2 = (y2 - static_cast<float>(meta.pad_y)) / scale;
+// [4 + C, N]: class scores for neighbouring anchors are contiguous, so the
+// class block is reduced column-wise, eight (or four) anchors per vector.
+// Blocks where no lane reaches the threshold are skipped before any box
+// coordinate is loaded.
+void YoloDetectionPostprocessor::decodeChannelsFirst(const float* data,
+                                                     const HeadLayout& layout,
+                                                     float threshold,
+                                                     const BoxMapper& mapper) {
+    const int64_t num_det = layout.num_det;
+    const float* scores = data + 4 * num_det;
+    const int* classes = allowed_list_.data();
+    const size_t class_count = allowed_list_.size();
+
+    auto emit = [&](int64_t i, float best_score) {
+        int best_class = classes[0];
+        for (size_t k = 0; k < class_count; ++k) {
+            if (scores[classes[k] * num_det + i] == best_score) {
+                best_class = classes[k];
+                break;
+            }
+        }
+        if (mapper.push(candidates_,
+                        data[i], data[num_det + i], data[2 * num_det + i], data[3 * num_det + i],
+                        best_score, best_class)) {
+            anchors_.push_back(i);
+        }
+    };
 
-        const float max_w = meta.original_width > 0 ? static_cast<float>(meta.original_width) : static_cast<float>(meta.input_width);
-        const float max_h = meta.original_height > 0 ? static_cast<float>(meta.original_height) : static_cast<float>(meta.input_height);
+    float lane_max[8];
+    auto emit_lanes = [&](int64_t base, int mask, int lanes) {
+        for (int lane = 0; lane < lanes; ++lane) {
+            if (mask & (1 << lane)) {
+                emit(base + lane, lane_max[lane]);
+            }
+        }
+    };
+
+    int64_t i = 0;
+#if defined(VA_SIMD_AVX2)
+    if (core::simd::hasAvx2()) {
+        for (; i + 8 <= num_det; i += 8) {
+            if (const int mask = blockMaxAvx2(scores, num_det, classes, class_count, i, threshold, lane_max)) {
+                emit_lanes(i, mask, 8);
+            }
+        }
+    }
+#endif
+#if defined(VA_SIMD_SSE41)
+    if (core::simd::hasSse41()) {
+        for (; i + 4 <= num_det; i += 4) {
+            if (const int mask = blockMaxSse41(scores, num_det, classes, class_count, i, threshold, lane_max)) {
+                emit_lanes(i, mask, 4);
+            }
+        }
+    }
+#endif
+    for (; i < num_det; ++i) {
+        float best = scores[classes[0] * num_det + i];
+        for (size_t k = 1; k < class_count; ++k) {
+            best = std::max(best, scores[classes[k] * num_det + i]);
+        }
+        if (best >= threshold) {
+            emit(i, best);
+        }
+    }
+}
 
-        core::Box box;
-        box.x1 = clamp(orig_x1, 0.0f, std::max(0.0f, max_w - 1.0f));
-        box.y1 = clamp(orig_y1, 0.0f, std::max(0.0f, max_h - 1.0f));
-        box.x2 = clamp(orig_x2, 0.0f, std::max(0.0f, max_w - 1.0f));
-        box.y2 = clamp(orig_y2, 0.0f, std::max(0.0f, max_h - 1.0f));
-        box.score = best_score;
-        box.cls = best_class;
-
-        if (box.x2 > box.x1 && box.y2 > box.y1) {
-            boxes.emplace_back(box);
+bool YoloDetectionPostprocessor::run(const std::vector<core::TensorView>& raw_outputs,
+                                     const core::LetterboxMeta& meta,
+                                     const AnalyzerParams& params,
+                                     core::ModelOutput& output) {
+    output.boxes.clear();
+    output.masks.clear();
+    output.track_ids.clear();
+
+    if (raw_outputs.empty()) {
+        return false;
+    }
+    return decodeHead(raw_outputs.front(), 0, meta, params, output);
+}
+
+bool YoloDetectionPostprocessor::decodeHead(const core::TensorView& head,
+                                            int extra_attrs,
+                                            const core::LetterboxMeta& meta,
+                                            const AnalyzerParams& params,
+                                            core::ModelOutput& output) {
+    kept_anchors_.clear();
+
+    HeadLayout layout;
+    if (!headLayout(head, extra_attrs, layout)) {
+        return false;
+    }
+
+    const float* data = static_cast<const float*>(head.data);
+    const int num_classes = layout.num_classes;
+    const float score_threshold = std::max(params.confidence_threshold, 0.0f);
+    allowed_classes_.assign(static_cast<size_t>(num_classes), params.class_whitelist.empty() ? 1 : 0);
+    for (int cls : params.class_whitelist) {
+        if (cls >= 0 && cls < num_classes) {
+            allowed_classes_[static_cast<size_t>(cls)] = 1;
+        }
+    }
+    allowed_list_.clear();
+    for (int cls = 0; cls < num_classes; ++cls) {
+        if (allowed_classes_[static_cast<size_t>(cls)]) {
+            allowed_list_.push_back(cls);
         }
     }
 
-    if (boxes.empty()) {
+    candidates_.clear();
+    anchors_.clear();
+    if (allowed_list_.empty()) {
+        return true;
+    }
+
+    const BoxMapper mapper(meta);
+    if (decode_mode_ == DecodeMode::Scalar) {
+        decodeScalar(data, layout, score_threshold, mapper);
+    } else if (layout.channels_first) {
+        decodeChannelsFirst(data, layout, score_threshold, mapper);
+    } else {
+        decodeRowMajor(data, layout, score_threshold, mapper);
+    }
+
+    if (candidates_.empty()) {
         return true;
     }
 
-    nonMaxSuppression(boxes);
-    output.boxes = std::move(boxes);
+    NmsConfig nms = nms_.config();
+    nms.iou_threshold = params.iou_threshold > 0.0f ? params.iou_threshold : base_nms_.iou_threshold;
+    nms.max_detections = params.max_detections > 0 ? params.max_detections : base_nms_.max_detections;
+    nms.score_threshold = score_threshold;
+    nms_.setConfig(nms);
+    nms_.run(candidates_, keep_);
+    output.boxes.reserve(keep_.size());
+    kept_anchors_.reserve(keep_.size());
+    for (int idx : keep_) {
+        core::Box box;
+        box.x1 = candidates_.x1[idx];
+        box.y1 = candidates_.y1[idx];
+        box.x2 = candidates_.x2[idx];
+        box.y2 = candidates_.y2[idx];
+        box.score = candidates_.score[idx];
+        box.cls = candidates_.cls[idx];
+        output.boxes.emplace_back(box);
+        kept_anchors_.push_back(anchors_[static_cast<size_t>(idx)]);
+    }
     return true;
 }
 
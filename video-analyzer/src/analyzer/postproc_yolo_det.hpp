@@ -1,14 +1,83 @@
 #pragma once
 
 #include "analyzer/interfaces.hpp"
+#include "analyzer/nms.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
 
 namespace va::analyzer {
 
 class YoloDetectionPostprocessor : public IPostprocessor {
 public:
+    // Simd reduces each anchor's class scores with vector max and drops
+    // sub-threshold anchors before reading their box; Scalar is the original
+    // element-by-element decoder, kept for comparison.
+    enum class DecodeMode {
+        Simd,
+        Scalar
+    };
+
+    static DecodeMode parseDecodeMode(const std::string& value);
+
+    // Shape of a [1, N, 4 + C + extra] or [1, 4 + C + extra, N] head.
+    struct HeadLayout {
+        bool channels_first {false};
+        int64_t num_det {0};
+        int64_t num_attrs {0};
+        int num_classes {0};
+    };
+
+    // `extra_attrs` trailing attributes per anchor (e.g. mask coefficients)
+    // are not class scores.
+    static bool headLayout(const core::TensorView& head, int extra_attrs, HeadLayout& layout);
+
+    explicit YoloDetectionPostprocessor(NmsConfig nms = {}, DecodeMode decode_mode = DecodeMode::Simd);
+
     bool run(const std::vector<core::TensorView>& raw_outputs,
              const core::LetterboxMeta& meta,
+             const AnalyzerParams& params,
              core::ModelOutput& output) override;
+
+    // Decodes and suppresses one head into output.boxes (appended in score
+    // order). Used by run() and by heads that carry extra attributes.
+    bool decodeHead(const core::TensorView& head,
+                    int extra_attrs,
+                    const core::LetterboxMeta& meta,
+                    const AnalyzerParams& params,
+                    core::ModelOutput& output);
+
+    // Source anchor of each box from the last decodeHead(), index-aligned
+    // with the boxes it produced.
+    const std::vector<int64_t>& keptAnchors() const { return kept_anchors_; }
+
+private:
+    // Letterbox-to-frame coordinate mapping, fixed for one run() call.
+    struct BoxMapper {
+        explicit BoxMapper(const core::LetterboxMeta& meta);
+        bool push(BoxSoA& boxes, float cx, float cy, float w, float h, float score, int cls) const;
+
+        float pad_x;
+        float pad_y;
+        float scale;
+        float max_x {0.0f};
+        float max_y {0.0f};
+    };
+
+    void decodeScalar(const float* data, const HeadLayout& layout, float threshold, const BoxMapper& mapper);
+    void decodeRowMajor(const float* data, const HeadLayout& layout, float threshold, const BoxMapper& mapper);
+    void decodeChannelsFirst(const float* data, const HeadLayout& layout, float threshold, const BoxMapper& mapper);
+
+    const NmsConfig base_nms_;
+    NmsEngine nms_;
+    BoxSoA candidates_;
+    std::vector<int> keep_;
+    std::vector<int64_t> anchors_;
+    std::vector<int64_t> kept_anchors_;
+    DecodeMode decode_mode_;
+    std::vector<uint8_t> allowed_classes_;
+    std::vector<int> allowed_list_;
 };
 
 } // namespace va::analyzer
@@ -1,12 +1,172 @@
 #include "analyzer/postproc_yolo_seg.hpp"
 
+#include "core/simd.hpp"
+
+#include <algorithm>
+#include <cmath>
+
 namespace va::analyzer {
 
-bool YoloSegmentationPostprocessor::run(const std::vector<core::TensorView>& /*raw_outputs*/,
-                                        const core::LetterboxMeta& /*meta*/,
+namespace {
+
+#if defined(VA_SIMD_AVX2)
+// dst[x] += a * src[x] eight at a time; returns where the tail starts.
+VA_TARGET_AVX2 int accumulateRowAvx2(float a, const float* src, float* dst, int count) {
+    const __m256 va8 = _mm256_set1_ps(a);
+    int x = 0;
+    for (; x + 8 <= count; x += 8) {
+        _mm256_storeu_ps(dst + x, _mm256_fmadd_ps(va8, _mm256_loadu_ps(src + x), _mm256_loadu_ps(dst + x)));
+    }
+    return x;
+}
+#endif
+
+#if defined(VA_SIMD_SSE41)
+VA_TARGET_SSE41 int accumulateRowSse41(float a, const float* src, float* dst, int x, int count) {
+    const __m128 va4 = _mm_set1_ps(a);
+    for (; x + 4 <= count; x += 4) {
+        _mm_storeu_ps(dst + x, _mm_add_ps(_mm_loadu_ps(dst + x), _mm_mul_ps(va4, _mm_loadu_ps(src + x))));
+    }
+    return x;
+}
+#endif
+
+// dst[x] += a * src[x]
+void accumulateRow(float a, const float* src, float* dst, int count) {
+    int x = 0;
+#if defined(VA_SIMD_AVX2)
+    if (core::simd::hasAvx2()) {
+        x = accumulateRowAvx2(a, src, dst, count);
+    }
+#endif
+#if defined(VA_SIMD_SSE41)
+    if (core::simd::hasSse41()) {
+        x = accumulateRowSse41(a, src, dst, x, count);
+    }
+#endif
+    for (; x < count; ++x) {
+        dst[x] += a * src[x];
+    }
+}
+
+} // namespace
+
+YoloSegmentationPostprocessor::YoloSegmentationPostprocessor(NmsConfig nms,
+                                                             YoloDetectionPostprocessor::DecodeMode decode_mode)
+    : detector_(nms, decode_mode) {}
+
+bool YoloSegmentationPostprocessor::run(const std::vector<core::TensorView>& raw_outputs,
+                                        const core::LetterboxMeta& meta,
+                                        const AnalyzerParams& params,
                                         core::ModelOutput& output) {
     output.boxes.clear();
     output.masks.clear();
+    output.track_ids.clear();
+
+    const core::TensorView* head = nullptr;
+    const core::TensorView* protos = nullptr;
+    for (const auto& tensor : raw_outputs) {
+        if (tensor.shape.size() == 4 && !protos) {
+            protos = &tensor;
+        } else if (tensor.shape.size() == 3 && !head) {
+            head = &tensor;
+        }
+    }
+    if (!head || !protos || !protos->data || protos->shape[0] != 1) {
+        return false;
+    }
+    if (meta.input_width <= 0 || meta.input_height <= 0) {
+        return false;
+    }
+
+    const int num_masks = static_cast<int>(protos->shape[1]);
+    const int proto_h = static_cast<int>(protos->shape[2]);
+    const int proto_w = static_cast<int>(protos->shape[3]);
+    if (num_masks <= 0 || proto_h <= 0 || proto_w <= 0) {
+        return false;
+    }
+
+    if (!detector_.decodeHead(*head, num_masks, meta, params, output)) {
+        return false;
+    }
+    if (output.boxes.empty()) {
+        return true;
+    }
+
+    YoloDetectionPostprocessor::HeadLayout layout;
+    YoloDetectionPostprocessor::headLayout(*head, num_masks, layout);
+    const float* head_data = static_cast<const float*>(head->data);
+    const float* proto_data = static_cast<const float*>(protos->data);
+    const size_t plane = static_cast<size_t>(proto_h) * static_cast<size_t>(proto_w);
+    const int64_t coeff_attr = 4 + layout.num_classes;
+
+    // sigmoid(v) > t  <=>  v > logit(t): the sigmoid is never evaluated.
+    const float threshold = std::clamp(params.mask_threshold, 1e-6f, 1.0f - 1e-6f);
+    const float logit = std::log(threshold / (1.0f - threshold));
+
+    // Frame -> prototype grid: frame * scale + pad lands in model input
+    // pixels, which the prototypes cover at proto_w / input_width.
+    const float scale = meta.scale == 0.0f ? 1.0f : meta.scale;
+    const float to_proto_x = static_cast<float>(proto_w) / static_cast<float>(meta.input_width);
+    const float to_proto_y = static_cast<float>(proto_h) / static_cast<float>(meta.input_height);
+    const float pad_x = static_cast<float>(meta.pad_x);
+    const float pad_y = static_cast<float>(meta.pad_y);
+
+    const auto& anchors = detector_.keptAnchors();
+    output.masks.resize(output.boxes.size());
+    coeffs_.resize(static_cast<size_t>(num_masks));
+
+    for (size_t k = 0; k < output.boxes.size(); ++k) {
+        const core::Box& box = output.boxes[k];
+        const int64_t anchor = anchors[k];
+        for (int m = 0; m < num_masks; ++m) {
+            const int64_t attr = coeff_attr + m;
+            coeffs_[static_cast<size_t>(m)] = layout.channels_first
+                ? head_data[attr * layout.num_det + anchor]
+                : head_data[anchor * layout.num_attrs + attr];
+        }
+
+        const float px1 = (box.x1 * scale + pad_x) * to_proto_x;
+        const float py1 = (box.y1 * scale + pad_y) * to_proto_y;
+        const float px2 = (box.x2 * scale + pad_x) * to_proto_x;
+        const float py2 = (box.y2 * scale + pad_y) * to_proto_y;
+        const int x0 = std::clamp(static_cast<int>(std::floor(px1)), 0, proto_w);
+        const int y0 = std::clamp(static_cast<int>(std::floor(py1)), 0, proto_h);
+        const int x1 = std::clamp(static_cast<int>(std::ceil(px2)), 0, proto_w);
+        const int y1 = std::clamp(static_cast<int>(std::ceil(py2)), 0, proto_h);
+        if (x1 <= x0 || y1 <= y0) {
+            continue;
+        }
+
+        core::SegmentMask& mask = output.masks[k];
+        mask.width = x1 - x0;
+        mask.height = y1 - y0;
+        mask.cell_width = 1.0f / (to_proto_x * scale);
+        mask.cell_height = 1.0f / (to_proto_y * scale);
+        mask.origin_x = (static_cast<float>(x0) / to_proto_x - pad_x) / scale;
+        mask.origin_y = (static_cast<float>(y0) / to_proto_y - pad_y) / scale;
+        mask.bits.assign(static_cast<size_t>(mask.stride()) * static_cast<size_t>(mask.height), 0);
+
+        row_.resize(static_cast<size_t>(mask.width));
+        for (int y = y0; y < y1; ++y) {
+            // Cells whose centre falls outside the box are cropped away.
+            const float cy = static_cast<float>(y) + 0.5f;
+            if (cy < py1 || cy > py2) {
+                continue;
+            }
+            std::fill(row_.begin(), row_.end(), 0.0f);
+            const float* proto_row = proto_data + static_cast<size_t>(y) * proto_w + x0;
+            for (int m = 0; m < num_masks; ++m) {
+                accumulateRow(coeffs_[static_cast<size_t>(m)], proto_row + m * plane, row_.data(), mask.width);
+            }
+            for (int x = 0; x < mask.width; ++x) {
+                const float cx = static_cast<float>(x0 + x) + 0.5f;
+                if (row_[static_cast<size_t>(x)] > logit && cx >= px1 && cx <= px2) {
+                    mask.set(x, y - y0);
+                }
+            }
+        }
+    }
     return true;
 }
 
@@ -1,14 +1,31 @@
 #pragma once
 
 #include "analyzer/interfaces.hpp"
+#include "analyzer/postproc_yolo_det.hpp"
+
+#include <vector>
 
 namespace va::analyzer {
 
+// YOLO instance segmentation: a detection head whose anchors carry mask
+// coefficients, plus a [1, nm, ph, pw] prototype tensor. Boxes are decoded
+// and suppressed by the detection decoder; masks are then evaluated only for
+// the surviving boxes and only over the prototype cells inside each box.
 class YoloSegmentationPostprocessor : public IPostprocessor {
 public:
+    explicit YoloSegmentationPostprocessor(
+        NmsConfig nms = {},
+        YoloDetectionPostprocessor::DecodeMode decode_mode = YoloDetectionPostprocessor::DecodeMode::Simd);
+
     bool run(const std::vector<core::TensorView>& raw_outputs,
              const core::LetterboxMeta& meta,
+             const AnalyzerParams& params,
              core::ModelOutput& output) override;
+
+private:
+    YoloDetectionPostprocessor detector_;
+    std::vector<float> coeffs_;
+    std::vector<float> row_;
 };
 
 } // namespace va::analyzer
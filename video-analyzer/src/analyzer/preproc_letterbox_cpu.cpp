@@ -1,15 +1,223 @@
 #include "analyzer/preproc_letterbox_cpu.hpp"
 
+#include "core/color_convert.hpp"
+#include "core/simd.hpp"
+#include "core/utils.hpp"
+
+#include <algorithm>
+#include <cmath>
 #include <cstring>
-#include <opencv2/imgproc.hpp>
+#include <opencv2/core.hpp>
 
 namespace va::analyzer {
 
+namespace {
+
+constexpr float kPadValue = 114.0f / 255.0f;
+constexpr float kNormalize = 1.0f / 255.0f;
+
+// Horizontal taps of one resized row: output channel c of column x blends
+// source bytes x0[x] + channel[c] and x1[x] + channel[c] by fx[x].
+struct RowTaps {
+    const int* x0;
+    const int* x1;
+    const float* fx;
+    int width;
+    int vector_end;  // vector loads read four bytes per tap, so they stop before the last source pixel
+    int channel[3];
+};
+
+#if defined(VA_SIMD_AVX2)
+// Eight columns per step, each tap one 32-bit gather covering B, G, R and the
+// next byte. Writes rows of taps.width floats per channel; returns where the
+// tail starts.
+VA_TARGET_AVX2 int interpolateRowAvx2(const uint8_t* row, const RowTaps& taps, float* dst) {
+    const int* base = reinterpret_cast<const int*>(row);
+    const __m256i byte_mask = _mm256_set1_epi32(0xFF);
+    int x = 0;
+    for (; x + 8 <= taps.vector_end; x += 8) {
+        const __m256i left = _mm256_i32gather_epi32(base, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(taps.x0 + x)), 1);
+        const __m256i right = _mm256_i32gather_epi32(base, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(taps.x1 + x)), 1);
+        const __m256 fx = _mm256_loadu_ps(taps.fx + x);
+        for (int c = 0; c < 3; ++c) {
+            const __m128i shift = _mm_cvtsi32_si128(taps.channel[c] * 8);
+            const __m256 p0 = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srl_epi32(left, shift), byte_mask));
+            const __m256 p1 = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srl_epi32(right, shift), byte_mask));
+            _mm256_storeu_ps(dst + c * taps.width + x, _mm256_fmadd_ps(fx, _mm256_sub_ps(p1, p0), p0));
+        }
+    }
+    return x;
+}
+#endif
+
+#if defined(VA_SIMD_SSE41)
+VA_TARGET_SSE41 inline __m128i loadTaps4(const uint8_t* row, const int* offsets) {
+    int v[4];
+    for (int k = 0; k < 4; ++k) {
+        std::memcpy(&v[k], row + offsets[k], sizeof(int));
+    }
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(v));
+}
+
+VA_TARGET_SSE41 int interpolateRowSse41(const uint8_t* row, const RowTaps& taps, float* dst, int x) {
+    const __m128i byte_mask = _mm_set1_epi32(0xFF);
+    for (; x + 4 <= taps.vector_end; x += 4) {
+        const __m128i left = loadTaps4(row, taps.x0 + x);
+        const __m128i right = loadTaps4(row, taps.x1 + x);
+        const __m128 fx = _mm_loadu_ps(taps.fx + x);
+        for (int c = 0; c < 3; ++c) {
+            const __m128i shift = _mm_cvtsi32_si128(taps.channel[c] * 8);
+            const __m128 p0 = _mm_cvtepi32_ps(_mm_and_si128(_mm_srl_epi32(left, shift), byte_mask));
+            const __m128 p1 = _mm_cvtepi32_ps(_mm_and_si128(_mm_srl_epi32(right, shift), byte_mask));
+            _mm_storeu_ps(dst + c * taps.width + x, _mm_add_ps(p0, _mm_mul_ps(fx, _mm_sub_ps(p1, p0))));
+        }
+    }
+    return x;
+}
+#endif
+
+void interpolateRow(const uint8_t* row, const RowTaps& taps, float* dst) {
+    int x = 0;
+#if defined(VA_SIMD_AVX2)
+    if (core::simd::hasAvx2()) {
+        x = interpolateRowAvx2(row, taps, dst);
+    }
+#endif
+#if defined(VA_SIMD_SSE41)
+    if (core::simd::hasSse41()) {
+        x = interpolateRowSse41(row, taps, dst, x);
+    }
+#endif
+    for (; x < taps.width; ++x) {
+        const int a = taps.x0[x];
+        const int b = taps.x1[x];
+        const float fx = taps.fx[x];
+        for (int c = 0; c < 3; ++c) {
+            const float p0 = row[a + taps.channel[c]];
+            dst[c * taps.width + x] = p0 + fx * (static_cast<float>(row[b + taps.channel[c]]) - p0);
+        }
+    }
+}
+
+#if defined(VA_SIMD_AVX2)
+// dst[x] = (top[x] + fy * (bottom[x] - top[x])) * scale, eight at a time.
+VA_TARGET_AVX2 int blendRowsAvx2(const float* top, const float* bottom, float fy, float scale, float* dst, int count) {
+    const __m256 vfy8 = _mm256_set1_ps(fy);
+    const __m256 vscale8 = _mm256_set1_ps(scale);
+    int x = 0;
+    for (; x + 8 <= count; x += 8) {
+        const __m256 t = _mm256_loadu_ps(top + x);
+        const __m256 b = _mm256_loadu_ps(bottom + x);
+        const __m256 v = _mm256_fmadd_ps(vfy8, _mm256_sub_ps(b, t), t);
+        _mm256_storeu_ps(dst + x, _mm256_mul_ps(v, vscale8));
+    }
+    return x;
+}
+#endif
+
+#if defined(VA_SIMD_SSE41)
+VA_TARGET_SSE41 int blendRowsSse41(const float* top, const float* bottom, float fy, float scale, float* dst,
+                                   int x, int count) {
+    const __m128 vfy4 = _mm_set1_ps(fy);
+    const __m128 vscale4 = _mm_set1_ps(scale);
+    for (; x + 4 <= count; x += 4) {
+        const __m128 t = _mm_loadu_ps(top + x);
+        const __m128 b = _mm_loadu_ps(bottom + x);
+        const __m128 v = _mm_add_ps(t, _mm_mul_ps(vfy4, _mm_sub_ps(b, t)));
+        _mm_storeu_ps(dst + x, _mm_mul_ps(v, vscale4));
+    }
+    return x;
+}
+#endif
+
+// dst[x] = (top[x] + fy * (bottom[x] - top[x])) * scale
+void blendRows(const float* top, const float* bottom, float fy, float scale, float* dst, int count) {
+    int x = 0;
+#if defined(VA_SIMD_AVX2)
+    if (core::simd::hasAvx2()) {
+        x = blendRowsAvx2(top, bottom, fy, scale, dst, count);
+    }
+#endif
+#if defined(VA_SIMD_SSE41)
+    if (core::simd::hasSse41()) {
+        x = blendRowsSse41(top, bottom, fy, scale, dst, x, count);
+    }
+#endif
+    for (; x < count; ++x) {
+        dst[x] = (top[x] + fy * (bottom[x] - top[x])) * scale;
+    }
+}
+
+void fillValue(float* dst, int count, float value) {
+    std::fill(dst, dst + count, value);
+}
+
+} // namespace
+
+ChannelOrder parseChannelOrder(const std::string& value) {
+    const std::string lower = core::toLower(value);
+    return lower == "bgr" ? ChannelOrder::BGR : ChannelOrder::RGB;
+}
+
 LetterboxPreprocessorCPU::LetterboxPreprocessorCPU(int input_width, int input_height)
-    : input_width_(input_width), input_height_(input_height) {}
+    : LetterboxPreprocessorCPU(input_width, input_height, Options{}) {}
+
+LetterboxPreprocessorCPU::LetterboxPreprocessorCPU(int input_width, int input_height, Options options)
+    : input_width_(input_width), input_height_(input_height), options_(options) {}
 
 bool LetterboxPreprocessorCPU::run(const core::Frame& in, core::TensorView& out, core::LetterboxMeta& meta) {
-    if (in.width <= 0 || in.height <= 0 || in.bgr.empty()) {
+    return runInto(in, buffer_, out, meta);
+}
+
+void LetterboxPreprocessorCPU::updateColumnMap(int src_width, int dst_width) {
+    if (columns_.src_width == src_width && columns_.dst_width == dst_width) {
+        return;
+    }
+    columns_.src_width = src_width;
+    columns_.dst_width = dst_width;
+    columns_.x0.resize(dst_width);
+    columns_.x1.resize(dst_width);
+    columns_.fx.resize(dst_width);
+
+    // Same pixel-centre mapping as cv::resize(INTER_LINEAR).
+    const float inv_scale = static_cast<float>(src_width) / static_cast<float>(dst_width);
+    for (int x = 0; x < dst_width; ++x) {
+        float sx = (static_cast<float>(x) + 0.5f) * inv_scale - 0.5f;
+        sx = std::max(sx, 0.0f);
+        int x0 = static_cast<int>(sx);
+        float fx = sx - static_cast<float>(x0);
+        if (x0 >= src_width - 1) {
+            x0 = src_width - 1;
+            fx = 0.0f;
+        }
+        const int x1 = std::min(x0 + 1, src_width - 1);
+        columns_.x0[x] = x0 * 3;
+        columns_.x1[x] = x1 * 3;
+        columns_.fx[x] = fx;
+    }
+    // Offsets only grow, so the first column whose right tap is the last
+    // source pixel ends the vector loads.
+    columns_.vector_end = dst_width;
+    for (int x = 0; x < dst_width; ++x) {
+        if (columns_.x1[x] + 4 > src_width * 3) {
+            columns_.vector_end = x;
+            break;
+        }
+    }
+}
+
+bool LetterboxPreprocessorCPU::runInto(const core::Frame& in,
+                                       std::vector<float>& storage,
+                                       core::TensorView& out,
+                                       core::LetterboxMeta& meta) {
+    if (in.format != core::PixelFormat::Bgr24) {
+        core::Frame converted = in;
+        if (!core::ensureBgr(converted)) {
+            return false;
+        }
+        return runInto(converted, storage, out, meta);
+    }
+    if (in.width <= 0 || in.height <= 0 || in.pixels.size() < static_cast<size_t>(in.width) * in.height * 3) {
         return false;
     }
 
@@ -21,41 +229,91 @@ bool LetterboxPreprocessorCPU::run(const core::Frame& in, core::TensorView& out,
     meta.original_width = in.width;
     meta.original_height = in.height;
 
-    cv::Mat src(in.height, in.width, CV_8UC3, const_cast<uint8_t*>(in.bgr.data()));
-
     const float scale = std::min(static_cast<float>(target_w) / static_cast<float>(in.width),
                                  static_cast<float>(target_h) / static_cast<float>(in.height));
-    const int resized_w = static_cast<int>(std::round(in.width * scale));
-    const int resized_h = static_cast<int>(std::round(in.height * scale));
-    const int pad_w = target_w - resized_w;
-    const int pad_h = target_h - resized_h;
-    const int pad_left = pad_w / 2;
-    const int pad_top = pad_h / 2;
+    const int resized_w = std::clamp(static_cast<int>(std::round(in.width * scale)), 1, target_w);
+    const int resized_h = std::clamp(static_cast<int>(std::round(in.height * scale)), 1, target_h);
+    const int pad_left = (target_w - resized_w) / 2;
+    const int pad_top = (target_h - resized_h) / 2;
 
     meta.scale = scale;
     meta.pad_x = pad_left;
     meta.pad_y = pad_top;
 
-    cv::Mat resized;
-    cv::resize(src, resized, cv::Size(resized_w, resized_h));
+    updateColumnMap(in.width, resized_w);
 
-    cv::Mat letterboxed(target_h, target_w, CV_8UC3, cv::Scalar(114, 114, 114));
-    resized.copyTo(letterboxed(cv::Rect(pad_left, pad_top, resized_w, resized_h)));
+    const size_t plane_size = static_cast<size_t>(target_w) * static_cast<size_t>(target_h);
+    storage.resize(plane_size * 3);
 
-    cv::Mat letterboxed_float;
-    letterboxed.convertTo(letterboxed_float, CV_32F, 1.0f / 255.0f);
+    // Output plane c reads source channel taps.channel[c] (frames are BGR).
+    const RowTaps taps {
+        columns_.x0.data(), columns_.x1.data(), columns_.fx.data(), resized_w, columns_.vector_end,
+        {options_.channel_order == ChannelOrder::RGB ? 2 : 0, 1, options_.channel_order == ChannelOrder::RGB ? 0 : 2}
+    };
 
-    std::vector<cv::Mat> channels(3);
-    cv::split(letterboxed_float, channels);
+    const uint8_t* src = in.pixels.data();
+    const size_t src_stride = static_cast<size_t>(in.width) * 3;
+    const float inv_scale_y = static_cast<float>(in.height) / static_cast<float>(resized_h);
+    float* planes = storage.data();
 
-    const size_t plane_size = static_cast<size_t>(target_w) * static_cast<size_t>(target_h);
-    buffer_.resize(plane_size * 3);
+    // Each output row: bilinear taps from at most two source rows, a SIMD
+    // horizontal pass into per-channel scratch rows, then one SIMD vertical
+    // blend that also normalises and writes straight into the CHW planes.
+    auto process_rows = [&](const cv::Range& range) {
+        thread_local std::vector<float> scratch;
+        scratch.resize(static_cast<size_t>(resized_w) * 6);
+        float* top = scratch.data();
+        float* bottom = top + static_cast<size_t>(resized_w) * 3;
+
+        for (int dy = range.start; dy < range.end; ++dy) {
+            float* rows[3];
+            for (int c = 0; c < 3; ++c) {
+                rows[c] = planes + c * plane_size + static_cast<size_t>(dy) * target_w;
+            }
+
+            const int ry = dy - pad_top;
+            if (ry < 0 || ry >= resized_h) {
+                for (int c = 0; c < 3; ++c) {
+                    fillValue(rows[c], target_w, kPadValue);
+                }
+                continue;
+            }
+
+            float sy = (static_cast<float>(ry) + 0.5f) * inv_scale_y - 0.5f;
+            sy = std::max(sy, 0.0f);
+            int y0 = static_cast<int>(sy);
+            float fy = sy - static_cast<float>(y0);
+            if (y0 >= in.height - 1) {
+                y0 = in.height - 1;
+                fy = 0.0f;
+            }
+            const int y1 = std::min(y0 + 1, in.height - 1);
+            const uint8_t* row0 = src + static_cast<size_t>(y0) * src_stride;
+            const uint8_t* row1 = src + static_cast<size_t>(y1) * src_stride;
+            const bool need_bottom = fy > 0.0f;
+
+            interpolateRow(row0, taps, top);
+            if (need_bottom) {
+                interpolateRow(row1, taps, bottom);
+            }
+
+            for (int c = 0; c < 3; ++c) {
+                fillValue(rows[c], pad_left, kPadValue);
+                const float* t = top + c * resized_w;
+                blendRows(t, need_bottom ? bottom + c * resized_w : t, fy, kNormalize, rows[c] + pad_left, resized_w);
+                fillValue(rows[c] + pad_left + resized_w, target_w - pad_left - resized_w, kPadValue);
+            }
+        }
+    };
 
-    for (size_t c = 0; c < 3; ++c) {
-        std::memcpy(buffer_.data() + c * plane_size, channels[c].ptr<float>(), plane_size * sizeof(float));
+    if (options_.threads == 1) {
+        process_rows(cv::Range(0, target_h));
+    } else {
+        cv::parallel_for_(cv::Range(0, target_h), process_rows,
+                          options_.threads > 1 ? static_cast<double>(options_.threads) : -1.0);
     }
 
-    out.data = buffer_.data();
+    out.data = storage.data();
     out.shape = {1, 3, target_h, target_w};
     out.dtype = core::DType::F32;
     out.on_gpu = false;
@@ -2,20 +2,54 @@
 
 #include "analyzer/interfaces.hpp"
 
+#include <string>
 #include <vector>
 
 namespace va::analyzer {
 
+enum class ChannelOrder {
+    RGB,
+    BGR
+};
+
+ChannelOrder parseChannelOrder(const std::string& value);
+
 class LetterboxPreprocessorCPU : public IPreprocessor {
 public:
+    struct Options {
+        ChannelOrder channel_order {ChannelOrder::RGB};
+        // Worker stripes for cv::parallel_for_ over output rows; 0 lets OpenCV
+        // decide, 1 keeps the kernel on the calling thread.
+        int threads {0};
+    };
+
     LetterboxPreprocessorCPU(int input_width, int input_height);
+    LetterboxPreprocessorCPU(int input_width, int input_height, Options options);
 
     bool run(const core::Frame& in, core::TensorView& out, core::LetterboxMeta& meta) override;
+    bool runInto(const core::Frame& in,
+                 std::vector<float>& storage,
+                 core::TensorView& out,
+                 core::LetterboxMeta& meta) override;
 
 private:
+    // Horizontal sampling table for one (source width, resized width) pair.
+    struct ColumnMap {
+        int src_width {0};
+        int dst_width {0};
+        std::vector<int> x0;  // byte offset of the left tap
+        std::vector<int> x1;  // byte offset of the right tap
+        std::vector<float> fx;
+        int vector_end {0};   // first column whose taps must not be read four bytes wide
+    };
+
+    void updateColumnMap(int src_width, int dst_width);
+
     int input_width_;
     int input_height_;
+    Options options_;
     std::vector<float> buffer_;
+    ColumnMap columns_;
 };
 
 } // namespace va::analyzer
@@ -7,13 +7,16 @@ LetterboxPreprocessorCUDA::LetterboxPreprocessorCUDA(int input_width, int input_
 
 bool LetterboxPreprocessorCUDA::run(const core::Frame& in, core::TensorView& out, core::LetterboxMeta& meta) {
     // Placeholder: fallback to CPU semantics until CUDA kernels are implemented
+    if (in.format != core::PixelFormat::Bgr24) {
+        return false;
+    }
     meta.scale = 1.0f;
     meta.pad_x = 0;
     meta.pad_y = 0;
     meta.input_width = input_width_;
     meta.input_height = input_height_;
 
-    out.data = const_cast<uint8_t*>(in.bgr.data());
+    out.data = const_cast<uint8_t*>(in.pixels.data());
     out.shape = {1, 3, in.height, in.width};
     out.dtype = core::DType::U8;
     out.on_gpu = true;
@@ -0,0 +1,230 @@
+#include "analyzer/renderer_overlay.hpp"
+
+#include "analyzer/class_names.hpp"
+#include "core/color_convert.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+namespace va::analyzer {
+
+namespace {
+
+// BGR palette, indexed by class id.
+constexpr uint8_t kPalette[][3] = {
+    {56, 56, 255},  {151, 157, 255}, {31, 112, 255}, {29, 178, 255},  {49, 210, 207},
+    {10, 249, 72},  {23, 204, 146},  {134, 219, 61}, {52, 147, 26},   {187, 212, 0},
+    {168, 153, 44}, {255, 194, 0},   {147, 69, 52},  {255, 115, 100}, {236, 24, 0},
+    {255, 56, 132}, {133, 0, 82},    {255, 56, 203}, {200, 149, 255}, {199, 55, 255}
+};
+constexpr size_t kPaletteSize = sizeof(kPalette) / sizeof(kPalette[0]);
+constexpr int kLabelPadding = 2;
+
+const uint8_t* classColour(int cls) {
+    return kPalette[static_cast<size_t>(std::max(cls, 0)) % kPaletteSize];
+}
+
+void fillRect(uint8_t* pixels, size_t stride, int x0, int y0, int x1, int y1, const uint8_t* colour) {
+    for (int y = y0; y < y1; ++y) {
+        uint8_t* p = pixels + static_cast<size_t>(y) * stride + static_cast<size_t>(x0) * 3;
+        for (int x = x0; x < x1; ++x, p += 3) {
+            p[0] = colour[0];
+            p[1] = colour[1];
+            p[2] = colour[2];
+        }
+    }
+}
+
+} // namespace
+
+OverlayRenderer::OverlayRenderer()
+    : OverlayRenderer(Options{}) {}
+
+OverlayRenderer::OverlayRenderer(Options options)
+    : options_(options) {
+    options_.thickness = std::max(options_.thickness, 1);
+    options_.mask_alpha = std::clamp(options_.mask_alpha, 0.0f, 1.0f);
+    if (options_.labels) {
+        buildAtlas();
+    }
+}
+
+void OverlayRenderer::buildAtlas() {
+    const int font = cv::FONT_HERSHEY_SIMPLEX;
+    int max_height = 0;
+    int max_baseline = 0;
+    int total_width = 0;
+    for (int i = 0; i < GlyphAtlas::kCount; ++i) {
+        int baseline = 0;
+        const std::string glyph(1, static_cast<char>(GlyphAtlas::kFirst + i));
+        const cv::Size size = cv::getTextSize(glyph, font, options_.font_scale, 1, &baseline);
+        atlas_.offset[i] = total_width;
+        atlas_.advance[i] = size.width;
+        total_width += size.width;
+        max_height = std::max(max_height, size.height);
+        max_baseline = std::max(max_baseline, baseline);
+    }
+
+    atlas_.width = total_width;
+    atlas_.height = max_height + max_baseline + 1;
+    atlas_.coverage.assign(static_cast<size_t>(atlas_.width) * atlas_.height, 0);
+    cv::Mat strip(atlas_.height, atlas_.width, CV_8UC1, atlas_.coverage.data());
+    for (int i = 0; i < GlyphAtlas::kCount; ++i) {
+        const std::string glyph(1, static_cast<char>(GlyphAtlas::kFirst + i));
+        cv::putText(strip, glyph, cv::Point(atlas_.offset[i], max_height), font, options_.font_scale,
+                    cv::Scalar(255), 1, cv::LINE_AA);
+    }
+}
+
+int OverlayRenderer::textWidth(const std::string& text) const {
+    int width = 0;
+    for (unsigned char c : text) {
+        const int index = static_cast<int>(c) - GlyphAtlas::kFirst;
+        if (index >= 0 && index < GlyphAtlas::kCount) {
+            width += atlas_.advance[index];
+        }
+    }
+    return width;
+}
+
+// White text, alpha-blended by glyph coverage; (x, y) is the top-left corner.
+void OverlayRenderer::drawText(const Canvas& canvas, int x, int y, const std::string& text) const {
+    for (unsigned char c : text) {
+        const int index = static_cast<int>(c) - GlyphAtlas::kFirst;
+        if (index < 0 || index >= GlyphAtlas::kCount) {
+            continue;
+        }
+        const int gx0 = std::max(0, -x);
+        const int gx1 = std::min(atlas_.advance[index], canvas.width - x);
+        for (int gy = std::max(0, -y); gy < atlas_.height && y + gy < canvas.height; ++gy) {
+            const uint8_t* cov = atlas_.coverage.data() + static_cast<size_t>(gy) * atlas_.width + atlas_.offset[index];
+            uint8_t* p = canvas.pixels + static_cast<size_t>(y + gy) * canvas.stride;
+            for (int gx = gx0; gx < gx1; ++gx) {
+                const int a = cov[gx];
+                if (a == 0) {
+                    continue;
+                }
+                uint8_t* px = p + static_cast<size_t>(x + gx) * 3;
+                for (int ch = 0; ch < 3; ++ch) {
+                    px[ch] = static_cast<uint8_t>(px[ch] + (((255 - px[ch]) * a + 127) / 255));
+                }
+            }
+        }
+        x += atlas_.advance[index];
+    }
+}
+
+void OverlayRenderer::drawLabel(const Canvas& canvas, const core::Box& box, const uint8_t* colour) {
+    const auto& names = cocoClassNames();
+    if (box.cls >= 0 && static_cast<size_t>(box.cls) < names.size()) {
+        text_ = names[static_cast<size_t>(box.cls)];
+    } else {
+        text_ = "cls " + std::to_string(box.cls);
+    }
+    char score[16];
+    std::snprintf(score, sizeof(score), " %.2f", box.score);
+    text_ += score;
+
+    const int label_w = textWidth(text_) + 2 * kLabelPadding;
+    const int label_h = atlas_.height + kLabelPadding;
+    int x0 = std::clamp(static_cast<int>(box.x1), 0, std::max(0, canvas.width - 1));
+    int y0 = static_cast<int>(box.y1) - label_h;
+    if (y0 < 0) {
+        // No room above the box: draw the label just inside its top edge.
+        y0 = std::clamp(static_cast<int>(box.y1), 0, std::max(0, canvas.height - label_h));
+    }
+    const int x1 = std::min(x0 + label_w, canvas.width);
+    const int y1 = std::min(y0 + label_h, canvas.height);
+    fillRect(canvas.pixels, canvas.stride, x0, y0, x1, y1, colour);
+    drawText(canvas, x0 + kLabelPadding, y0 + kLabelPadding / 2, text_);
+}
+
+void OverlayRenderer::blendMask(const Canvas& canvas, const core::SegmentMask& mask, const uint8_t* colour) {
+    if (mask.empty() || mask.cell_width <= 0.0f || mask.cell_height <= 0.0f) {
+        return;
+    }
+    const int x0 = std::max(0, static_cast<int>(std::floor(mask.origin_x)));
+    const int y0 = std::max(0, static_cast<int>(std::floor(mask.origin_y)));
+    const int x1 = std::min(canvas.width, static_cast<int>(std::ceil(mask.origin_x + mask.width * mask.cell_width)));
+    const int y1 = std::min(canvas.height, static_cast<int>(std::ceil(mask.origin_y + mask.height * mask.cell_height)));
+    if (x1 <= x0 || y1 <= y0) {
+        return;
+    }
+
+    // Nearest-cell upsampling: the column -> cell map is shared by every row.
+    cell_columns_.resize(static_cast<size_t>(x1 - x0));
+    for (int x = x0; x < x1; ++x) {
+        const int cx = static_cast<int>((static_cast<float>(x) + 0.5f - mask.origin_x) / mask.cell_width);
+        cell_columns_[static_cast<size_t>(x - x0)] = cx >= 0 && cx < mask.width ? cx : -1;
+    }
+
+    const int alpha = static_cast<int>(std::lround(options_.mask_alpha * 256.0f));
+    const int inv_alpha = 256 - alpha;
+    const int tint[3] = {colour[0] * alpha, colour[1] * alpha, colour[2] * alpha};
+    for (int y = y0; y < y1; ++y) {
+        const int cy = static_cast<int>((static_cast<float>(y) + 0.5f - mask.origin_y) / mask.cell_height);
+        if (cy < 0 || cy >= mask.height) {
+            continue;
+        }
+        uint8_t* p = canvas.pixels + static_cast<size_t>(y) * canvas.stride + static_cast<size_t>(x0) * 3;
+        for (int x = 0; x < x1 - x0; ++x, p += 3) {
+            const int cx = cell_columns_[static_cast<size_t>(x)];
+            if (cx < 0 || !mask.test(cx, cy)) {
+                continue;
+            }
+            p[0] = static_cast<uint8_t>((p[0] * inv_alpha + tint[0]) >> 8);
+            p[1] = static_cast<uint8_t>((p[1] * inv_alpha + tint[1]) >> 8);
+            p[2] = static_cast<uint8_t>((p[2] * inv_alpha + tint[2]) >> 8);
+        }
+    }
+}
+
+bool OverlayRenderer::draw(const core::Frame& in, const core::ModelOutput& output, core::Frame& out) {
+    out = in;
+    return drawInPlace(out, output);
+}
+
+bool OverlayRenderer::drawInPlace(core::Frame& frame, const core::ModelOutput& output) {
+    if (output.boxes.empty()) {
+        return true;
+    }
+    // Only frames that get drawn on leave YUV; the others reach the encoder
+    // without a colour conversion.
+    if (!core::ensureBgr(frame)) {
+        return false;
+    }
+    const size_t stride = static_cast<size_t>(frame.width) * 3;
+    if (frame.width <= 0 || frame.height <= 0 || frame.pixels.size() < stride * static_cast<size_t>(frame.height)) {
+        return false;
+    }
+
+    const Canvas canvas {frame.pixels.makeWritable(), frame.width, frame.height, stride};
+
+    if (options_.mask_alpha > 0.0f) {
+        for (size_t i = 0; i < output.masks.size() && i < output.boxes.size(); ++i) {
+            blendMask(canvas, output.masks[i], classColour(output.boxes[i].cls));
+        }
+    }
+
+    const int t = options_.thickness;
+    for (const auto& box : output.boxes) {
+        const uint8_t* colour = classColour(box.cls);
+        const int x0 = std::clamp(static_cast<int>(box.x1), 0, frame.width - 1);
+        const int y0 = std::clamp(static_cast<int>(box.y1), 0, frame.height - 1);
+        const int x1 = std::clamp(static_cast<int>(box.x2) + 1, x0 + 1, frame.width);
+        const int y1 = std::clamp(static_cast<int>(box.y2) + 1, y0 + 1, frame.height);
+        fillRect(canvas.pixels, stride, x0, y0, x1, std::min(y0 + t, y1), colour);
+        fillRect(canvas.pixels, stride, x0, std::max(y1 - t, y0), x1, y1, colour);
+        fillRect(canvas.pixels, stride, x0, y0, std::min(x0 + t, x1), y1, colour);
+        fillRect(canvas.pixels, stride, std::max(x1 - t, x0), y0, x1, y1, colour);
+        if (options_.labels) {
+            drawLabel(canvas, box, colour);
+        }
+    }
+    return true;
+}
+
+} // namespace va::analyzer
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "analyzer/interfaces.hpp"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace va::analyzer {
+
+// Draws boxes, class labels and instance masks straight into the frame's
+// pooled BGR buffer. Only the pixels under a box outline, a label or a mask's
+// bounding rectangle are touched; the buffer is copied only when another
+// handle still shares it.
+class OverlayRenderer : public IRenderer {
+public:
+    struct Options {
+        int thickness {2};
+        float mask_alpha {0.45f};
+        bool labels {true};
+        double font_scale {0.5};
+    };
+
+    OverlayRenderer();
+    explicit OverlayRenderer(Options options);
+
+    bool draw(const core::Frame& in, const core::ModelOutput& output, core::Frame& out) override;
+    bool drawInPlace(core::Frame& frame, const core::ModelOutput& output) override;
+
+private:
+    // Printable ASCII rasterised once with cv::putText into an 8-bit coverage
+    // strip; labels are composed from it instead of calling putText per frame.
+    struct GlyphAtlas {
+        static constexpr int kFirst = 32;
+        static constexpr int kCount = 95;
+
+        int width {0};
+        int height {0};
+        std::vector<uint8_t> coverage;
+        std::array<int, kCount> offset {};
+        std::array<int, kCount> advance {};
+    };
+
+    struct Canvas {
+        uint8_t* pixels;
+        int width;
+        int height;
+        size_t stride;
+    };
+
+    void buildAtlas();
+    int textWidth(const std::string& text) const;
+    void drawText(const Canvas& canvas, int x, int y, const std::string& text) const;
+    void drawLabel(const Canvas& canvas, const core::Box& box, const uint8_t* colour);
+    void blendMask(const Canvas& canvas, const core::SegmentMask& mask, const uint8_t* colour);
+
+    Options options_;
+    GlyphAtlas atlas_;
+    std::string text_;
+    std::vector<int> cell_columns_;
+};
+
+} // namespace va::analyzer
@@ -7,6 +7,7 @@ namespace va::analyzer {
 class PassthroughRenderer : public IRenderer {
 public:
     bool draw(const core::Frame& in, const core::ModelOutput& /*output*/, core::Frame& out) override;
+    bool drawInPlace(core::Frame& /*frame*/, const core::ModelOutput& /*output*/) override { return true; }
 };
 
 } // namespace va::analyzer
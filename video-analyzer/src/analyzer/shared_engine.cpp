@@ -0,0 +1,286 @@
+#include "analyzer/shared_engine.hpp"
+
+#include "core/logger.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace va::analyzer {
+
+namespace {
+
+size_t elementCount(const std::vector<int64_t>& shape) {
+    if (shape.empty()) {
+        return 0;
+    }
+    return std::accumulate(shape.begin(), shape.end(), static_cast<size_t>(1), [](size_t acc, int64_t dim) {
+        return acc * static_cast<size_t>(std::max<int64_t>(dim, 0));
+    });
+}
+
+// Copies the `index`-th of `count` slices of every output into `storage`.
+bool scatterOutputs(const std::vector<TensorView>& outputs,
+                    size_t index,
+                    size_t count,
+                    std::vector<std::vector<float>>& storage,
+                    std::vector<TensorView>& views) {
+    storage.resize(outputs.size());
+    views.clear();
+    views.reserve(outputs.size());
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        const auto& src = outputs[i];
+        const size_t total = elementCount(src.shape);
+        if (!src.data || total == 0 || total % count != 0) {
+            return false;
+        }
+        const size_t slice = total / count;
+        const float* begin = static_cast<const float*>(src.data) + index * slice;
+        storage[i].assign(begin, begin + slice);
+
+        TensorView view;
+        view.data = storage[i].data();
+        view.shape = src.shape;
+        if (count > 1) {
+            view.shape[0] = 1;
+        }
+        view.dtype = src.dtype;
+        view.on_gpu = false;
+        views.emplace_back(std::move(view));
+    }
+    return true;
+}
+
+} // namespace
+
+SharedInferenceEngine::SharedInferenceEngine(std::shared_ptr<IModelSession> session, bool dynamic_batch, Options options)
+    : session_(std::move(session)),
+      dynamic_batch_(dynamic_batch),
+      options_(options) {
+    options_.max_batch_size = std::max(1, options_.max_batch_size);
+    options_.max_wait_us = std::max(0, options_.max_wait_us);
+    worker_ = std::thread(&SharedInferenceEngine::workerLoop, this);
+}
+
+SharedInferenceEngine::~SharedInferenceEngine() {
+    {
+        std::scoped_lock lock(mutex_);
+        stopping_ = true;
+    }
+    request_cv_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+bool SharedInferenceEngine::infer(const TensorView& input,
+                                  std::vector<std::vector<float>>& storage,
+                                  std::vector<TensorView>& outputs) {
+    if (!session_ || !input.data || input.shape.empty()) {
+        return false;
+    }
+
+    Request request;
+    request.input = &input;
+    request.storage = &storage;
+    request.outputs = &outputs;
+    request.enqueued = std::chrono::steady_clock::now();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (stopping_) {
+        return false;
+    }
+    pending_.push_back(&request);
+    request_cv_.notify_one();
+    done_cv_.wait(lock, [&request]() { return request.done; });
+    return request.ok;
+}
+
+void SharedInferenceEngine::attach() {
+    std::scoped_lock lock(mutex_);
+    sessions_++;
+}
+
+void SharedInferenceEngine::detach() {
+    {
+        std::scoped_lock lock(mutex_);
+        sessions_ = sessions_ > 0 ? sessions_ - 1 : 0;
+    }
+    // A batch waiting for the departed session can run now.
+    request_cv_.notify_all();
+}
+
+SharedInferenceEngine::Stats SharedInferenceEngine::stats() const {
+    std::scoped_lock lock(mutex_);
+    Stats stats;
+    stats.batches = batches_;
+    stats.requests = requests_;
+    stats.avg_batch_size = batches_ > 0 ? static_cast<double>(requests_) / static_cast<double>(batches_) : 0.0;
+    stats.max_batch_size = dynamic_batch_ ? options_.max_batch_size : 1;
+    stats.dynamic_batch = dynamic_batch_;
+    stats.sessions = sessions_;
+    return stats;
+}
+
+void SharedInferenceEngine::workerLoop() {
+    const size_t limit = dynamic_batch_ ? static_cast<size_t>(options_.max_batch_size) : 1;
+    std::vector<Request*> batch;
+    batch.reserve(limit);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        request_cv_.wait(lock, [this]() { return stopping_ || !pending_.empty(); });
+        if (stopping_) {
+            break;
+        }
+
+        // Waiting for more requests than there are sessions only adds latency,
+        // so a model used by one pipeline runs each frame at once.
+        const auto target = [this, limit]() { return std::min(limit, std::max<size_t>(sessions_, 1)); };
+        if (pending_.size() < target() && options_.max_wait_us > 0) {
+            const auto deadline = pending_.front()->enqueued + std::chrono::microseconds(options_.max_wait_us);
+            request_cv_.wait_until(lock, deadline, [this, &target]() {
+                return stopping_ || pending_.size() >= target();
+            });
+            if (stopping_) {
+                break;
+            }
+        }
+
+        takeBatch(batch, limit);
+        batches_++;
+        requests_ += batch.size();
+
+        lock.unlock();
+        runBatch(batch);
+        lock.lock();
+
+        for (auto* request : batch) {
+            request->done = true;
+        }
+        batch.clear();
+        done_cv_.notify_all();
+    }
+
+    for (auto* request : pending_) {
+        request->done = true;
+        request->ok = false;
+    }
+    pending_.clear();
+    done_cv_.notify_all();
+}
+
+void SharedInferenceEngine::takeBatch(std::vector<Request*>& batch, size_t limit) {
+    Request* first = pending_.front();
+    pending_.pop_front();
+    batch.push_back(first);
+    if (limit <= 1 || !batchable(*first->input)) {
+        return;
+    }
+
+    // Only frames with an identical input shape can share a run; anything else
+    // keeps its place in the queue for the next round.
+    for (auto it = pending_.begin(); it != pending_.end() && batch.size() < limit;) {
+        const TensorView& candidate = *(*it)->input;
+        if (batchable(candidate) && candidate.shape == first->input->shape) {
+            batch.push_back(*it);
+            it = pending_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void SharedInferenceEngine::runBatch(const std::vector<Request*>& batch) {
+    if (batch.size() == 1) {
+        runSingle(*batch.front());
+        return;
+    }
+
+    const auto& shape = batch.front()->input->shape;
+    const size_t per_frame = elementCount(shape);
+    batch_input_.resize(per_frame * batch.size());
+    for (size_t i = 0; i < batch.size(); ++i) {
+        std::memcpy(batch_input_.data() + i * per_frame, batch[i]->input->data, per_frame * sizeof(float));
+    }
+
+    TensorView tensor;
+    tensor.data = batch_input_.data();
+    tensor.shape = shape;
+    tensor.shape[0] = static_cast<int64_t>(batch.size());
+    tensor.dtype = core::DType::F32;
+
+    if (!session_->run(tensor, batch_outputs_)) {
+        for (auto* request : batch) {
+            request->ok = false;
+        }
+        return;
+    }
+
+    const bool batched_outputs = !batch_outputs_.empty() && std::all_of(batch_outputs_.begin(), batch_outputs_.end(), [&batch](const TensorView& out) {
+        return !out.shape.empty() && out.shape[0] == static_cast<int64_t>(batch.size());
+    });
+    if (!batched_outputs) {
+        VA_LOG_WARN() << "[SharedEngine] model outputs are not batched, running " << batch.size() << " frames individually";
+        for (auto* request : batch) {
+            runSingle(*request);
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < batch.size(); ++i) {
+        batch[i]->ok = scatterOutputs(batch_outputs_, i, batch.size(), *batch[i]->storage, *batch[i]->outputs);
+    }
+}
+
+void SharedInferenceEngine::runSingle(Request& request) {
+    request.ok = session_->run(*request.input, batch_outputs_)
+        && scatterOutputs(batch_outputs_, 0, 1, *request.storage, *request.outputs);
+}
+
+bool SharedInferenceEngine::batchable(const TensorView& input) {
+    return !input.on_gpu && input.dtype == core::DType::F32 && input.shape.size() >= 2 && input.shape[0] == 1;
+}
+
+SharedModelSession::SharedModelSession(EngineResolver resolver)
+    : resolver_(std::move(resolver)) {}
+
+SharedModelSession::~SharedModelSession() {
+    if (engine_) {
+        engine_->detach();
+    }
+}
+
+bool SharedModelSession::loadModel(const std::string& model_path, bool use_gpu) {
+    if (!resolver_) {
+        return false;
+    }
+    auto engine = resolver_(model_path, use_gpu);
+    if (!engine) {
+        return false;
+    }
+    std::scoped_lock lock(mutex_);
+    if (engine != engine_) {
+        engine->attach();
+        if (engine_) {
+            engine_->detach();
+        }
+        engine_ = std::move(engine);
+    }
+    return true;
+}
+
+bool SharedModelSession::run(const TensorView& input, std::vector<TensorView>& outputs) {
+    std::scoped_lock lock(mutex_);
+    if (!engine_) {
+        return false;
+    }
+    return engine_->infer(input, output_storage_, outputs);
+}
+
+std::shared_ptr<SharedInferenceEngine> SharedModelSession::engine() const {
+    std::scoped_lock lock(mutex_);
+    return engine_;
+}
+
+} // namespace va::analyzer
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "analyzer/interfaces.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace va::analyzer {
+
+// One loaded model served to every analyzer that uses it. Requests submitted by
+// different pipelines are gathered into a single batched run (at most
+// max_batch_size frames, waiting no longer than max_wait_us after the first one
+// arrives) and the per-frame slices of each output are copied back to callers.
+// Each attached session has at most one request in flight, so the wait never
+// targets more frames than there are sessions and is skipped for a single one.
+// Models with a fixed batch dimension are still shared but run one frame at a time.
+class SharedInferenceEngine {
+public:
+    struct Options {
+        int max_batch_size {8};
+        int max_wait_us {2000};
+    };
+
+    struct Stats {
+        uint64_t batches {0};
+        uint64_t requests {0};
+        double avg_batch_size {0.0};
+        int max_batch_size {1};
+        bool dynamic_batch {false};
+        uint64_t sessions {0};
+    };
+
+    SharedInferenceEngine(std::shared_ptr<IModelSession> session, bool dynamic_batch, Options options);
+    ~SharedInferenceEngine();
+
+    SharedInferenceEngine(const SharedInferenceEngine&) = delete;
+    SharedInferenceEngine& operator=(const SharedInferenceEngine&) = delete;
+
+    // Blocks until the batch containing `input` has run. Output tensors are
+    // copied into `storage`; the returned views point into it.
+    bool infer(const TensorView& input,
+               std::vector<std::vector<float>>& storage,
+               std::vector<TensorView>& outputs);
+
+    // Called by SharedModelSession for as long as it uses this engine.
+    void attach();
+    void detach();
+
+    Stats stats() const;
+    const std::shared_ptr<IModelSession>& session() const { return session_; }
+
+private:
+    struct Request {
+        const TensorView* input {nullptr};
+        std::vector<std::vector<float>>* storage {nullptr};
+        std::vector<TensorView>* outputs {nullptr};
+        std::chrono::steady_clock::time_point enqueued;
+        bool done {false};
+        bool ok {false};
+    };
+
+    void workerLoop();
+    void takeBatch(std::vector<Request*>& batch, size_t limit);
+    void runBatch(const std::vector<Request*>& batch);
+    void runSingle(Request& request);
+    static bool batchable(const TensorView& input);
+
+    std::shared_ptr<IModelSession> session_;
+    const bool dynamic_batch_;
+    Options options_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable request_cv_;
+    std::condition_variable done_cv_;
+    std::deque<Request*> pending_;
+    bool stopping_ {false};
+    size_t sessions_ {0};
+    uint64_t batches_ {0};
+    uint64_t requests_ {0};
+    std::thread worker_;
+
+    // Only touched by the worker thread.
+    std::vector<float> batch_input_;
+    std::vector<TensorView> batch_outputs_;
+};
+
+// IModelSession facade handed to each Analyzer. It resolves the shared engine
+// for a model path and keeps a private copy of the latest outputs so
+// postprocessing is unaffected by other pipelines' batches.
+class SharedModelSession : public IModelSession {
+public:
+    using EngineResolver = std::function<std::shared_ptr<SharedInferenceEngine>(const std::string& model_path, bool use_gpu)>;
+
+    explicit SharedModelSession(EngineResolver resolver);
+    ~SharedModelSession() override;
+
+    bool loadModel(const std::string& model_path, bool use_gpu) override;
+    bool run(const TensorView& input, std::vector<TensorView>& outputs) override;
+
+    std::shared_ptr<SharedInferenceEngine> engine() const;
+
+private:
+    EngineResolver resolver_;
+    mutable std::mutex mutex_;
+    std::shared_ptr<SharedInferenceEngine> engine_;
+    std::vector<std::vector<float>> output_storage_;
+};
+
+} // namespace va::analyzer
@@ -3,16 +3,26 @@
 #include "ConfigLoader.hpp"
 #include "analyzer/analyzer.hpp"
 #include "core/logger.hpp"
+#include "core/utils.hpp"
 
 #include <algorithm>
-#include <cctype>
 #include <cstddef>
 #include <filesystem>
 #include <iostream>
+#include <sstream>
+#include <thread>
 #include <utility>
 
 namespace va::app {
 
+namespace {
+
+// `threads: auto` stops here: more slices cost compression, more frame
+// threads cost latency, and neither speeds up a 1080p encode much further.
+constexpr int kMaxAutoEncoderThreads = 8;
+
+} // namespace
+
 Application::Application() = default;
 Application::~Application() {
     shutdown();
@@ -70,14 +80,13 @@ bool Application::initialize(const std::string& config_dir) {
     app_config_ = ConfigLoader::loadAppConfig(config_dir_);
 
     va::core::Logger::instance().configure(app_config_.observability);
+    source_switch_limiter_.setRate(app_config_.security.switch_limits.source_per_stream_per_sec);
+    model_switch_limiter_.setRate(app_config_.security.switch_limits.model_per_stream_per_sec);
 
     va::core::EngineDescriptor descriptor;
     descriptor.name = app_config_.engine.type;
     std::string raw_provider = app_config_.engine.provider.empty() ? app_config_.engine.type : app_config_.engine.provider;
-    std::string provider_lower = raw_provider;
-    std::transform(provider_lower.begin(), provider_lower.end(), provider_lower.begin(), [](unsigned char c) {
-        return static_cast<char>(std::tolower(c));
-    });
+    std::string provider_lower = va::core::toLower(raw_provider);
     if (provider_lower == "ort-trt" || provider_lower == "ort_tensor_rt" || provider_lower == "ort-tensorrt") {
         raw_provider = "tensorrt";
     } else if (provider_lower == "ort-cuda" || provider_lower == "ort-gpu") {
@@ -108,6 +117,10 @@ bool Application::initialize(const std::string& config_dir) {
     if (app_config_.engine.options.io_binding_output_bytes > 0) {
         descriptor.options["io_binding_output_bytes"] = std::to_string(app_config_.engine.options.io_binding_output_bytes);
     }
+    descriptor.options["batching"] = app_config_.engine.options.batching_enabled ? "true" : "false";
+    descriptor.options["max_batch_size"] = std::to_string(app_config_.engine.options.max_batch_size);
+    descriptor.options["max_batch_wait_us"] = std::to_string(app_config_.engine.options.max_batch_wait_us);
+    descriptor.options["intra_op_threads"] = std::to_string(app_config_.engine.options.intra_op_threads);
     engine_manager_.setEngine(std::move(descriptor));
 
     va::server::RestServerOptions rest_options;
@@ -174,6 +187,8 @@ Application::SystemStats Application::systemStats() const {
         stats.transport_packets += info.transport_stats.packets;
         stats.transport_bytes += info.transport_stats.bytes;
     }
+    stats.shared_engines = engine_manager_.sharedEngineStats();
+    stats.frame_pool = va::core::FramePool::shared().stats();
     return stats;
 }
 
@@ -267,12 +282,13 @@ std::optional<std::string> Application::subscribeStream(const std::string& strea
         params_opt = AnalyzerParamsEntry{};
     }
 
-    va::core::SourceConfig source_cfg = buildSourceConfig(stream_id, source_uri);
     va::core::FilterConfig filter_cfg = buildFilterConfig(stream_id, profile_it->second, *model_opt, *params_opt);
     va::core::EncoderConfig encoder_cfg = buildEncoderConfig(profile_it->second);
+    va::core::SourceConfig source_cfg = buildSourceConfig(stream_id, source_uri, profile_it->second, filter_cfg, encoder_cfg);
     va::core::TransportConfig transport_cfg = buildTransportConfig(stream_id, profile_it->second);
+    va::core::PipelineConfig pipeline_cfg = buildPipelineConfig(profile_it->second);
 
-    auto key = track_manager_->subscribe(source_cfg, filter_cfg, encoder_cfg, transport_cfg);
+    auto key = track_manager_->subscribe(source_cfg, filter_cfg, encoder_cfg, transport_cfg, pipeline_cfg);
     if (key.empty()) {
         VA_LOG_WARN() << "[Application] subscribeStream failed: pipeline builder returned empty key for stream "
                   << stream_id << " profile " << profile_name << std::endl;
@@ -297,11 +313,26 @@ bool Application::unsubscribeStream(const std::string& stream_id, const std::str
 
 bool Application::switchSource(const std::string& stream_id,
                                const std::string& profile_name,
-                               const std::string& new_uri) {
+                               const std::string& new_uri,
+                               double& retry_after_ms) {
+    retry_after_ms = 0.0;
     if (!initialized_ || !track_manager_) {
         last_error_ = "application not initialized";
         return false;
     }
+    if (new_uri.empty()) {
+        last_error_ = "source uri is empty";
+        return false;
+    }
+    // Requests that would fail anyway do not use up the stream's budget.
+    if (!track_manager_->contains(stream_id, profile_name)) {
+        last_error_ = "pipeline not found";
+        return false;
+    }
+    if (!source_switch_limiter_.tryAcquire(stream_id, retry_after_ms)) {
+        last_error_ = "source switch rate limit exceeded for stream " + stream_id;
+        return false;
+    }
     if (!track_manager_->switchSource(stream_id, profile_name, new_uri)) {
         last_error_ = "failed to switch source";
         return false;
@@ -312,7 +343,9 @@ bool Application::switchSource(const std::string& stream_id,
 
 bool Application::switchModel(const std::string& stream_id,
                               const std::string& profile_name,
-                              const std::string& model_id) {
+                              const std::string& model_id,
+                              double& retry_after_ms) {
+    retry_after_ms = 0.0;
     if (!initialized_ || !track_manager_) {
         last_error_ = "application not initialized";
         return false;
@@ -329,6 +362,16 @@ bool Application::switchModel(const std::string& stream_id,
         return false;
     }
 
+    if (!track_manager_->contains(stream_id, profile_name)) {
+        last_error_ = "pipeline not found";
+        return false;
+    }
+
+    if (!model_switch_limiter_.tryAcquire(stream_id, retry_after_ms)) {
+        last_error_ = "model switch rate limit exceeded for stream " + stream_id;
+        return false;
+    }
+
     if (!track_manager_->switchModel(stream_id, profile_name, model_opt->id)) {
         last_error_ = "failed to switch model";
         return false;
@@ -355,6 +398,18 @@ bool Application::switchTask(const std::string& stream_id,
     return true;
 }
 
+std::optional<va::analyzer::AnalyzerParams> Application::currentParams(const std::string& stream_id,
+                                                                     const std::string& profile_name) const {
+    if (!initialized_ || !track_manager_) {
+        return std::nullopt;
+    }
+    auto params = track_manager_->params(stream_id, profile_name);
+    if (!params) {
+        return std::nullopt;
+    }
+    return *params;
+}
+
 bool Application::updateParams(const std::string& stream_id,
                                const std::string& profile_name,
                                const va::analyzer::AnalyzerParams& params) {
@@ -373,6 +428,55 @@ bool Application::updateParams(const std::string& stream_id,
     return true;
 }
 
+std::optional<std::string> Application::acceptViewerOffer(const std::string& stream_id,
+                                                          const std::string& profile_name,
+                                                          const std::string& offer_sdp,
+                                                          std::string& answer_sdp) {
+    if (!initialized_ || !track_manager_) {
+        last_error_ = "application not initialized";
+        return std::nullopt;
+    }
+    std::string session_id;
+    if (!track_manager_->acceptOffer(stream_id, profile_name, offer_sdp, answer_sdp, session_id)) {
+        last_error_ = "failed to negotiate viewer session (pipeline missing, not an rtp transport, or no H.264 in offer)";
+        return std::nullopt;
+    }
+    last_error_.clear();
+    return session_id;
+}
+
+bool Application::updateViewerSession(const std::string& stream_id,
+                                      const std::string& profile_name,
+                                      const std::string& session_id,
+                                      const std::string& fragment,
+                                      std::string& local_fragment) {
+    if (!initialized_ || !track_manager_) {
+        last_error_ = "application not initialized";
+        return false;
+    }
+    if (!track_manager_->updateSession(stream_id, profile_name, session_id, fragment, local_fragment)) {
+        last_error_ = "viewer session not found or candidates rejected";
+        return false;
+    }
+    last_error_.clear();
+    return true;
+}
+
+bool Application::closeViewerSession(const std::string& stream_id,
+                                     const std::string& profile_name,
+                                     const std::string& session_id) {
+    if (!initialized_ || !track_manager_) {
+        last_error_ = "application not initialized";
+        return false;
+    }
+    if (!track_manager_->closeSession(stream_id, profile_name, session_id)) {
+        last_error_ = "viewer session not found";
+        return false;
+    }
+    last_error_.clear();
+    return true;
+}
+
 bool Application::setEngine(const va::core::EngineDescriptor& descriptor) {
     if (!engine_manager_.setEngine(descriptor)) {
         last_error_ = "failed to set engine";
@@ -429,8 +533,7 @@ std::optional<DetectionModelEntry> Application::resolveModel(const ProfileEntry&
 }
 
 std::optional<AnalyzerParamsEntry> Application::resolveParams(const std::string& task) const {
-    std::string key = task;
-    std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    std::string key = va::core::toLower(task);
     auto it = analyzer_params_.find(key);
     if (it != analyzer_params_.end()) {
         return it->second;
@@ -439,10 +542,49 @@ std::optional<AnalyzerParamsEntry> Application::resolveParams(const std::string&
 }
 
 va::core::SourceConfig Application::buildSourceConfig(const std::string& stream_id,
-                                                     const std::string& uri) const {
+                                                     const std::string& uri,
+                                                     const ProfileEntry& profile,
+                                                     const va::core::FilterConfig& filter,
+                                                     const va::core::EncoderConfig& encoder) const {
     va::core::SourceConfig cfg;
     cfg.stream_id = stream_id;
     cfg.uri = uri;
+    cfg.buffer_depth = app_config_.decoder.buffer_depth > 0 ? app_config_.decoder.buffer_depth : cfg.buffer_depth;
+    cfg.buffer_policy = app_config_.decoder.buffer_policy;
+    cfg.decoder_impl = app_config_.decoder.impl;
+    cfg.rtsp_prefer_tcp = app_config_.decoder.rtsp_prefer_tcp;
+    cfg.rtsp_timeout_ms = app_config_.decoder.rtsp_timeout_ms;
+    cfg.low_delay = app_config_.decoder.low_delay;
+    cfg.decode_threads = app_config_.decoder.threads;
+    cfg.decode_thread_type = app_config_.decoder.thread_type;
+    cfg.pixel_format = app_config_.decoder.output;
+    cfg.reconnect_initial_ms = app_config_.decoder.reconnect_initial_ms;
+    cfg.reconnect_max_ms = app_config_.decoder.reconnect_max_ms;
+    cfg.reconnect_jitter = app_config_.decoder.reconnect_jitter;
+    cfg.reconnect_max_attempts = app_config_.decoder.reconnect_max_attempts;
+    cfg.stall_timeout_ms = app_config_.decoder.stall_timeout_ms;
+
+    cfg.frame_stride = std::max(1, profile.decode_frame_stride);
+    cfg.skip_nonref = profile.decode_skip_nonref && cfg.frame_stride > 1;
+    std::string scale = va::core::toLower(profile.decode_scale);
+    if (scale == "native") {
+        return cfg;
+    }
+    if (scale != "auto" && scale != "stretch") {
+        VA_LOG_WARN() << "[Application] unknown decode scale '" << profile.decode_scale
+                      << "' in profile " << profile.name << ", using auto";
+    }
+    if (va::core::outputsVideo(va::core::parseOutputMode(profile.output_mode))) {
+        // The encoder only takes frames of its configured size; the picture
+        // keeps its aspect ratio inside black bars unless asked to stretch.
+        cfg.target_width = encoder.width;
+        cfg.target_height = encoder.height;
+        cfg.frame_fit = scale == "stretch" ? "stretch" : "pad";
+    } else {
+        cfg.target_width = filter.input_width;
+        cfg.target_height = filter.input_height;
+        cfg.frame_fit = "fit";
+    }
     return cfg;
 }
 
@@ -458,27 +600,46 @@ va::core::FilterConfig Application::buildFilterConfig(const std::string& stream_
 
     cfg.input_width = profile.input_width > 0 ? profile.input_width : model.input_width;
     cfg.input_height = profile.input_height > 0 ? profile.input_height : model.input_height;
+    cfg.channel_order = profile.preprocess_channel_order;
+    cfg.preprocess_threads = profile.preprocess_threads;
+    cfg.nms_method = profile.postprocess_nms;
+    cfg.nms_top_k = profile.postprocess_top_k;
+    cfg.max_detections = profile.postprocess_max_detections;
+    cfg.nms_class_agnostic = profile.postprocess_class_agnostic;
+    cfg.nms_soft_sigma = profile.postprocess_soft_sigma;
+    cfg.decode_mode = profile.postprocess_decode;
+    cfg.score_activation = profile.postprocess_score_activation;
+    cfg.box_units = profile.postprocess_box_units;
+    cfg.overlay = profile.render_overlay;
+    cfg.overlay_labels = profile.render_labels;
+    cfg.overlay_mask_alpha = profile.render_mask_alpha;
+    cfg.overlay_thickness = profile.render_thickness;
 
     cfg.confidence_threshold = model.conf > 0.0f ? model.conf : params.conf;
     cfg.iou_threshold = model.iou > 0.0f ? model.iou : params.iou;
+    cfg.class_whitelist = params.class_whitelist;
+    if (params.classes_literal) {
+        // "classes: person,car" is accepted alongside the list form.
+        std::stringstream literal(*params.classes_literal);
+        std::string token;
+        while (std::getline(literal, token, ',')) {
+            cfg.class_whitelist.emplace_back(token);
+        }
+    }
+    cfg.params_max_detections = params.max_detections;
+    cfg.mask_threshold = params.mask_threshold;
 
     auto engine = engine_manager_.currentEngine();
     cfg.engine_type = engine.name;
     cfg.engine_provider = engine.provider;
     cfg.device_index = engine.device_index;
 
-    auto toLower = [](std::string value) {
-        std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
-        return value;
-    };
-
     auto getBoolOption = [&](const std::string& key, bool fallback) {
         auto it = engine.options.find(key);
         if (it == engine.options.end()) {
             return fallback;
         }
-        std::string value = it->second;
-        std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        std::string value = va::core::toLower(it->second);
         if (value == "1" || value == "true" || value == "yes" || value == "on") return true;
         if (value == "0" || value == "false" || value == "no" || value == "off") return false;
         return fallback;
@@ -521,6 +682,10 @@ va::core::FilterConfig Application::buildFilterConfig(const std::string& stream_
     cfg.tensorrt_min_subgraph_size = getIntOption("trt_min_subgraph_size", cfg.tensorrt_min_subgraph_size);
     cfg.io_binding_input_bytes = getSizeOption("io_binding_input_bytes", cfg.io_binding_input_bytes);
     cfg.io_binding_output_bytes = getSizeOption("io_binding_output_bytes", cfg.io_binding_output_bytes);
+    cfg.intra_op_threads = getIntOption("intra_op_threads", cfg.intra_op_threads);
+    cfg.batching_enabled = getBoolOption("batching", cfg.batching_enabled);
+    cfg.max_batch_size = getIntOption("max_batch_size", cfg.max_batch_size);
+    cfg.max_batch_wait_us = getIntOption("max_batch_wait_us", cfg.max_batch_wait_us);
 
     if (cfg.input_width == 0) {
         cfg.input_width = 640;
@@ -550,18 +715,85 @@ va::core::EncoderConfig Application::buildEncoderConfig(const ProfileEntry& prof
     }
     cfg.codec = codec;
     cfg.zero_latency = profile.enc_zero_latency;
+
+    std::string thread_type = va::core::toLower(profile.enc_thread_type);
+    if (thread_type != "slice" && thread_type != "frame") {
+        if (!thread_type.empty()) {
+            VA_LOG_WARN() << "[Application] unknown encoder thread_type '" << profile.enc_thread_type
+                          << "' in profile " << profile.name << ", using the default";
+        }
+        // Frame threading delays output by one frame per thread.
+        thread_type = cfg.zero_latency ? "slice" : "frame";
+    }
+    cfg.thread_type = thread_type;
+    cfg.threads = resolveEncoderThreads(profile.enc_threads);
     return cfg;
 }
 
+// A number is taken as is; "auto" gives the encoder the cores the inference
+// session's intra-op threads leave free.
+int Application::resolveEncoderThreads(const std::string& value) const {
+    if (!value.empty() && value != "auto") {
+        try {
+            const int threads = std::stoi(value);
+            if (threads > 0) {
+                return threads;
+            }
+        } catch (...) {
+        }
+        VA_LOG_WARN() << "[Application] invalid encoder threads '" << value << "', using auto";
+    }
+
+    int inference_threads = 1;
+    const auto engine = engine_manager_.currentEngine();
+    auto it = engine.options.find("intra_op_threads");
+    if (it != engine.options.end()) {
+        try {
+            inference_threads = std::max(1, std::stoi(it->second));
+        } catch (...) {
+        }
+    }
+    const int cores = static_cast<int>(std::thread::hardware_concurrency());
+    if (cores <= 0) {
+        return 1;
+    }
+    return std::clamp(cores - inference_threads, 1, kMaxAutoEncoderThreads);
+}
+
 va::core::TransportConfig Application::buildTransportConfig(const std::string& stream_id,
                                                             const ProfileEntry& profile) const {
     va::core::TransportConfig cfg;
-    cfg.whip_url = expandTemplate(profile.publish_whip_template, stream_id);
+    cfg.kind = va::core::toLower(profile.publish_transport);
+    cfg.whip_url = expandTemplate(profile.publish_whip_template, stream_id, profile.name);
+    const int ice_min = app_config_.webrtc_ice_port_min;
+    const int ice_max = app_config_.webrtc_ice_port_max;
+    if (ice_min > 0 && ice_min <= ice_max && ice_max <= 65535) {
+        cfg.ice_port_min = ice_min;
+        cfg.ice_port_max = ice_max;
+    } else {
+        VA_LOG_WARN() << "[Application] invalid webrtc ICE port range " << ice_min << '-' << ice_max
+                      << ", using " << cfg.ice_port_min << '-' << cfg.ice_port_max;
+    }
+    return cfg;
+}
+
+va::core::PipelineConfig Application::buildPipelineConfig(const ProfileEntry& profile) const {
+    va::core::PipelineConfig cfg;
+    cfg.output_mode = profile.output_mode;
+    cfg.metadata_format = profile.output_format;
+    cfg.metadata_keyframe_interval = profile.output_keyframe_interval;
+    if (!app_config_.pipeline.execution_mode.empty()) {
+        cfg.execution_mode = app_config_.pipeline.execution_mode;
+    }
+    if (app_config_.pipeline.queue_depth > 0) {
+        cfg.queue_depth = app_config_.pipeline.queue_depth;
+    }
     return cfg;
 }
 
 std::string Application::expandTemplate(const std::string& templ,
-                                        const std::string& stream_id) const {
+                                        const std::string& stream_id,
+                                        const std::string& profile_name) const {
     std::string result = templ;
     auto replace_all = [](std::string& target, const std::string& from, const std::string& to) {
         size_t pos = 0;
@@ -572,6 +804,7 @@ std::string Application::expandTemplate(const std::string& templ,
     };
 
     replace_all(result, "${stream}", stream_id);
+    replace_all(result, "${profile}", profile_name);
     replace_all(result, "${whip_base}", app_config_.sfu_whip_base);
     replace_all(result, "${whep_base}", app_config_.sfu_whep_base);
     return result;
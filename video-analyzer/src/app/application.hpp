@@ -3,7 +3,9 @@
 #include "composition_root.hpp"
 #include "core/engine_manager.hpp"
 #include "core/pipeline_builder.hpp"
+#include "core/rate_limiter.hpp"
 #include "core/track_manager.hpp"
+#include "core/utils.hpp"
 #include "server/rest.hpp"
 #include "ConfigLoader.hpp"
 
@@ -48,6 +50,8 @@ public:
         uint64_t dropped_frames {0};
         uint64_t transport_packets {0};
         uint64_t transport_bytes {0};
+        std::vector<va::core::SharedEngineStats> shared_engines;
+        va::core::FramePoolStats frame_pool;
     };
     SystemStats systemStats() const;
     bool ffmpegEnabled() const;
@@ -57,19 +61,36 @@ public:
                                                const std::string& source_uri,
                                                const std::optional<std::string>& model_override = std::nullopt);
     bool unsubscribeStream(const std::string& stream_id, const std::string& profile_name);
+    // `retry_after_ms` is > 0 when security.switch_limits refused the switch.
     bool switchSource(const std::string& stream_id,
                       const std::string& profile_name,
-                      const std::string& new_uri);
+                      const std::string& new_uri,
+                      double& retry_after_ms);
     bool switchModel(const std::string& stream_id,
                      const std::string& profile_name,
-                     const std::string& model_id);
+                     const std::string& model_id,
+                     double& retry_after_ms);
     bool switchTask(const std::string& stream_id,
                     const std::string& profile_name,
                     const std::string& task_id);
+    std::optional<va::analyzer::AnalyzerParams> currentParams(const std::string& stream_id,
+                                                              const std::string& profile_name) const;
     bool updateParams(const std::string& stream_id,
                       const std::string& profile_name,
                       const va::analyzer::AnalyzerParams& params);
     bool setEngine(const va::core::EngineDescriptor& descriptor);
+    std::optional<std::string> acceptViewerOffer(const std::string& stream_id,
+                                                 const std::string& profile_name,
+                                                 const std::string& offer_sdp,
+                                                 std::string& answer_sdp);
+    bool updateViewerSession(const std::string& stream_id,
+                             const std::string& profile_name,
+                             const std::string& session_id,
+                             const std::string& fragment,
+                             std::string& local_fragment);
+    bool closeViewerSession(const std::string& stream_id,
+                            const std::string& profile_name,
+                            const std::string& session_id);
     const std::string& lastError() const { return last_error_; }
 
     va::core::EngineRuntimeStatus engineRuntimeStatus() const;
@@ -92,21 +113,29 @@ private:
     std::unordered_map<std::string, ProfileEntry> profile_index_;
     std::unordered_map<std::string, std::string> active_models_by_task_;
     std::string last_error_;
+    va::core::KeyedRateLimiter source_switch_limiter_;
+    va::core::KeyedRateLimiter model_switch_limiter_;
 
     std::optional<DetectionModelEntry> resolveModel(const ProfileEntry& profile) const;
     std::optional<DetectionModelEntry> findModelById(const std::string& model_id) const;
     std::optional<AnalyzerParamsEntry> resolveParams(const std::string& task) const;
     va::core::SourceConfig buildSourceConfig(const std::string& stream_id,
-                                            const std::string& uri) const;
+                                            const std::string& uri,
+                                            const ProfileEntry& profile,
+                                            const va::core::FilterConfig& filter,
+                                            const va::core::EncoderConfig& encoder) const;
     va::core::FilterConfig buildFilterConfig(const std::string& stream_id,
                                             const ProfileEntry& profile,
                                             const DetectionModelEntry& model,
                                             const AnalyzerParamsEntry& params) const;
     va::core::EncoderConfig buildEncoderConfig(const ProfileEntry& profile) const;
+    int resolveEncoderThreads(const std::string& value) const;
     va::core::TransportConfig buildTransportConfig(const std::string& stream_id,
                                                   const ProfileEntry& profile) const;
+    va::core::PipelineConfig buildPipelineConfig(const ProfileEntry& profile) const;
     std::string expandTemplate(const std::string& templ,
-                               const std::string& stream_id) const;
+                               const std::string& stream_id,
+                               const std::string& profile_name) const;
 };
 
 } // namespace va::app
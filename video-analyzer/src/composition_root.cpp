@@ -1,19 +1,25 @@
 #include "composition_root.hpp"
 
 #include "analyzer/analyzer.hpp"
+#include "analyzer/class_names.hpp"
 #include "analyzer/ort_session.hpp"
 #include "analyzer/preproc_letterbox_cpu.hpp"
 #include "analyzer/preproc_letterbox_cuda.hpp"
 #include "analyzer/postproc_yolo_det.hpp"
 #include "analyzer/postproc_yolo_seg.hpp"
 #include "analyzer/postproc_detr.hpp"
+#include "analyzer/renderer_overlay.hpp"
 #include "analyzer/renderer_passthrough.hpp"
+#include "analyzer/shared_engine.hpp"
 #include "core/engine_manager.hpp"
 #include "media/encoder_h264_ffmpeg.hpp"
+#include "media/source_ffmpeg_rtsp.hpp"
 #include "media/source_switchable_rtsp.hpp"
 #include "media/transport_webrtc_datachannel.hpp"
+#include "media/transport_webrtc_track.hpp"
 
 #include "core/logger.hpp"
+#include "core/utils.hpp"
 
 #include <algorithm>
 
@@ -22,8 +28,43 @@ namespace va {
 va::core::Factories buildFactories(va::core::EngineManager& engine_manager) {
     va::core::Factories factories;
 
-    factories.make_source = [](const va::core::SourceConfig& cfg) {
-        return std::make_shared<va::media::SwitchableRtspSource>(cfg.uri);
+    factories.make_source = [](const va::core::SourceConfig& cfg) -> std::shared_ptr<va::media::ISwitchableSource> {
+        va::media::ReconnectOptions reconnect;
+        reconnect.initial_ms = cfg.reconnect_initial_ms;
+        reconnect.max_ms = cfg.reconnect_max_ms;
+        reconnect.jitter = cfg.reconnect_jitter;
+        reconnect.max_attempts = cfg.reconnect_max_attempts;
+        reconnect.stall_timeout_ms = cfg.stall_timeout_ms;
+#ifdef USE_FFMPEG
+        if (cfg.decoder_impl != "opencv") {
+            va::media::FfmpegRtspSource::Options options;
+            options.buffer_depth = cfg.buffer_depth > 0 ? static_cast<size_t>(cfg.buffer_depth) : options.buffer_depth;
+            options.buffer_policy = va::media::parseBufferPolicy(cfg.buffer_policy);
+            options.prefer_tcp = cfg.rtsp_prefer_tcp;
+            options.timeout_ms = cfg.rtsp_timeout_ms;
+            options.low_delay = cfg.low_delay;
+            options.threads = cfg.decode_threads;
+            options.thread_type = cfg.decode_thread_type;
+            options.output = va::core::parsePixelFormat(cfg.pixel_format);
+            options.target_width = cfg.target_width;
+            options.target_height = cfg.target_height;
+            options.fit = va::core::parseFrameFit(cfg.frame_fit);
+            options.frame_stride = std::max(1, cfg.frame_stride);
+            options.skip_nonref = cfg.skip_nonref;
+            options.reconnect = reconnect;
+            return std::make_shared<va::media::FfmpegRtspSource>(cfg.uri, options);
+        }
+#endif
+        va::media::SwitchableRtspSource::Options options;
+        options.buffer_depth = cfg.buffer_depth > 0 ? static_cast<size_t>(cfg.buffer_depth) : options.buffer_depth;
+        options.buffer_policy = va::media::parseBufferPolicy(cfg.buffer_policy);
+        options.target_width = cfg.target_width;
+        options.target_height = cfg.target_height;
+        options.fit = va::core::parseFrameFit(cfg.frame_fit);
+        options.frame_stride = std::max(1, cfg.frame_stride);
+        options.timeout_ms = cfg.rtsp_timeout_ms;
+        options.reconnect = reconnect;
+        return std::make_shared<va::media::SwitchableRtspSource>(cfg.uri, options);
     };
 
     factories.make_filter = [&engine_manager](const va::core::FilterConfig& cfg) {
@@ -41,11 +82,13 @@ va::core::Factories buildFactories(va::core::EngineManager& engine_manager) {
         }
 #endif
         if (!preprocessor) {
-            preprocessor = std::make_shared<va::analyzer::LetterboxPreprocessorCPU>(cfg.input_width, cfg.input_height);
+            va::analyzer::LetterboxPreprocessorCPU::Options preproc_options;
+            preproc_options.channel_order = va::analyzer::parseChannelOrder(cfg.channel_order);
+            preproc_options.threads = cfg.preprocess_threads;
+            preprocessor = std::make_shared<va::analyzer::LetterboxPreprocessorCPU>(cfg.input_width, cfg.input_height, preproc_options);
         }
         analyzer->setPreprocessor(preprocessor);
 
-        auto session = std::make_shared<va::analyzer::OrtModelSession>();
 #ifdef USE_ONNXRUNTIME
         va::analyzer::OrtModelSession::Options options;
         options.provider = !cfg.engine_provider.empty() ? cfg.engine_provider : engine_desc.provider;
@@ -61,25 +104,21 @@ va::core::Factories buildFactories(va::core::EngineManager& engine_manager) {
         options.tensorrt_min_subgraph_size = cfg.tensorrt_min_subgraph_size;
         options.io_binding_input_bytes = cfg.io_binding_input_bytes;
         options.io_binding_output_bytes = cfg.io_binding_output_bytes;
-        session->setOptions(options);
+        options.intra_op_threads = cfg.intra_op_threads;
 #endif
 
-        const std::string& model_path = !cfg.model_path.empty() ? cfg.model_path : cfg.model_id;
-
-        std::string provider_lower = provider_source;
-        std::transform(provider_lower.begin(), provider_lower.end(), provider_lower.begin(), [](unsigned char c) {
-            return static_cast<char>(std::tolower(c));
-        });
-        bool use_gpu = hint_gpu || provider_lower == "gpu";
-
-        if (!session->loadModel(model_path, use_gpu)) {
-            VA_LOG_ERROR() << "[Factories] failed to load model at " << model_path
-                           << " (gpu=" << std::boolalpha << use_gpu << std::noboolalpha << ")";
-            return std::shared_ptr<va::analyzer::Analyzer>{};
-        }
+        auto loadOrtSession = [=, &engine_manager](const std::string& path, bool gpu) -> std::shared_ptr<va::analyzer::OrtModelSession> {
+            auto ort_session = std::make_shared<va::analyzer::OrtModelSession>();
+#ifdef USE_ONNXRUNTIME
+            ort_session->setOptions(options);
+#endif
+            if (!ort_session->loadModel(path, gpu)) {
+                VA_LOG_ERROR() << "[Factories] failed to load model at " << path
+                               << " (gpu=" << std::boolalpha << gpu << std::noboolalpha << ")";
+                return nullptr;
+            }
 
-        {
-            auto runtime = session->runtimeInfo();
+            auto runtime = ort_session->runtimeInfo();
             va::core::EngineRuntimeStatus status;
             status.provider = runtime.provider;
             status.gpu_active = runtime.gpu_active;
@@ -87,27 +126,105 @@ va::core::Factories buildFactories(va::core::EngineManager& engine_manager) {
             status.device_binding = runtime.device_binding_active;
             status.cpu_fallback = runtime.cpu_fallback;
             engine_manager.updateRuntimeStatus(std::move(status));
+            return ort_session;
+        };
+
+        const std::string& model_path = !cfg.model_path.empty() ? cfg.model_path : cfg.model_id;
+
+        std::string provider_lower = va::core::toLower(provider_source);
+        bool use_gpu = hint_gpu || provider_lower == "gpu";
+
+        std::shared_ptr<va::analyzer::IModelSession> session;
+        if (cfg.batching_enabled) {
+            va::analyzer::SharedInferenceEngine::Options batch_options;
+            batch_options.max_batch_size = cfg.max_batch_size;
+            batch_options.max_wait_us = cfg.max_batch_wait_us;
+            const std::string key_suffix = "|" + provider_lower + "|" + std::to_string(cfg.device_index);
+            // Pipelines whose session options differ get engines of their own
+            // rather than silently running on whichever was loaded first.
+            const auto flag = [](bool value) { return value ? "1" : "0"; };
+            const std::string options_key = std::string("|threads=") + std::to_string(cfg.intra_op_threads)
+                + ",io_binding=" + flag(cfg.use_io_binding)
+                + ",pinned=" + flag(cfg.prefer_pinned_memory)
+                + ",cpu_fallback=" + flag(cfg.allow_cpu_fallback)
+                + ",profiling=" + flag(cfg.enable_profiling)
+                + ",trt_fp16=" + flag(cfg.tensorrt_fp16)
+                + ",trt_int8=" + flag(cfg.tensorrt_int8)
+                + ",trt_workspace_mb=" + std::to_string(cfg.tensorrt_workspace_mb)
+                + ",trt_max_partition_iterations=" + std::to_string(cfg.tensorrt_max_partition_iterations)
+                + ",trt_min_subgraph_size=" + std::to_string(cfg.tensorrt_min_subgraph_size)
+                + ",io_binding_bytes=" + std::to_string(cfg.io_binding_input_bytes) + "/"
+                + std::to_string(cfg.io_binding_output_bytes);
+
+            session = std::make_shared<va::analyzer::SharedModelSession>(
+                [&engine_manager, loadOrtSession, batch_options, key_suffix, options_key](const std::string& path, bool gpu) {
+                    const std::string key = path + key_suffix + (gpu ? "|gpu" : "|cpu") + options_key;
+                    return engine_manager.acquireSharedEngine(key, [&]() -> std::shared_ptr<va::analyzer::SharedInferenceEngine> {
+                        auto ort_session = loadOrtSession(path, gpu);
+                        if (!ort_session) {
+                            return nullptr;
+                        }
+                        const bool dynamic_batch = ort_session->supportsDynamicBatch();
+                        if (!dynamic_batch && batch_options.max_batch_size > 1) {
+                            VA_LOG_WARN() << "[Factories] model " << path << " has a fixed batch dimension; sharing it without batching";
+                        }
+                        return std::make_shared<va::analyzer::SharedInferenceEngine>(ort_session, dynamic_batch, batch_options);
+                    });
+                });
+            if (!session->loadModel(model_path, use_gpu)) {
+                return std::shared_ptr<va::analyzer::Analyzer>{};
+            }
+        } else {
+            session = loadOrtSession(model_path, use_gpu);
+            if (!session) {
+                return std::shared_ptr<va::analyzer::Analyzer>{};
+            }
         }
 
         analyzer->setSession(session);
         analyzer->setUseGpuHint(use_gpu);
 
+        va::analyzer::NmsConfig nms;
+        nms.method = va::analyzer::parseNmsMethod(cfg.nms_method);
+        nms.iou_threshold = cfg.iou_threshold > 0.0f ? cfg.iou_threshold : nms.iou_threshold;
+        nms.top_k = cfg.nms_top_k;
+        nms.max_detections = cfg.max_detections;
+        nms.class_agnostic = cfg.nms_class_agnostic;
+        nms.soft_sigma = cfg.nms_soft_sigma;
+        const auto decode_mode = va::analyzer::YoloDetectionPostprocessor::parseDecodeMode(cfg.decode_mode);
+
         std::shared_ptr<va::analyzer::IPostprocessor> postprocessor;
         if (cfg.task == "seg") {
-            postprocessor = std::make_shared<va::analyzer::YoloSegmentationPostprocessor>();
+            postprocessor = std::make_shared<va::analyzer::YoloSegmentationPostprocessor>(nms, decode_mode);
         } else if (cfg.task == "detr") {
-            postprocessor = std::make_shared<va::analyzer::DetrPostprocessor>();
+            va::analyzer::DetrPostprocessor::Options detr;
+            detr.activation = va::analyzer::parseScoreActivation(cfg.score_activation);
+            detr.box_units = va::analyzer::parseBoxUnits(cfg.box_units);
+            detr.max_detections = cfg.max_detections;
+            postprocessor = std::make_shared<va::analyzer::DetrPostprocessor>(detr);
         } else {
-            postprocessor = std::make_shared<va::analyzer::YoloDetectionPostprocessor>();
+            postprocessor = std::make_shared<va::analyzer::YoloDetectionPostprocessor>(nms, decode_mode);
         }
         analyzer->setPostprocessor(postprocessor);
 
-        auto renderer = std::make_shared<va::analyzer::PassthroughRenderer>();
+        std::shared_ptr<va::analyzer::IRenderer> renderer;
+        if (cfg.overlay) {
+            va::analyzer::OverlayRenderer::Options overlay;
+            overlay.labels = cfg.overlay_labels;
+            overlay.mask_alpha = cfg.overlay_mask_alpha;
+            overlay.thickness = cfg.overlay_thickness;
+            renderer = std::make_shared<va::analyzer::OverlayRenderer>(overlay);
+        } else {
+            renderer = std::make_shared<va::analyzer::PassthroughRenderer>();
+        }
         analyzer->setRenderer(renderer);
 
         auto params = std::make_shared<va::analyzer::AnalyzerParams>();
         params->confidence_threshold = cfg.confidence_threshold;
         params->iou_threshold = cfg.iou_threshold;
+        params->max_detections = cfg.params_max_detections;
+        params->class_whitelist = va::analyzer::resolveClassWhitelist(cfg.class_whitelist);
+        params->mask_threshold = cfg.mask_threshold;
         analyzer->updateParams(std::move(params));
 
         return analyzer;
@@ -118,9 +235,17 @@ va::core::Factories buildFactories(va::core::EngineManager& engine_manager) {
         return encoder;
     };
 
-    factories.make_transport = [](const va::core::TransportConfig& /*cfg*/) {
-        auto transport = std::make_shared<va::media::WebRTCDataChannelTransport>();
-        return transport;
+    factories.make_transport = [](const va::core::TransportConfig& cfg) -> std::shared_ptr<va::media::ITransport> {
+        if (cfg.kind == "rtp") {
+            va::media::WebRTCTrackTransport::Options options;
+            options.ice_port_min = static_cast<uint16_t>(cfg.ice_port_min);
+            options.ice_port_max = static_cast<uint16_t>(cfg.ice_port_max);
+            return std::make_shared<va::media::WebRTCTrackTransport>(options);
+        }
+        va::media::WebRTCDataChannelTransport::Options options;
+        options.ice_port_min = static_cast<uint16_t>(cfg.ice_port_min);
+        options.ice_port_max = static_cast<uint16_t>(cfg.ice_port_max);
+        return std::make_shared<va::media::WebRTCDataChannelTransport>(options);
     };
 
     return factories;
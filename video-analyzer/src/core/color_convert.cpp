@@ -0,0 +1,281 @@
+#include "core/color_convert.hpp"
+
+#include "core/simd.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+namespace va::core {
+
+namespace {
+
+// BT.601 limited range in 7-bit fixed point (the 8-bit coefficients halved),
+// small enough for _mm_maddubs_epi16:
+//   Y = ((13 B + 65 G + 33 R + 64) >> 7) + 16
+//   U = ((56 B - 37 G - 19 R + 64) >> 7) + 128
+//   V = ((-9 B - 47 G + 56 R + 64) >> 7) + 128
+inline uint8_t lumaOf(int b, int g, int r) {
+    return static_cast<uint8_t>(((13 * b + 65 * g + 33 * r + 64) >> 7) + 16);
+}
+
+inline uint8_t chromaUOf(int b, int g, int r) {
+    return static_cast<uint8_t>(((56 * b - 37 * g - 19 * r + 64) >> 7) + 128);
+}
+
+inline uint8_t chromaVOf(int b, int g, int r) {
+    return static_cast<uint8_t>(((-9 * b - 47 * g + 56 * r + 64) >> 7) + 128);
+}
+
+inline int roundedMean(int a, int b) {
+    return (a + b + 1) >> 1;
+}
+
+// Scalar tail of one row pair, from column `x` (even) to the end. Mirrors the
+// SIMD kernel: vertical rounded mean first, then horizontal.
+void convertPairScalar(const uint8_t* row0, const uint8_t* row1, int x, int width,
+                       uint8_t* y0, uint8_t* y1, uint8_t* u, uint8_t* v, bool second_row) {
+    for (; x < width; x += 2) {
+        const int xr = std::min(x + 1, width - 1);
+        const uint8_t* a = row0 + x * 3;
+        const uint8_t* b = row0 + xr * 3;
+        const uint8_t* c = row1 + x * 3;
+        const uint8_t* d = row1 + xr * 3;
+        y0[x] = lumaOf(a[0], a[1], a[2]);
+        if (xr != x) {
+            y0[xr] = lumaOf(b[0], b[1], b[2]);
+        }
+        if (second_row) {
+            y1[x] = lumaOf(c[0], c[1], c[2]);
+            if (xr != x) {
+                y1[xr] = lumaOf(d[0], d[1], d[2]);
+            }
+        }
+        int mean[3];
+        for (int ch = 0; ch < 3; ++ch) {
+            mean[ch] = roundedMean(roundedMean(a[ch], c[ch]), roundedMean(b[ch], d[ch]));
+        }
+        u[x / 2] = chromaUOf(mean[0], mean[1], mean[2]);
+        v[x / 2] = chromaVOf(mean[0], mean[1], mean[2]);
+    }
+}
+
+#if defined(VA_SIMD_SSE41)
+// 16 packed BGR pixels (48 bytes) -> four vectors of 4 BGR0 pixels.
+VA_TARGET_SSE41 inline void loadBgr16(const uint8_t* src, __m128i out[4]) {
+    const __m128i expand = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    const __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+    const __m128i a2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 32));
+    out[0] = _mm_shuffle_epi8(a0, expand);
+    out[1] = _mm_shuffle_epi8(_mm_alignr_epi8(a1, a0, 12), expand);
+    out[2] = _mm_shuffle_epi8(_mm_alignr_epi8(a2, a1, 8), expand);
+    out[3] = _mm_shuffle_epi8(_mm_srli_si128(a2, 4), expand);
+}
+
+// Weighted sums of 8 BGR0 pixels (two vectors) as int16.
+VA_TARGET_SSE41 inline __m128i weigh8(__m128i p0, __m128i p1, __m128i coeffs) {
+    return _mm_hadd_epi16(_mm_maddubs_epi16(p0, coeffs), _mm_maddubs_epi16(p1, coeffs));
+}
+
+VA_TARGET_SSE41 inline __m128i storeLuma16(const __m128i px[4], __m128i coeffs) {
+    const __m128i round = _mm_set1_epi16(64);
+    const __m128i offset = _mm_set1_epi16(16);
+    const __m128i lo = _mm_add_epi16(_mm_srli_epi16(_mm_add_epi16(weigh8(px[0], px[1], coeffs), round), 7), offset);
+    const __m128i hi = _mm_add_epi16(_mm_srli_epi16(_mm_add_epi16(weigh8(px[2], px[3], coeffs), round), 7), offset);
+    return _mm_packus_epi16(lo, hi);
+}
+
+VA_TARGET_SSE41 inline __m128i chroma8(__m128i c0, __m128i c1, __m128i coeffs) {
+    const __m128i round = _mm_set1_epi16(64);
+    const __m128i offset = _mm_set1_epi16(128);
+    const __m128i sum = _mm_add_epi16(_mm_srai_epi16(_mm_add_epi16(weigh8(c0, c1, coeffs), round), 7), offset);
+    return _mm_packus_epi16(sum, sum);
+}
+
+// Rounded mean of horizontally adjacent BGR0 pixels of a and b (4 each):
+// result holds the 4 block means of those 8 pixels.
+VA_TARGET_SSE41 inline __m128i pairMean(__m128i a, __m128i b) {
+    const __m128i even = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b), _MM_SHUFFLE(2, 0, 2, 0)));
+    const __m128i odd = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b), _MM_SHUFFLE(3, 1, 3, 1)));
+    return _mm_avg_epu8(even, odd);
+}
+
+// 16 columns of a row pair per step; returns where the scalar tail starts.
+VA_TARGET_SSE41 int convertPairSse41(const uint8_t* row0, const uint8_t* row1, int width,
+                                     uint8_t* y0, uint8_t* y1, uint8_t* u, uint8_t* v, bool second_row) {
+    const __m128i y_coeffs = _mm_setr_epi8(13, 65, 33, 0, 13, 65, 33, 0, 13, 65, 33, 0, 13, 65, 33, 0);
+    const __m128i u_coeffs = _mm_setr_epi8(56, -37, -19, 0, 56, -37, -19, 0, 56, -37, -19, 0, 56, -37, -19, 0);
+    const __m128i v_coeffs = _mm_setr_epi8(-9, -47, 56, 0, -9, -47, 56, 0, -9, -47, 56, 0, -9, -47, 56, 0);
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m128i top[4];
+        __m128i bottom[4];
+        loadBgr16(row0 + x * 3, top);
+        loadBgr16(row1 + x * 3, bottom);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(y0 + x), storeLuma16(top, y_coeffs));
+        if (second_row) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(y1 + x), storeLuma16(bottom, y_coeffs));
+        }
+        __m128i mean[4];
+        for (int i = 0; i < 4; ++i) {
+            mean[i] = _mm_avg_epu8(top[i], bottom[i]);
+        }
+        const __m128i c0 = pairMean(mean[0], mean[1]);
+        const __m128i c1 = pairMean(mean[2], mean[3]);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(u + x / 2), chroma8(c0, c1, u_coeffs));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(v + x / 2), chroma8(c0, c1, v_coeffs));
+    }
+    return x;
+}
+#endif
+
+// One plane of `bytes_per_pixel` bytes per sample: everything outside the
+// rectangle gets `value`.
+void fillPlaneOutside(uint8_t* plane, size_t stride, int width, int height, int bytes_per_pixel,
+                      const FrameRect& rect, uint8_t value) {
+    const size_t left = static_cast<size_t>(rect.x) * bytes_per_pixel;
+    const size_t inner = static_cast<size_t>(rect.width) * bytes_per_pixel;
+    const size_t row_bytes = static_cast<size_t>(width) * bytes_per_pixel;
+    for (int y = 0; y < height; ++y) {
+        uint8_t* row = plane + static_cast<size_t>(y) * stride;
+        if (y < rect.y || y >= rect.y + rect.height) {
+            std::memset(row, value, row_bytes);
+            continue;
+        }
+        std::memset(row, value, left);
+        std::memset(row + left + inner, value, row_bytes - left - inner);
+    }
+}
+
+// I420 -> BGR with OpenCV's 20-bit BT.601 coefficients, for the odd sizes
+// cv::cvtColor does not take. The last chroma column/row covers one pixel.
+inline uint8_t clampByte(int value) {
+    return static_cast<uint8_t>(std::clamp(value, 0, 255));
+}
+
+void i420ToBgrScalar(const uint8_t* i420, int width, int height, uint8_t* bgr) {
+    constexpr int kShift = 20;
+    constexpr int kRound = 1 << (kShift - 1);
+    constexpr int kCy = 1220542;
+    constexpr int kCub = 2116026;
+    constexpr int kCug = -409993;
+    constexpr int kCvg = -852492;
+    constexpr int kCvr = 1673527;
+    const auto planes = i420Planes(const_cast<uint8_t*>(i420), width, height);
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* luma = planes.y + static_cast<size_t>(y) * planes.y_stride;
+        const uint8_t* u = planes.u + static_cast<size_t>(y / 2) * planes.u_stride;
+        const uint8_t* v = planes.v + static_cast<size_t>(y / 2) * planes.v_stride;
+        uint8_t* out = bgr + static_cast<size_t>(y) * width * 3;
+        for (int x = 0; x < width; ++x) {
+            const int cy = std::max(0, luma[x] - 16) * kCy;
+            const int cu = u[x / 2] - 128;
+            const int cv = v[x / 2] - 128;
+            out[x * 3 + 0] = clampByte((cy + kCub * cu + kRound) >> kShift);
+            out[x * 3 + 1] = clampByte((cy + kCug * cu + kCvg * cv + kRound) >> kShift);
+            out[x * 3 + 2] = clampByte((cy + kCvr * cv + kRound) >> kShift);
+        }
+    }
+}
+
+// Rows 2 * pair and 2 * pair + 1 (the last row repeats for odd heights).
+void convertRowPair(const uint8_t* bgr, size_t bgr_stride, int width, int height, const I420Planes& dst, int pair) {
+    const int row = pair * 2;
+    const bool second_row = row + 1 < height;
+    const uint8_t* row0 = bgr + static_cast<size_t>(row) * bgr_stride;
+    const uint8_t* row1 = second_row ? row0 + bgr_stride : row0;
+    uint8_t* y0 = dst.y + static_cast<size_t>(row) * dst.y_stride;
+    uint8_t* y1 = second_row ? y0 + dst.y_stride : y0;
+    uint8_t* u = dst.u + static_cast<size_t>(pair) * dst.u_stride;
+    uint8_t* v = dst.v + static_cast<size_t>(pair) * dst.v_stride;
+
+    int x = 0;
+#if defined(VA_SIMD_SSE41)
+    if (simd::hasSse41()) {
+        x = convertPairSse41(row0, row1, width, y0, y1, u, v, second_row);
+    }
+#endif
+    convertPairScalar(row0, row1, x, width, y0, y1, u, v, second_row);
+}
+
+} // namespace
+
+I420Planes i420Planes(uint8_t* base, int width, int height) {
+    I420Planes planes;
+    const size_t chroma_width = static_cast<size_t>((width + 1) / 2);
+    const size_t chroma_height = static_cast<size_t>((height + 1) / 2);
+    planes.y = base;
+    planes.y_stride = static_cast<size_t>(width);
+    planes.u = base + static_cast<size_t>(width) * static_cast<size_t>(height);
+    planes.u_stride = chroma_width;
+    planes.v = planes.u + chroma_width * chroma_height;
+    planes.v_stride = chroma_width;
+    return planes;
+}
+
+void bgrToI420(const uint8_t* bgr, size_t bgr_stride, int width, int height, const I420Planes& dst, int threads) {
+    if (!bgr || width <= 0 || height <= 0) {
+        return;
+    }
+    const int pairs = (height + 1) / 2;
+    auto convert = [&](const cv::Range& range) {
+        for (int pair = range.start; pair < range.end; ++pair) {
+            convertRowPair(bgr, bgr_stride, width, height, dst, pair);
+        }
+    };
+    if (threads == 1) {
+        convert(cv::Range(0, pairs));
+    } else {
+        cv::parallel_for_(cv::Range(0, pairs), convert, threads > 1 ? static_cast<double>(threads) : -1.0);
+    }
+}
+
+void fillOutside(uint8_t* pixels, PixelFormat format, int width, int height, const FrameRect& picture) {
+    if (!pixels || (picture.x == 0 && picture.y == 0 && picture.width == width && picture.height == height)) {
+        return;
+    }
+    if (format == PixelFormat::Bgr24) {
+        fillPlaneOutside(pixels, static_cast<size_t>(width) * 3, width, height, 3, picture, 0);
+        return;
+    }
+    const auto planes = i420Planes(pixels, width, height);
+    fillPlaneOutside(planes.y, planes.y_stride, width, height, 1, picture, 16);
+    const FrameRect chroma {picture.x / 2, picture.y / 2, picture.width / 2, picture.height / 2};
+    fillPlaneOutside(planes.u, planes.u_stride, (width + 1) / 2, (height + 1) / 2, 1, chroma, 128);
+    fillPlaneOutside(planes.v, planes.v_stride, (width + 1) / 2, (height + 1) / 2, 1, chroma, 128);
+}
+
+bool i420ToBgr(const uint8_t* i420, int width, int height, uint8_t* bgr) {
+    if (!i420 || !bgr || width <= 0 || height <= 0) {
+        return false;
+    }
+    if ((width % 2) != 0 || (height % 2) != 0) {
+        i420ToBgrScalar(i420, width, height, bgr);
+        return true;
+    }
+    const cv::Mat yuv(height * 3 / 2, width, CV_8UC1, const_cast<uint8_t*>(i420));
+    cv::Mat out(height, width, CV_8UC3, bgr);
+    cv::cvtColor(yuv, out, cv::COLOR_YUV2BGR_I420);
+    return true;
+}
+
+bool ensureBgr(Frame& frame) {
+    if (frame.format == PixelFormat::Bgr24) {
+        return true;
+    }
+    if (frame.pixels.size() < frameBytes(PixelFormat::I420, frame.width, frame.height)) {
+        return false;
+    }
+    FrameBuffer converted;
+    uint8_t* dst = converted.prepare(frameBytes(PixelFormat::Bgr24, frame.width, frame.height));
+    if (!dst || !i420ToBgr(frame.pixels.data(), frame.width, frame.height, dst)) {
+        return false;
+    }
+    frame.pixels = std::move(converted);
+    frame.format = PixelFormat::Bgr24;
+    return true;
+}
+
+} // namespace va::core
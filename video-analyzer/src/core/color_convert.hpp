@@ -0,0 +1,41 @@
+#pragma once
+
+#include "core/utils.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace va::core {
+
+struct I420Planes {
+    uint8_t* y {nullptr};
+    size_t y_stride {0};
+    uint8_t* u {nullptr};
+    size_t u_stride {0};
+    uint8_t* v {nullptr};
+    size_t v_stride {0};
+};
+
+// Plane layout of a tightly packed I420 buffer (see frameBytes()).
+I420Planes i420Planes(uint8_t* base, int width, int height);
+
+// BGR24 -> I420 with BT.601 limited-range coefficients, the matrix libswscale
+// applies to BGR24 -> YUV420P by default. Chroma is taken from the rounded
+// mean of each 2x2 block. The SSE4.1 kernel and the scalar fallback produce
+// identical output. `threads`: 1 converts on the calling thread, 0 lets
+// OpenCV's pool decide, n > 1 splits the rows over n workers.
+void bgrToI420(const uint8_t* bgr, size_t bgr_stride, int width, int height, const I420Planes& dst, int threads = 1);
+
+// I420 -> BGR24 (OpenCV's BT.601 limited-range inverse). Odd sizes take a
+// scalar path with the same coefficients.
+bool i420ToBgr(const uint8_t* i420, int width, int height, uint8_t* bgr);
+
+// Paints the part of a tightly packed width x height frame outside `picture`
+// black (Y 16, U/V 128 for I420); `picture` has even offsets and sizes.
+void fillOutside(uint8_t* pixels, PixelFormat format, int width, int height, const FrameRect& picture);
+
+// Converts `frame` to BGR24 in place when it holds I420, into a new pooled
+// buffer (the I420 pixels may be shared). False for malformed frames.
+bool ensureBgr(Frame& frame);
+
+} // namespace va::core
@@ -1,5 +1,9 @@
 #include "core/engine_manager.hpp"
 
+#include "analyzer/shared_engine.hpp"
+
+#include <exception>
+#include <iterator>
 #include <utility>
 
 namespace va::core {
@@ -37,4 +41,78 @@ EngineRuntimeStatus EngineManager::currentRuntimeStatus() const {
     return runtime_status_;
 }
 
+std::shared_ptr<va::analyzer::SharedInferenceEngine> EngineManager::acquireSharedEngine(const std::string& key,
+                                                                                         const SharedEngineFactory& create) {
+    using EnginePtr = std::shared_ptr<va::analyzer::SharedInferenceEngine>;
+    std::promise<EnginePtr> loaded;
+    std::shared_future<EnginePtr> in_progress;
+    {
+        std::scoped_lock lock(shared_mutex_);
+        for (auto it = shared_engines_.begin(); it != shared_engines_.end();) {
+            const bool idle = it->second.engine.expired() && !it->second.loading.valid();
+            it = idle ? shared_engines_.erase(it) : std::next(it);
+        }
+
+        SharedEngineSlot& slot = shared_engines_[key];
+        if (auto engine = slot.engine.lock()) {
+            return engine;
+        }
+        if (slot.loading.valid()) {
+            in_progress = slot.loading;
+        } else {
+            slot.loading = loaded.get_future().share();
+        }
+    }
+    if (in_progress.valid()) {
+        // Another pipeline is loading this model; share its result.
+        return in_progress.get();
+    }
+
+    // Loading a model takes seconds; other keys stay available meanwhile.
+    EnginePtr engine;
+    try {
+        engine = create ? create() : nullptr;
+    } catch (...) {
+        {
+            std::scoped_lock lock(shared_mutex_);
+            shared_engines_[key].loading = {};
+        }
+        loaded.set_exception(std::current_exception());
+        throw;
+    }
+    {
+        std::scoped_lock lock(shared_mutex_);
+        SharedEngineSlot& slot = shared_engines_[key];
+        slot.loading = {};
+        if (engine) {
+            slot.engine = engine;
+        }
+    }
+    loaded.set_value(engine);
+    return engine;
+}
+
+std::vector<SharedEngineStats> EngineManager::sharedEngineStats() const {
+    std::vector<SharedEngineStats> result;
+    std::scoped_lock lock(shared_mutex_);
+    result.reserve(shared_engines_.size());
+    for (const auto& [key, slot] : shared_engines_) {
+        auto engine = slot.engine.lock();
+        if (!engine) {
+            continue;
+        }
+        const auto stats = engine->stats();
+        SharedEngineStats entry;
+        entry.key = key;
+        entry.clients = stats.sessions;
+        entry.batches = stats.batches;
+        entry.requests = stats.requests;
+        entry.avg_batch_size = stats.avg_batch_size;
+        entry.max_batch_size = stats.max_batch_size;
+        entry.dynamic_batch = stats.dynamic_batch;
+        result.emplace_back(std::move(entry));
+    }
+    return result;
+}
+
 } // namespace va::core
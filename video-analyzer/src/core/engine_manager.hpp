@@ -1,8 +1,17 @@
 #pragma once
 
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
+
+namespace va::analyzer {
+class SharedInferenceEngine;
+}
 
 namespace va::core {
 
@@ -21,6 +30,16 @@ struct EngineRuntimeStatus {
     bool cpu_fallback {false};
 };
 
+struct SharedEngineStats {
+    std::string key;
+    uint64_t clients {0};
+    uint64_t batches {0};
+    uint64_t requests {0};
+    double avg_batch_size {0.0};
+    int max_batch_size {1};
+    bool dynamic_batch {false};
+};
+
 class EngineManager {
 public:
     EngineManager();
@@ -32,10 +51,28 @@ public:
     void updateRuntimeStatus(EngineRuntimeStatus status);
     EngineRuntimeStatus currentRuntimeStatus() const;
 
+    // Returns the live shared engine registered under `key`, or builds one with
+    // `create`. Engines are held weakly and unload with their last analyzer.
+    // The load runs without the registry lock; callers asking for a key that
+    // is still loading wait for that load instead of starting another.
+    using SharedEngineFactory = std::function<std::shared_ptr<va::analyzer::SharedInferenceEngine>()>;
+    std::shared_ptr<va::analyzer::SharedInferenceEngine> acquireSharedEngine(const std::string& key,
+                                                                              const SharedEngineFactory& create);
+    std::vector<SharedEngineStats> sharedEngineStats() const;
+
 private:
     mutable std::mutex mutex_;
     EngineDescriptor current_;
     EngineRuntimeStatus runtime_status_;
+
+    struct SharedEngineSlot {
+        std::weak_ptr<va::analyzer::SharedInferenceEngine> engine;
+        // Valid while the first caller is still running create().
+        std::shared_future<std::shared_ptr<va::analyzer::SharedInferenceEngine>> loading;
+    };
+
+    mutable std::mutex shared_mutex_;
+    std::unordered_map<std::string, SharedEngineSlot> shared_engines_;
 };
 
 } // namespace va::core
@@ -20,6 +20,28 @@ namespace va::core {
 struct SourceConfig {
     std::string stream_id;
     std::string uri;
+    int buffer_depth {2};
+    std::string buffer_policy {"latest"};
+    std::string decoder_impl {"ffmpeg"};   // ffmpeg (libavformat/libavcodec) | opencv (cv::VideoCapture)
+    bool rtsp_prefer_tcp {true};
+    int rtsp_timeout_ms {5000};
+    bool low_delay {true};
+    int decode_threads {0};                // 0: libavcodec decides
+    std::string decode_thread_type {"frame"};
+    std::string pixel_format {"bgr"};     // bgr | i420
+    // Size frames are delivered at, 0 = native; frame_fit says how the
+    // picture goes into it (see core::parseFrameFit()).
+    int target_width {0};
+    int target_height {0};
+    std::string frame_fit {"fit"};         // fit | pad | stretch
+    int frame_stride {1};                  // deliver every Nth decoded frame
+    bool skip_nonref {false};              // decoder drops non-reference frames (stride > 1 only)
+    // Failed opens back off exponentially with jitter; see media::ReconnectOptions.
+    int reconnect_initial_ms {500};
+    int reconnect_max_ms {30000};
+    double reconnect_jitter {0.2};
+    int reconnect_max_attempts {0};
+    int stall_timeout_ms {3000};
 };
 
 struct FilterConfig {
@@ -29,8 +51,25 @@ struct FilterConfig {
     std::string model_path;
     int input_width {0};
     int input_height {0};
+    std::string channel_order {"rgb"};
+    int preprocess_threads {0};
+    std::string nms_method {"hard"};
+    int nms_top_k {1000};
+    int max_detections {300};
+    bool nms_class_agnostic {false};
+    float nms_soft_sigma {0.5f};
+    std::string decode_mode {"simd"};
+    std::string score_activation {"sigmoid"};
+    std::string box_units {"normalized"};
+    bool overlay {true};
+    bool overlay_labels {true};
+    float overlay_mask_alpha {0.45f};
+    int overlay_thickness {2};
     float confidence_threshold {0.0f};
     float iou_threshold {0.0f};
+    std::vector<std::string> class_whitelist;
+    int params_max_detections {0};
+    float mask_threshold {0.5f};
     std::string engine_type;
     std::string engine_provider;
     int device_index {0};
@@ -45,6 +84,10 @@ struct FilterConfig {
     int tensorrt_min_subgraph_size {0};
     std::size_t io_binding_input_bytes {0};
     std::size_t io_binding_output_bytes {0};
+    bool batching_enabled {false};
+    int max_batch_size {1};
+    int max_batch_wait_us {0};
+    int intra_op_threads {1};
 };
 
 struct EncoderConfig {
@@ -59,10 +102,24 @@ struct EncoderConfig {
     std::string tune;
     std::string profile;
     std::string codec {"h264"};
+    // Resolved from the profile's `threads: auto` by the application.
+    int threads {1};
+    std::string thread_type {"slice"}; // "slice" (no added latency) or "frame"
 };
 
 struct TransportConfig {
+    std::string kind {"datachannel"}; // "datachannel" or "rtp" (H.264 video track, WHEP)
     std::string whip_url;
+    int ice_port_min {10000};
+    int ice_port_max {10100};
+};
+
+struct PipelineConfig {
+    std::string execution_mode {"staged"}; // "staged" or "serial"
+    int queue_depth {2};
+    std::string output_mode {"video"};     // "video", "metadata" or "both"
+    std::string metadata_format {"binary"}; // "binary" or "json"
+    int metadata_keyframe_interval {30};
 };
 
 struct Factories {
@@ -1,7 +1,8 @@
 #include "core/logger.hpp"
 
+#include "core/utils.hpp"
+
 #include <algorithm>
-#include <cctype>
 #include <cstdio>
 #include <filesystem>
 #include <iomanip>
@@ -11,18 +12,6 @@ namespace fs = std::filesystem;
 
 namespace va::core {
 
-namespace {
-
-std::string toLowerCopy(const std::string& value) {
-    std::string result(value.size(), '\0');
-    std::transform(value.begin(), value.end(), result.begin(), [](unsigned char c) {
-        return static_cast<char>(std::tolower(c));
-    });
-    return result;
-}
-
-}
-
 Logger::Stream::Stream(Logger& logger, LogLevel level)
     : logger_(&logger), level_(level) {}
 
@@ -180,7 +169,7 @@ void Logger::rotateIfNeeded(size_t incoming_bytes) {
 }
 
 LogLevel Logger::parseLevel(const std::string& level) const {
-    const auto value = toLowerCopy(level);
+    const auto value = toLower(level);
     if (value == "trace") return LogLevel::Trace;
     if (value == "debug") return LogLevel::Debug;
     if (value == "info")  return LogLevel::Info;
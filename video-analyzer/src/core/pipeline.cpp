@@ -1,27 +1,95 @@
 #include "core/pipeline.hpp"
 
 #include "analyzer/analyzer.hpp"
+#include "core/color_convert.hpp"
+#include "core/utils.hpp"
 #include "media/source.hpp"
 #include "media/encoder.hpp"
 #include "media/transport.hpp"
 
+#include <algorithm>
 #include <chrono>
 #include <thread>
 
 namespace va::core {
 
+namespace {
+
+constexpr const char* kStageNames[] = {"decode", "preprocess", "infer", "encode", "send"};
+// Upper bound on one blocking read; stop() interrupts it sooner.
+constexpr auto kReadTimeout = std::chrono::milliseconds(1000);
+
+bool isSerialMode(const std::string& mode) {
+    return toLower(mode) == "serial";
+}
+
+size_t queueDepth(const PipelineConfig& config) {
+    return config.queue_depth > 0 ? static_cast<size_t>(config.queue_depth) : 2;
+}
+
+} // namespace
+
+OutputMode parseOutputMode(const std::string& value) {
+    const std::string lower = toLower(value);
+    if (lower == "metadata" || lower == "meta") {
+        return OutputMode::Metadata;
+    }
+    if (lower == "both") {
+        return OutputMode::Both;
+    }
+    return OutputMode::Video;
+}
+
+const char* outputModeName(OutputMode mode) {
+    switch (mode) {
+    case OutputMode::Metadata:
+        return "metadata";
+    case OutputMode::Both:
+        return "both";
+    case OutputMode::Video:
+    default:
+        return "video";
+    }
+}
+
+struct Pipeline::WorkItem {
+    core::Frame frame;
+    // BGR copy of an I420 frame: converted once for the preprocessor and
+    // drawn on by the renderer when there is something to draw.
+    core::Frame bgr;
+    std::vector<float> tensor_storage;
+    core::TensorView tensor;
+    core::LetterboxMeta meta;
+    core::ModelOutput output;
+    core::Frame rendered;
+    va::media::IEncoder::Packet packet;
+    std::vector<uint8_t> metadata;
+    bool metadata_keyframe {false};
+    double started_ms {0.0};
+};
+
 Pipeline::Pipeline(std::shared_ptr<va::media::ISwitchableSource> source,
                    std::shared_ptr<va::analyzer::Analyzer> analyzer,
                    std::shared_ptr<va::media::IEncoder> encoder,
                    std::shared_ptr<va::media::ITransport> transport,
                    std::string stream_id,
-                   std::string profile_id)
+                   std::string profile_id,
+                   PipelineConfig config)
     : source_(std::move(source)),
       analyzer_(std::move(analyzer)),
       encoder_(std::move(encoder)),
       transport_(std::move(transport)),
+      config_(std::move(config)),
+      staged_(!isSerialMode(config_.execution_mode)),
+      output_mode_(parseOutputMode(config_.output_mode)),
+      metadata_format_(va::media::parseMetadataFormat(config_.metadata_format)),
+      metadata_encoder_(va::media::DetectionEncoder::Options{config_.metadata_keyframe_interval}),
       stream_id_(std::move(stream_id)),
-      profile_id_(std::move(profile_id)) {
+      profile_id_(std::move(profile_id)),
+      preprocess_queue_(queueDepth(config_)),
+      infer_queue_(queueDepth(config_)),
+      encode_queue_(queueDepth(config_)),
+      send_queue_(queueDepth(config_)) {
     track_id_ = stream_id_ + ":" + profile_id_;
 }
 
@@ -40,12 +108,36 @@ void Pipeline::start() {
     avg_latency_ms_.store(0.0);
     fps_.store(0.0);
     last_timestamp_ms_.store(0.0);
+    for (auto& latency : stage_latency_ms_) {
+        latency.store(0.0);
+    }
+    render_latency_ms_.store(0.0);
+    encode_latency_ms_.store(0.0);
+    metadata_encoder_.requestKeyframe();
 
     if (source_) {
         source_->start();
     }
 
-    worker_ = std::thread(&Pipeline::run, this);
+    if (!staged_) {
+        worker_ = std::thread(&Pipeline::run, this);
+        return;
+    }
+
+    preprocess_queue_.open();
+    infer_queue_.open();
+    encode_queue_.open();
+    send_queue_.open();
+
+    stage_workers_.emplace_back(&Pipeline::runDecodeStage, this);
+    stage_workers_.emplace_back(&Pipeline::runStage, this, StagePreprocess,
+                                std::ref(preprocess_queue_), &infer_queue_, &Pipeline::preprocessItem);
+    stage_workers_.emplace_back(&Pipeline::runStage, this, StageInfer,
+                                std::ref(infer_queue_), &encode_queue_, &Pipeline::inferItem);
+    stage_workers_.emplace_back(&Pipeline::runStage, this, StageEncode,
+                                std::ref(encode_queue_), &send_queue_, &Pipeline::encodeItem);
+    stage_workers_.emplace_back(&Pipeline::runStage, this, StageSend,
+                                std::ref(send_queue_), nullptr, &Pipeline::sendItem);
 }
 
 void Pipeline::stop() {
@@ -54,9 +146,25 @@ void Pipeline::stop() {
         return;
     }
 
+    // Release the worker blocked in readFor() before joining it; the source
+    // itself is stopped after the workers.
+    if (source_) {
+        source_->interruptReads();
+    }
+    preprocess_queue_.close();
+    infer_queue_.close();
+    encode_queue_.close();
+    send_queue_.close();
+
     if (worker_.joinable()) {
         worker_.join();
     }
+    for (auto& stage_worker : stage_workers_) {
+        if (stage_worker.joinable()) {
+            stage_worker.join();
+        }
+    }
+    stage_workers_.clear();
 
     if (source_) {
         source_->stop();
@@ -82,6 +190,10 @@ va::analyzer::Analyzer* Pipeline::analyzer() {
     return analyzer_.get();
 }
 
+va::media::ITransport* Pipeline::transport() {
+    return transport_.get();
+}
+
 Pipeline::Metrics Pipeline::metrics() const {
     Metrics m;
     m.fps = fps_.load();
@@ -89,6 +201,34 @@ Pipeline::Metrics Pipeline::metrics() const {
     m.last_processed_ms = last_timestamp_ms_.load();
     m.processed_frames = processed_frames_.load();
     m.dropped_frames = dropped_frames_.load();
+    m.execution_mode = staged_ ? "staged" : "serial";
+    m.output_mode = outputModeName(output_mode_);
+    m.metadata_format = va::media::metadataFormatName(metadata_format_);
+    m.avg_render_ms = render_latency_ms_.load();
+    m.avg_encode_ms = encode_latency_ms_.load();
+    if (encoder_) {
+        m.encoder_bitrate_kbps = encoder_->bitrateKbps();
+        m.encoder_fps = encoder_->framerate();
+    }
+
+    const WorkQueue* inputs[StageCount] = {nullptr, &preprocess_queue_, &infer_queue_, &encode_queue_, &send_queue_};
+    m.stages.reserve(StageCount);
+    for (size_t stage = 0; stage < StageCount; ++stage) {
+        StageMetrics sm;
+        sm.name = kStageNames[stage];
+        sm.avg_latency_ms = stage_latency_ms_[stage].load();
+        if (stage == StageDecode) {
+            if (source_) {
+                const auto source_stats = source_->stats();
+                sm.queue_depth = source_stats.buffered_frames;
+                sm.queue_capacity = source_stats.buffer_capacity;
+            }
+        } else if (staged_) {
+            sm.queue_depth = inputs[stage]->size();
+            sm.queue_capacity = inputs[stage]->capacity();
+        }
+        m.stages.emplace_back(std::move(sm));
+    }
     return m;
 }
 
@@ -126,55 +266,209 @@ va::media::ITransport::Stats Pipeline::transportStats() const {
     return transport_->stats();
 }
 
+va::media::SourceStats Pipeline::sourceStats() const {
+    if (!source_) {
+        return {};
+    }
+    return source_->stats();
+}
+
 void Pipeline::run() {
+    WorkItem item;
     while (running_.load()) {
-        core::Frame frame;
-        if (!pullFrame(frame)) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        const double pull_start_ms = ms_now();
+        if (!pullFrame(item.frame)) {
             continue;
         }
+        item.started_ms = ms_now();
+        recordStageLatency(StageDecode, pullLatency(item, pull_start_ms));
 
-        const double start_ms = ms_now();
-        if (processFrame(frame)) {
-            const double latency_ms = ms_now() - start_ms;
-            recordFrameProcessed(latency_ms);
+        const bool ok = timedStage(StagePreprocess, item, &Pipeline::preprocessItem)
+            && timedStage(StageInfer, item, &Pipeline::inferItem)
+            && timedStage(StageEncode, item, &Pipeline::encodeItem)
+            && timedStage(StageSend, item, &Pipeline::sendItem);
+        if (ok) {
+            recordFrameProcessed(ms_now() - item.started_ms);
         } else {
             recordFrameDropped();
         }
     }
 }
 
+void Pipeline::runDecodeStage() {
+    while (running_.load()) {
+        WorkItemPtr item = acquireItem();
+        const double pull_start_ms = ms_now();
+        if (!pullFrame(item->frame)) {
+            releaseItem(std::move(item));
+            continue;
+        }
+        item->started_ms = ms_now();
+        recordStageLatency(StageDecode, pullLatency(*item, pull_start_ms));
+        if (!preprocess_queue_.push(std::move(item))) {
+            break;
+        }
+    }
+}
+
+void Pipeline::runStage(Stage stage, WorkQueue& input, WorkQueue* output, StageFn fn) {
+    WorkItemPtr item;
+    while (input.pop(item)) {
+        if (!timedStage(stage, *item, fn)) {
+            recordFrameDropped();
+            releaseItem(std::move(item));
+            continue;
+        }
+        if (output) {
+            if (!output->push(std::move(item))) {
+                break;
+            }
+            continue;
+        }
+        recordFrameProcessed(ms_now() - item->started_ms);
+        releaseItem(std::move(item));
+    }
+}
+
 bool Pipeline::pullFrame(core::Frame& frame) {
     if (!source_) {
         return false;
     }
-    bool ok = source_->read(frame);
-    if (ok) {
-        frame.pts_ms = ms_now();
+    // Blocks until the source has a frame, so an idle or dead stream costs
+    // one wakeup per kReadTimeout instead of a poll every few ms.
+    bool ok = source_->readFor(frame, kReadTimeout);
+    if (ok && frame.capture_ms <= 0.0) {
+        frame.capture_ms = ms_now();
     }
     return ok;
 }
 
-bool Pipeline::processFrame(const core::Frame& in) {
+double Pipeline::pullLatency(const WorkItem& item, double pull_start_ms) const {
+    // Time spent waiting for the stream to produce the frame is not decode
+    // cost; count from when it was ready (or from the call, if it already was).
+    return item.started_ms - std::max(pull_start_ms, item.frame.capture_ms);
+}
+
+bool Pipeline::preprocessItem(WorkItem& item) {
+    item.bgr = core::Frame{};
     if (!analyzer_) {
         return false;
     }
+    if (item.frame.format != core::PixelFormat::Bgr24) {
+        item.bgr = item.frame;
+        if (!core::ensureBgr(item.bgr)) {
+            return false;
+        }
+        return analyzer_->preprocess(item.bgr, item.tensor_storage, item.tensor, item.meta);
+    }
+    return analyzer_->preprocess(item.frame, item.tensor_storage, item.tensor, item.meta);
+}
+
+bool Pipeline::inferItem(WorkItem& item) {
+    item.output.boxes.clear();
+    item.output.masks.clear();
+    item.output.track_ids.clear();
+    return analyzer_->infer(item.tensor, item.meta, item.output);
+}
+
+bool Pipeline::encodeItem(WorkItem& item) {
+    item.packet.data.reset();
+    item.metadata.clear();
+    if (outputsMetadata(output_mode_)) {
+        va::media::DetectionFrameInfo info;
+        info.stream_id = track_id_;
+        info.pts_ms = item.frame.pts_ms;
+        info.width = item.frame.width;
+        info.height = item.frame.height;
+        if (metadata_format_ == va::media::MetadataFormat::Json) {
+            va::media::encodeDetectionsJson(info, item.output, item.metadata);
+            item.metadata_keyframe = true;
+        } else {
+            metadata_encoder_.encode(info, item.output, item.metadata);
+            item.metadata_keyframe = metadata_encoder_.lastWasKeyframe();
+        }
+    }
+    if (!outputsVideo(output_mode_)) {
+        item.bgr = core::Frame{};
+        return true;
+    }
 
-    core::Frame analyzed;
-    if (!analyzer_->analyze(in, analyzed)) {
+    // The decoded frame is not needed after this stage, so its buffer is handed
+    // to the renderer instead of being copied. An I420 frame with boxes is
+    // drawn on its BGR copy; without boxes it reaches the encoder as decoded.
+    if (!item.output.boxes.empty() && !item.bgr.pixels.empty()) {
+        item.rendered = std::move(item.bgr);
+    } else {
+        item.rendered = std::move(item.frame);
+    }
+    item.bgr = core::Frame{};
+    const double render_start_ms = ms_now();
+    if (!analyzer_->renderInPlace(item.rendered, item.output)) {
         return false;
     }
+    const double render_ms = ms_now() - render_start_ms;
+    const double prev_render_ms = render_latency_ms_.load();
+    render_latency_ms_.store(prev_render_ms == 0.0 ? render_ms : prev_render_ms + (render_ms - prev_render_ms) / 10.0);
 
-    va::media::IEncoder::Packet packet;
-    if (encoder_) {
-        if (!encoder_->encode(analyzed, packet)) {
-            return false;
-        }
-        if (transport_ && !packet.data.empty()) {
-            transport_->send(track_id_, packet.data.data(), packet.data.size());
-        }
+    if (!encoder_) {
+        return true;
+    }
+    const double encode_start_ms = ms_now();
+    if (!encoder_->encode(item.rendered, item.packet)) {
+        return false;
+    }
+    if (!item.packet.data.empty()) {
+        const double encode_ms = ms_now() - encode_start_ms;
+        const double prev_encode_ms = encode_latency_ms_.load();
+        encode_latency_ms_.store(prev_encode_ms == 0.0 ? encode_ms : prev_encode_ms + (encode_ms - prev_encode_ms) / 10.0);
+    }
+    return true;
+}
+
+bool Pipeline::sendItem(WorkItem& item) {
+    if (!transport_) {
+        return true;
+    }
+    if (!item.packet.data.empty()) {
+        transport_->send(track_id_, item.packet.data, item.packet.keyframe);
+    }
+    if (!item.metadata.empty()) {
+        transport_->sendMetadata(track_id_, item.metadata.data(), item.metadata.size(), item.metadata_keyframe);
     }
     return true;
 }
 
+bool Pipeline::timedStage(Stage stage, WorkItem& item, StageFn fn) {
+    const double start_ms = ms_now();
+    const bool ok = (this->*fn)(item);
+    recordStageLatency(stage, ms_now() - start_ms);
+    return ok;
+}
+
+void Pipeline::recordStageLatency(Stage stage, double latency_ms) {
+    auto& slot = stage_latency_ms_[stage];
+    const double prev = slot.load();
+    slot.store(prev == 0.0 ? latency_ms : prev + (latency_ms - prev) / 10.0);
+}
+
+Pipeline::WorkItemPtr Pipeline::acquireItem() {
+    {
+        std::scoped_lock lock(free_items_mutex_);
+        if (!free_items_.empty()) {
+            WorkItemPtr item = std::move(free_items_.back());
+            free_items_.pop_back();
+            return item;
+        }
+    }
+    return std::make_unique<WorkItem>();
+}
+
+void Pipeline::releaseItem(WorkItemPtr item) {
+    if (!item) {
+        return;
+    }
+    std::scoped_lock lock(free_items_mutex_);
+    free_items_.emplace_back(std::move(item));
+}
+
 } // namespace va::core
@@ -1,15 +1,21 @@
 #pragma once
 
+#include "core/factories.hpp"
+#include "core/stage_queue.hpp"
 #include "core/utils.hpp"
+#include "media/detection_codec.hpp"
+#include "media/source.hpp"
 #include "media/transport.hpp"
 
+#include <array>
 #include <atomic>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <thread>
+#include <vector>
 
 namespace va::media {
-class ISwitchableSource;
 class IEncoder;
 }
 
@@ -19,6 +25,19 @@ class Analyzer;
 
 namespace va::core {
 
+// What a pipeline publishes per frame. Metadata mode sends detection records
+// only and never renders or encodes.
+enum class OutputMode {
+    Video,
+    Metadata,
+    Both
+};
+
+OutputMode parseOutputMode(const std::string& value);
+const char* outputModeName(OutputMode mode);
+inline bool outputsVideo(OutputMode mode) { return mode != OutputMode::Metadata; }
+inline bool outputsMetadata(OutputMode mode) { return mode != OutputMode::Video; }
+
 class Pipeline {
 public:
     Pipeline(std::shared_ptr<va::media::ISwitchableSource> source,
@@ -26,7 +45,8 @@ public:
              std::shared_ptr<va::media::IEncoder> encoder,
              std::shared_ptr<va::media::ITransport> transport,
              std::string stream_id,
-             std::string profile_id);
+             std::string profile_id,
+             PipelineConfig config = {});
     ~Pipeline();
 
     void start();
@@ -35,43 +55,106 @@ public:
 
     va::media::ISwitchableSource* source();
     va::analyzer::Analyzer* analyzer();
+    va::media::ITransport* transport();
     const std::string& streamId() const { return stream_id_; }
     const std::string& profileId() const { return profile_id_; }
 
+    struct StageMetrics {
+        std::string name;
+        double avg_latency_ms {0.0};
+        uint64_t queue_depth {0};
+        uint64_t queue_capacity {0};
+    };
+
     struct Metrics {
         double fps {0.0};
         double avg_latency_ms {0.0};
         double last_processed_ms {0.0};
+        // Overlay drawing, part of the encode stage's latency.
+        double avg_render_ms {0.0};
+        // Encoder call per emitted packet (moving average), also part of the
+        // encode stage; frames dropped by the encoder are not counted.
+        double avg_encode_ms {0.0};
+        // Encoder rate in effect after transport feedback; 0 without an
+        // encoder or when it cannot tell.
+        int encoder_bitrate_kbps {0};
+        int encoder_fps {0};
         uint64_t processed_frames {0};
         uint64_t dropped_frames {0};
+        std::string execution_mode;
+        std::string output_mode;
+        std::string metadata_format;
+        std::vector<StageMetrics> stages;
     };
 
     Metrics metrics() const;
     void recordFrameProcessed(double latency_ms);
     void recordFrameDropped();
     va::media::ITransport::Stats transportStats() const;
+    va::media::SourceStats sourceStats() const;
 
 private:
+    enum Stage : size_t {
+        StageDecode = 0,
+        StagePreprocess,
+        StageInfer,
+        StageEncode,
+        StageSend,
+        StageCount
+    };
+
+    struct WorkItem;
+    using WorkItemPtr = std::unique_ptr<WorkItem>;
+    using WorkQueue = StageQueue<WorkItemPtr>;
+    using StageFn = bool (Pipeline::*)(WorkItem&);
+
     void run();
+    void runDecodeStage();
+    void runStage(Stage stage, WorkQueue& input, WorkQueue* output, StageFn fn);
     bool pullFrame(core::Frame& frame);
-    bool processFrame(const core::Frame& in);
+    double pullLatency(const WorkItem& item, double pull_start_ms) const;
+    bool preprocessItem(WorkItem& item);
+    bool inferItem(WorkItem& item);
+    bool encodeItem(WorkItem& item);
+    bool sendItem(WorkItem& item);
+    bool timedStage(Stage stage, WorkItem& item, StageFn fn);
+    void recordStageLatency(Stage stage, double latency_ms);
+    WorkItemPtr acquireItem();
+    void releaseItem(WorkItemPtr item);
 
     std::shared_ptr<va::media::ISwitchableSource> source_;
     std::shared_ptr<va::analyzer::Analyzer> analyzer_;
     std::shared_ptr<va::media::IEncoder> encoder_;
     std::shared_ptr<va::media::ITransport> transport_;
+    PipelineConfig config_;
+    bool staged_ {true};
+    OutputMode output_mode_ {OutputMode::Video};
+    va::media::MetadataFormat metadata_format_ {va::media::MetadataFormat::Binary};
+    // Owned by the encode stage; binary records are deltas against its state.
+    va::media::DetectionEncoder metadata_encoder_;
     std::atomic<bool> running_ {false};
     std::thread worker_;
+    std::vector<std::thread> stage_workers_;
     std::mutex mutex_;
     std::string stream_id_;
     std::string profile_id_;
     std::string track_id_;
 
+    WorkQueue preprocess_queue_;
+    WorkQueue infer_queue_;
+    WorkQueue encode_queue_;
+    WorkQueue send_queue_;
+    std::mutex free_items_mutex_;
+    std::vector<WorkItemPtr> free_items_;
+
     std::atomic<uint64_t> processed_frames_ {0};
     std::atomic<uint64_t> dropped_frames_ {0};
     std::atomic<double> avg_latency_ms_ {0.0};
     std::atomic<double> fps_ {0.0};
     std::atomic<double> last_timestamp_ms_ {0.0};
+    std::array<std::atomic<double>, StageCount> stage_latency_ms_ {};
+    std::atomic<double> render_latency_ms_ {0.0};
+    std::atomic<double> encode_latency_ms_ {0.0};
 };
 
 } // namespace va::core
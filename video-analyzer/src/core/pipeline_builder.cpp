@@ -7,6 +7,8 @@
 
 #include "core/logger.hpp"
 
+#include <algorithm>
+
 namespace va::core {
 
 PipelineBuilder::PipelineBuilder(const Factories& factories, EngineManager& engine_manager)
@@ -15,10 +17,13 @@ PipelineBuilder::PipelineBuilder(const Factories& factories, EngineManager& engi
 std::shared_ptr<Pipeline> PipelineBuilder::build(const SourceConfig& source_cfg,
                                                  const FilterConfig& filter_cfg,
                                                  const EncoderConfig& encoder_cfg,
-                                                 const TransportConfig& transport_cfg) const {
+                                                 const TransportConfig& transport_cfg,
+                                                 const PipelineConfig& pipeline_cfg) const {
     auto source = factories_.make_source ? factories_.make_source(source_cfg) : nullptr;
     auto analyzer = factories_.make_filter ? factories_.make_filter(filter_cfg) : nullptr;
-    auto encoder = factories_.make_encoder ? factories_.make_encoder(encoder_cfg) : nullptr;
+    // Metadata-only pipelines never encode, so no encoder is created or opened.
+    const bool needs_encoder = outputsVideo(parseOutputMode(pipeline_cfg.output_mode));
+    auto encoder = needs_encoder && factories_.make_encoder ? factories_.make_encoder(encoder_cfg) : nullptr;
     auto transport = factories_.make_transport ? factories_.make_transport(transport_cfg) : nullptr;
 
     if (!source) {
@@ -29,7 +34,7 @@ std::shared_ptr<Pipeline> PipelineBuilder::build(const SourceConfig& source_cfg,
         VA_LOG_ERROR() << "[PipelineBuilder] failed to create analyzer for model " << filter_cfg.model_id;
         return nullptr;
     }
-    if (!encoder) {
+    if (needs_encoder && !encoder) {
         VA_LOG_ERROR() << "[PipelineBuilder] failed to create encoder for stream " << source_cfg.stream_id;
         return nullptr;
     }
@@ -37,27 +42,73 @@ std::shared_ptr<Pipeline> PipelineBuilder::build(const SourceConfig& source_cfg,
         VA_LOG_ERROR() << "[PipelineBuilder] failed to create transport for stream " << source_cfg.stream_id;
         return nullptr;
     }
+    if (transport_cfg.kind == "rtp" && needs_encoder && encoder_cfg.codec != "h264") {
+        VA_LOG_ERROR() << "[PipelineBuilder] rtp transport needs encoder codec h264, profile has " << encoder_cfg.codec;
+        return nullptr;
+    }
 
     (void)engine_manager_; // future use for binding execution providers
 
-    va::media::IEncoder::Settings encoder_settings;
-    encoder_settings.width = encoder_cfg.width;
-    encoder_settings.height = encoder_cfg.height;
-    encoder_settings.fps = encoder_cfg.fps;
-    encoder_settings.bitrate_kbps = encoder_cfg.bitrate_kbps;
-    encoder_settings.gop = encoder_cfg.gop;
-    encoder_settings.bframes = encoder_cfg.bframes;
-    encoder_settings.zero_latency = encoder_cfg.zero_latency;
-    encoder_settings.preset = encoder_cfg.preset;
-    encoder_settings.tune = encoder_cfg.tune;
-    encoder_settings.profile = encoder_cfg.profile;
-    encoder_settings.codec = encoder_cfg.codec;
+    // With a frame stride the source delivers 1/N of the camera's frames, and
+    // the encoder has to time its pictures accordingly.
+    const int encoder_fps = encoder_cfg.fps > 0 ? std::max(1, encoder_cfg.fps / std::max(1, source_cfg.frame_stride))
+                                                : encoder_cfg.fps;
 
-    if (!encoder->open(encoder_settings)) {
-        VA_LOG_ERROR() << "[PipelineBuilder] encoder open failed for stream " << source_cfg.stream_id
-                       << " (" << encoder_settings.width << "x" << encoder_settings.height << "@" << encoder_settings.fps
-                       << ", codec=" << encoder_settings.codec << ")";
-        return nullptr;
+    if (encoder) {
+        va::media::IEncoder::Settings encoder_settings;
+        encoder_settings.width = encoder_cfg.width;
+        encoder_settings.height = encoder_cfg.height;
+        encoder_settings.fps = encoder_fps;
+        encoder_settings.bitrate_kbps = encoder_cfg.bitrate_kbps;
+        encoder_settings.gop = encoder_cfg.gop;
+        encoder_settings.bframes = encoder_cfg.bframes;
+        encoder_settings.zero_latency = encoder_cfg.zero_latency;
+        encoder_settings.preset = encoder_cfg.preset;
+        encoder_settings.tune = encoder_cfg.tune;
+        encoder_settings.profile = encoder_cfg.profile;
+        encoder_settings.codec = encoder_cfg.codec;
+        encoder_settings.threads = encoder_cfg.threads;
+        encoder_settings.thread_type = encoder_cfg.thread_type;
+
+        if (!encoder->open(encoder_settings)) {
+            VA_LOG_ERROR() << "[PipelineBuilder] encoder open failed for stream " << source_cfg.stream_id
+                           << " (" << encoder_settings.width << "x" << encoder_settings.height << "@" << encoder_settings.fps
+                           << ", codec=" << encoder_settings.codec << ")";
+            return nullptr;
+        }
+        VA_LOG_INFO() << "[PipelineBuilder] encoder for stream " << source_cfg.stream_id << ": "
+                      << encoder_settings.width << "x" << encoder_settings.height << "@" << encoder_settings.fps
+                      << ", codec=" << encoder_settings.codec << ", " << encoder_settings.threads << " "
+                      << encoder_settings.thread_type << " thread(s)";
+    }
+
+    if (encoder) {
+        // Viewers ask for a keyframe when they join or lose the picture, and
+        // the transport scales the rate down while they cannot keep up.
+        std::weak_ptr<va::media::IEncoder> weak_encoder = encoder;
+        va::media::ITransport::EncoderFeedback feedback;
+        feedback.request_keyframe = [weak_encoder]() {
+            if (auto target = weak_encoder.lock()) {
+                target->requestKeyframe();
+            }
+        };
+        const int base_kbps = encoder_cfg.bitrate_kbps;
+        const int base_fps = encoder_fps;
+        feedback.rate_scale = [weak_encoder, base_kbps, base_fps](double scale) {
+            auto target = weak_encoder.lock();
+            if (!target) {
+                return;
+            }
+            if (base_kbps > 0) {
+                target->setBitrate(std::max(1, static_cast<int>(base_kbps * scale + 0.5)));
+            }
+            // Below half the bitrate, fewer but sharper pictures read better
+            // than a full frame rate of mush.
+            if (base_fps > 1) {
+                target->setFramerate(scale < 0.5 ? base_fps / 2 : base_fps);
+            }
+        };
+        transport->setEncoderFeedback(std::move(feedback));
     }
 
     const std::string endpoint = transport_cfg.whip_url.empty() ? std::string() : transport_cfg.whip_url;
@@ -71,7 +122,8 @@ std::shared_ptr<Pipeline> PipelineBuilder::build(const SourceConfig& source_cfg,
                                                std::move(encoder),
                                                std::move(transport),
                                                source_cfg.stream_id,
-                                               filter_cfg.profile_id);
+                                               filter_cfg.profile_id,
+                                               pipeline_cfg);
     return pipeline;
 }
 
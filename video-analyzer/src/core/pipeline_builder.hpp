@@ -15,7 +15,8 @@ public:
     std::shared_ptr<Pipeline> build(const SourceConfig& source_cfg,
                                     const FilterConfig& filter_cfg,
                                     const EncoderConfig& encoder_cfg,
-                                    const TransportConfig& transport_cfg) const;
+                                    const TransportConfig& transport_cfg,
+                                    const PipelineConfig& pipeline_cfg = {}) const;
 
 private:
     const Factories& factories_;
@@ -0,0 +1,45 @@
+#include "core/rate_limiter.hpp"
+
+#include "core/utils.hpp"
+
+#include <iterator>
+
+namespace va::core {
+
+namespace {
+// Entries older than one interval no longer limit anything; they are pruned
+// once the map grows past this many keys.
+constexpr size_t kPruneThreshold = 1024;
+}
+
+KeyedRateLimiter::KeyedRateLimiter(double per_sec) {
+    setRate(per_sec);
+}
+
+void KeyedRateLimiter::setRate(double per_sec) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    min_interval_ms_ = per_sec > 0.0 ? 1000.0 / per_sec : 0.0;
+}
+
+bool KeyedRateLimiter::tryAcquire(const std::string& key, double& retry_after_ms) {
+    retry_after_ms = 0.0;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (min_interval_ms_ <= 0.0) {
+        return true;
+    }
+    const double now = ms_now();
+    auto it = last_admitted_ms_.find(key);
+    if (it != last_admitted_ms_.end() && now - it->second < min_interval_ms_) {
+        retry_after_ms = min_interval_ms_ - (now - it->second);
+        return false;
+    }
+    if (it == last_admitted_ms_.end() && last_admitted_ms_.size() >= kPruneThreshold) {
+        for (auto prune = last_admitted_ms_.begin(); prune != last_admitted_ms_.end();) {
+            prune = now - prune->second >= min_interval_ms_ ? last_admitted_ms_.erase(prune) : std::next(prune);
+        }
+    }
+    last_admitted_ms_[key] = now;
+    return true;
+}
+
+} // namespace va::core
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace va::core {
+
+// Admits at most `per_sec` events per key by keeping admitted events at least
+// 1 / per_sec apart. A rate of 0 (or less) admits everything.
+class KeyedRateLimiter {
+public:
+    explicit KeyedRateLimiter(double per_sec = 0.0);
+
+    void setRate(double per_sec);
+
+    // True when an event for `key` is admitted now. Otherwise `retry_after_ms`
+    // holds the wait until the next one would be.
+    bool tryAcquire(const std::string& key, double& retry_after_ms);
+
+private:
+    std::mutex mutex_;
+    double min_interval_ms_ {0.0};
+    std::unordered_map<std::string, double> last_admitted_ms_;
+};
+
+} // namespace va::core
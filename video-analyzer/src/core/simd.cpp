@@ -0,0 +1,42 @@
+#include "core/simd.hpp"
+
+#if defined(VA_SIMD_SSE41) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace va::core::simd {
+
+namespace {
+
+CpuFeatures detect() {
+    CpuFeatures features;
+#if defined(VA_SIMD_SSE41) && defined(_MSC_VER)
+    int regs[4] = {0, 0, 0, 0};
+    __cpuid(regs, 0);
+    const int max_leaf = regs[0];
+    __cpuid(regs, 1);
+    features.sse41 = (regs[2] & (1 << 19)) != 0;
+    const bool fma = (regs[2] & (1 << 12)) != 0;
+    const bool osxsave = (regs[2] & (1 << 27)) != 0;
+    const bool ymm_state = osxsave && (_xgetbv(0) & 0x6) == 0x6;
+    if (max_leaf >= 7) {
+        __cpuidex(regs, 7, 0);
+        features.avx2 = fma && ymm_state && (regs[1] & (1 << 5)) != 0;
+    }
+#elif defined(VA_SIMD_SSE41)
+    // Also checks that the OS saves the YMM registers.
+    __builtin_cpu_init();
+    features.sse41 = __builtin_cpu_supports("sse4.1");
+    features.avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+    return features;
+}
+
+} // namespace
+
+const CpuFeatures& cpuFeatures() {
+    static const CpuFeatures features = detect();
+    return features;
+}
+
+} // namespace va::core::simd
@@ -0,0 +1,45 @@
+#pragma once
+
+// SIMD selection shared by the hot CPU kernels. On x86 the SSE4.1 and AVX2/FMA
+// variants are compiled into every build through per-function target
+// attributes (VA_TARGET_SSE41 / VA_TARGET_AVX2), whatever the baseline
+// architecture, and picked at run time with simd::hasSse41() / hasAvx2(), so
+// one binary runs on any x86-64 CPU. The VA_ENABLE_AVX2 CMake option
+// (VA_SIMD_NO_AVX2 when off) leaves the AVX2 variants out. Every kernel keeps
+// a scalar path for other targets.
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define VA_SIMD_SSE41 1
+#if !defined(VA_SIMD_NO_AVX2)
+#define VA_SIMD_AVX2 1
+#endif
+#include <immintrin.h>
+#endif
+
+#if defined(VA_SIMD_SSE41) && (defined(__GNUC__) || defined(__clang__))
+#define VA_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define VA_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+// MSVC emits any intrinsic without /arch flags.
+#define VA_TARGET_SSE41
+#define VA_TARGET_AVX2
+#endif
+
+namespace va::core::simd {
+
+struct CpuFeatures {
+    bool sse41 {false};
+    bool avx2 {false}; // AVX2 and FMA, with OS support for the YMM state
+};
+
+// Detected once, on first use.
+const CpuFeatures& cpuFeatures();
+
+inline bool hasSse41() {
+    return cpuFeatures().sse41;
+}
+
+inline bool hasAvx2() {
+    return cpuFeatures().avx2;
+}
+
+} // namespace va::core::simd
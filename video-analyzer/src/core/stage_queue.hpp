@@ -0,0 +1,79 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+namespace va::core {
+
+// Bounded blocking hand-off between two pipeline stages: a std::deque guarded
+// by a mutex, with one condition variable per side. Each queue has a single
+// producer and a single consumer in the staged pipeline, but the queue itself
+// does not depend on that. push() blocks while full and pop() blocks while
+// empty; close() releases both sides so stage workers can drain and exit.
+template <typename T>
+class StageQueue {
+public:
+    explicit StageQueue(size_t capacity = 2)
+        : capacity_(capacity > 0 ? capacity : 1) {}
+
+    bool push(T value) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [this]() { return closed_ || items_.size() < capacity_; });
+        if (closed_) {
+            return false;
+        }
+        items_.push_back(std::move(value));
+        lock.unlock();
+        not_empty_.notify_one();
+        return true;
+    }
+
+    bool pop(T& value) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this]() { return closed_ || !items_.empty(); });
+        if (items_.empty()) {
+            return false;
+        }
+        value = std::move(items_.front());
+        items_.pop_front();
+        lock.unlock();
+        not_full_.notify_one();
+        return true;
+    }
+
+    void open() {
+        std::scoped_lock lock(mutex_);
+        items_.clear();
+        closed_ = false;
+    }
+
+    void close() {
+        {
+            std::scoped_lock lock(mutex_);
+            closed_ = true;
+            items_.clear();
+        }
+        not_full_.notify_all();
+        not_empty_.notify_all();
+    }
+
+    size_t size() const {
+        std::scoped_lock lock(mutex_);
+        return items_.size();
+    }
+
+    size_t capacity() const { return capacity_; }
+
+private:
+    const size_t capacity_;
+    std::deque<T> items_;
+    bool closed_ {false};
+    mutable std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+};
+
+} // namespace va::core
@@ -24,18 +24,35 @@ TrackManager::~TrackManager() {
 std::string TrackManager::subscribe(const SourceConfig& source_cfg,
                                     const FilterConfig& filter_cfg,
                                     const EncoderConfig& encoder_cfg,
-                                    const TransportConfig& transport_cfg) {
-    auto pipeline = builder_.build(source_cfg, filter_cfg, encoder_cfg, transport_cfg);
+                                    const TransportConfig& transport_cfg,
+                                    const PipelineConfig& pipeline_cfg) {
+    const std::string key = makeKey(source_cfg.stream_id, filter_cfg.profile_id);
+
+    // A running pipeline for the same source and model already encodes this
+    // track; further subscribers share its output instead of encoding again.
+    {
+        std::scoped_lock lock(mutex_);
+        auto it = pipelines_.find(key);
+        if (it != pipelines_.end() && it->second.pipeline && it->second.pipeline->isRunning()
+            && it->second.source_uri == source_cfg.uri && it->second.model_id == filter_cfg.model_id) {
+            it->second.subscriptions++;
+            return key;
+        }
+    }
+
+    auto pipeline = builder_.build(source_cfg, filter_cfg, encoder_cfg, transport_cfg, pipeline_cfg);
     if (!pipeline) {
         return {};
     }
 
     pipeline->start();
 
-    const std::string key = makeKey(source_cfg.stream_id, filter_cfg.profile_id);
-
     {
         std::scoped_lock lock(mutex_);
+        int subscriptions = 1;
+        if (auto it = pipelines_.find(key); it != pipelines_.end()) {
+            subscriptions += it->second.subscriptions;
+        }
         pipelines_[key] = PipelineEntry{
             std::move(pipeline),
             va::core::ms_now(),
@@ -44,7 +61,8 @@ std::string TrackManager::subscribe(const SourceConfig& source_cfg,
             source_cfg.uri,
             filter_cfg.model_id,
             filter_cfg.task,
-            encoder_cfg
+            encoder_cfg,
+            subscriptions
         };
     }
 
@@ -55,6 +73,9 @@ void TrackManager::unsubscribe(const std::string& stream_id, const std::string&
     const std::string key = makeKey(stream_id, profile_id);
     std::scoped_lock lock(mutex_);
     if (auto it = pipelines_.find(key); it != pipelines_.end()) {
+        if (--it->second.subscriptions > 0) {
+            return;
+        }
         if (it->second.pipeline) {
             it->second.pipeline->stop();
         }
@@ -82,16 +103,36 @@ void TrackManager::reapIdle(int idle_timeout_ms) {
     }
 }
 
+bool TrackManager::contains(const std::string& stream_id, const std::string& profile_id) const {
+    const std::string key = makeKey(stream_id, profile_id);
+    std::scoped_lock lock(mutex_);
+    auto it = pipelines_.find(key);
+    return it != pipelines_.end() && it->second.pipeline;
+}
+
 bool TrackManager::switchSource(const std::string& stream_id,
                                 const std::string& profile_id,
                                 const std::string& new_uri) {
     const std::string key = makeKey(stream_id, profile_id);
-    std::scoped_lock lock(mutex_);
-    auto it = pipelines_.find(key);
-    if (it == pipelines_.end()) {
+    std::shared_ptr<Pipeline> pipeline;
+    {
+        std::scoped_lock lock(mutex_);
+        auto it = pipelines_.find(key);
+        if (it == pipelines_.end() || !it->second.pipeline) {
+            return false;
+        }
+        pipeline = it->second.pipeline;
+    }
+    // switchUri() only starts the prefetch, but may release a capture a
+    // superseded switch had opened; other streams are not held up meanwhile.
+    if (!pipeline->source()->switchUri(new_uri)) {
         return false;
     }
-    return it->second.pipeline->source()->switchUri(new_uri);
+    std::scoped_lock lock(mutex_);
+    if (auto it = pipelines_.find(key); it != pipelines_.end() && it->second.pipeline == pipeline) {
+        it->second.source_uri = new_uri;
+    }
+    return true;
 }
 
 bool TrackManager::switchModel(const std::string& stream_id,
@@ -132,6 +173,70 @@ bool TrackManager::setParams(const std::string& stream_id,
     return it->second.pipeline->analyzer()->updateParams(std::move(params));
 }
 
+std::shared_ptr<const va::analyzer::AnalyzerParams> TrackManager::params(const std::string& stream_id,
+                                                                         const std::string& profile_id) const {
+    const std::string key = makeKey(stream_id, profile_id);
+    std::scoped_lock lock(mutex_);
+    auto it = pipelines_.find(key);
+    if (it == pipelines_.end() || !it->second.pipeline->analyzer()) {
+        return nullptr;
+    }
+    return it->second.pipeline->analyzer()->params();
+}
+
+bool TrackManager::acceptOffer(const std::string& stream_id,
+                               const std::string& profile_id,
+                               const std::string& offer_sdp,
+                               std::string& answer_sdp,
+                               std::string& session_id) {
+    std::shared_ptr<Pipeline> pipeline;
+    {
+        std::scoped_lock lock(mutex_);
+        auto it = pipelines_.find(makeKey(stream_id, profile_id));
+        if (it == pipelines_.end()) {
+            return false;
+        }
+        pipeline = it->second.pipeline;
+    }
+    // Negotiation waits briefly for ICE gathering; the registry stays unlocked meanwhile.
+    auto* transport = pipeline->transport();
+    return transport && transport->acceptOffer(offer_sdp, answer_sdp, session_id);
+}
+
+bool TrackManager::updateSession(const std::string& stream_id,
+                                 const std::string& profile_id,
+                                 const std::string& session_id,
+                                 const std::string& fragment,
+                                 std::string& local_fragment) {
+    std::shared_ptr<Pipeline> pipeline;
+    {
+        std::scoped_lock lock(mutex_);
+        auto it = pipelines_.find(makeKey(stream_id, profile_id));
+        if (it == pipelines_.end()) {
+            return false;
+        }
+        pipeline = it->second.pipeline;
+    }
+    auto* transport = pipeline->transport();
+    return transport && transport->updateSession(session_id, fragment, local_fragment);
+}
+
+bool TrackManager::closeSession(const std::string& stream_id,
+                                const std::string& profile_id,
+                                const std::string& session_id) {
+    std::shared_ptr<Pipeline> pipeline;
+    {
+        std::scoped_lock lock(mutex_);
+        auto it = pipelines_.find(makeKey(stream_id, profile_id));
+        if (it == pipelines_.end()) {
+            return false;
+        }
+        pipeline = it->second.pipeline;
+    }
+    auto* transport = pipeline->transport();
+    return transport && transport->closeSession(session_id);
+}
+
 std::string TrackManager::makeKey(const std::string& stream_id, const std::string& profile_id) const {
     return stream_id + ":" + profile_id;
 }
@@ -156,10 +261,12 @@ std::vector<TrackManager::PipelineInfo> TrackManager::listPipelines() const {
                 : entry.last_active_ms;
             info.track_id = entry.pipeline->streamId() + ":" + entry.pipeline->profileId();
             info.transport_stats = entry.pipeline->transportStats();
+            info.source_stats = entry.pipeline->sourceStats();
         } else {
             info.last_active_ms = entry.last_active_ms;
         }
         info.encoder_cfg = entry.encoder_cfg;
+        info.subscriptions = entry.subscriptions;
         infos.emplace_back(std::move(info));
     }
     return infos;
@@ -23,17 +23,33 @@ public:
     std::string subscribe(const SourceConfig& source_cfg,
                           const FilterConfig& filter_cfg,
                           const EncoderConfig& encoder_cfg,
-                          const TransportConfig& transport_cfg);
+                          const TransportConfig& transport_cfg,
+                          const PipelineConfig& pipeline_cfg = {});
 
     void unsubscribe(const std::string& stream_id, const std::string& profile_id);
     void reapIdle(int idle_timeout_ms);
 
+    bool contains(const std::string& stream_id, const std::string& profile_id) const;
     bool switchSource(const std::string& stream_id, const std::string& profile_id, const std::string& new_uri);
     bool switchModel(const std::string& stream_id, const std::string& profile_id, const std::string& new_model_id);
     bool switchTask(const std::string& stream_id, const std::string& profile_id, const std::string& task);
     bool setParams(const std::string& stream_id,
                    const std::string& profile_id,
                    std::shared_ptr<va::analyzer::AnalyzerParams> params);
+    std::shared_ptr<const va::analyzer::AnalyzerParams> params(const std::string& stream_id,
+                                                               const std::string& profile_id) const;
+    // WHEP viewers of a running pipeline (transports with a video track).
+    bool acceptOffer(const std::string& stream_id,
+                     const std::string& profile_id,
+                     const std::string& offer_sdp,
+                     std::string& answer_sdp,
+                     std::string& session_id);
+    bool updateSession(const std::string& stream_id,
+                       const std::string& profile_id,
+                       const std::string& session_id,
+                       const std::string& fragment,
+                       std::string& local_fragment);
+    bool closeSession(const std::string& stream_id, const std::string& profile_id, const std::string& session_id);
 
     struct PipelineInfo {
         std::string key;
@@ -47,7 +63,9 @@ public:
         std::string track_id;
         va::core::Pipeline::Metrics metrics;
         va::media::ITransport::Stats transport_stats;
+        va::media::SourceStats source_stats;
         EncoderConfig encoder_cfg;
+        int subscriptions {0};
     };
 
     std::vector<PipelineInfo> listPipelines() const;
@@ -62,6 +80,9 @@ private:
         std::string model_id;
         std::string task;
         EncoderConfig encoder_cfg;
+        // REST subscriptions sharing this pipeline; it stops when the last
+        // one unsubscribes.
+        int subscriptions {1};
     };
 
     std::string makeKey(const std::string& stream_id, const std::string& profile_id) const;
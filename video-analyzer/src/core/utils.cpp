@@ -0,0 +1,257 @@
+#include "core/utils.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <mutex>
+
+namespace va::core {
+
+namespace detail {
+struct FrameBlock {
+    std::unique_ptr<uint8_t[]> bytes;
+    size_t capacity {0};
+};
+} // namespace detail
+
+struct FramePool::State {
+    explicit State(size_t max_pooled) : max_pooled_buffers(max_pooled) {}
+
+    // Caller holds `mutex`.
+    void rollWindow(std::chrono::steady_clock::time_point now) {
+        const double elapsed_s = std::chrono::duration<double>(now - window_start).count();
+        if (elapsed_s >= 1.0) {
+            allocations_per_sec = static_cast<double>(window_allocations) / elapsed_s;
+            window_allocations = 0;
+            window_start = now;
+        }
+    }
+
+    const size_t max_pooled_buffers;
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<detail::FrameBlock>> free_blocks;
+    uint64_t allocations {0};
+    uint64_t reuses {0};
+    uint64_t in_use {0};
+    uint64_t window_allocations {0};
+    double allocations_per_sec {0.0};
+    std::chrono::steady_clock::time_point window_start {std::chrono::steady_clock::now()};
+};
+
+// Returns a block to the pool it came from, or frees it once that pool is gone.
+struct FramePool::Recycler {
+    std::weak_ptr<State> pool;
+
+    void operator()(detail::FrameBlock* block) const {
+        std::unique_ptr<detail::FrameBlock> owned(block);
+        auto state = pool.lock();
+        if (!state) {
+            return;
+        }
+        std::scoped_lock lock(state->mutex);
+        if (state->in_use > 0) {
+            state->in_use--;
+        }
+        if (state->free_blocks.size() < state->max_pooled_buffers) {
+            state->free_blocks.emplace_back(std::move(owned));
+        }
+    }
+};
+
+FrameBuffer::FrameBuffer(FrameBuffer&& other) noexcept
+    : block_(std::move(other.block_)), size_(other.size_) {
+    other.size_ = 0;
+}
+
+FrameBuffer& FrameBuffer::operator=(FrameBuffer&& other) noexcept {
+    if (this != &other) {
+        block_ = std::move(other.block_);
+        size_ = other.size_;
+        other.size_ = 0;
+    }
+    return *this;
+}
+
+const uint8_t* FrameBuffer::data() const {
+    return block_ ? block_->bytes.get() : nullptr;
+}
+
+uint8_t* FrameBuffer::data() {
+    return block_ ? block_->bytes.get() : nullptr;
+}
+
+uint8_t* FrameBuffer::prepare(size_t bytes) {
+    if (bytes == 0) {
+        reset();
+        return nullptr;
+    }
+    if (unique() && block_->capacity >= bytes) {
+        size_ = bytes;
+        return block_->bytes.get();
+    }
+    *this = FramePool::shared().acquire(bytes);
+    return data();
+}
+
+uint8_t* FrameBuffer::makeWritable() {
+    if (!block_ || unique()) {
+        return data();
+    }
+    FrameBuffer copy = FramePool::shared().acquire(size_);
+    std::memcpy(copy.data(), data(), size_);
+    *this = std::move(copy);
+    return data();
+}
+
+void FrameBuffer::assign(const uint8_t* first, const uint8_t* last) {
+    const size_t bytes = last > first ? static_cast<size_t>(last - first) : 0;
+    uint8_t* dst = prepare(bytes);
+    if (dst) {
+        std::memcpy(dst, first, bytes);
+    }
+}
+
+void FrameBuffer::reset() {
+    block_.reset();
+    size_ = 0;
+}
+
+FramePool::FramePool(size_t max_pooled_buffers)
+    : state_(std::make_shared<State>(max_pooled_buffers)) {}
+
+FramePool::~FramePool() = default;
+
+FramePool& FramePool::shared() {
+    static FramePool pool;
+    return pool;
+}
+
+FrameBuffer FramePool::acquire(size_t bytes) {
+    FrameBuffer buffer;
+    if (bytes == 0) {
+        return buffer;
+    }
+
+    std::unique_ptr<detail::FrameBlock> block;
+    {
+        std::scoped_lock lock(state_->mutex);
+        // Best fit, but never hand a small request a buffer more than twice its
+        // size; that memory is better kept for the frames it was sized for.
+        auto best = state_->free_blocks.end();
+        for (auto it = state_->free_blocks.begin(); it != state_->free_blocks.end(); ++it) {
+            const size_t capacity = (*it)->capacity;
+            if (capacity >= bytes && capacity / 2 <= bytes
+                && (best == state_->free_blocks.end() || capacity < (*best)->capacity)) {
+                best = it;
+            }
+        }
+        if (best != state_->free_blocks.end()) {
+            block = std::move(*best);
+            state_->free_blocks.erase(best);
+            state_->reuses++;
+        } else {
+            state_->allocations++;
+            state_->window_allocations++;
+        }
+        state_->in_use++;
+        state_->rollWindow(std::chrono::steady_clock::now());
+    }
+
+    if (!block) {
+        block = std::make_unique<detail::FrameBlock>();
+        block->bytes.reset(new uint8_t[bytes]);
+        block->capacity = bytes;
+    }
+
+    buffer.block_ = std::shared_ptr<detail::FrameBlock>(block.release(), Recycler{state_});
+    buffer.size_ = bytes;
+    return buffer;
+}
+
+FramePoolStats FramePool::stats() const {
+    std::scoped_lock lock(state_->mutex);
+    state_->rollWindow(std::chrono::steady_clock::now());
+    FramePoolStats stats;
+    stats.allocations = state_->allocations;
+    stats.reuses = state_->reuses;
+    stats.allocations_per_sec = state_->allocations_per_sec;
+    stats.buffers_in_use = state_->in_use;
+    stats.buffers_pooled = state_->free_blocks.size();
+    for (const auto& block : state_->free_blocks) {
+        stats.bytes_pooled += block->capacity;
+    }
+    return stats;
+}
+
+size_t frameBytes(PixelFormat format, int width, int height) {
+    if (width <= 0 || height <= 0) {
+        return 0;
+    }
+    const size_t luma = static_cast<size_t>(width) * static_cast<size_t>(height);
+    if (format == PixelFormat::I420) {
+        const size_t chroma = static_cast<size_t>((width + 1) / 2) * static_cast<size_t>((height + 1) / 2);
+        return luma + 2 * chroma;
+    }
+    return luma * 3;
+}
+
+std::string toLower(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    return value;
+}
+
+PixelFormat parsePixelFormat(const std::string& value) {
+    const std::string lower = toLower(value);
+    if (lower == "i420" || lower == "yuv420p" || lower == "yuv") {
+        return PixelFormat::I420;
+    }
+    return PixelFormat::Bgr24;
+}
+
+const char* pixelFormatName(PixelFormat format) {
+    return format == PixelFormat::I420 ? "i420" : "bgr24";
+}
+
+FrameFit parseFrameFit(const std::string& value) {
+    const std::string lower = toLower(value);
+    if (lower == "stretch") {
+        return FrameFit::Stretch;
+    }
+    if (lower == "pad" || lower == "letterbox") {
+        return FrameFit::Pad;
+    }
+    return FrameFit::Fit;
+}
+
+FrameSize targetFrameSize(int width, int height, int box_width, int box_height, FrameFit fit) {
+    if (width <= 0 || height <= 0 || box_width <= 0 || box_height <= 0) {
+        return {width, height};
+    }
+    if (fit != FrameFit::Fit) {
+        return {box_width, box_height};
+    }
+    const double scale = std::min({1.0, static_cast<double>(box_width) / width, static_cast<double>(box_height) / height});
+    if (scale >= 1.0) {
+        return {width, height};
+    }
+    return {std::max(2, static_cast<int>(width * scale) & ~1), std::max(2, static_cast<int>(height * scale) & ~1)};
+}
+
+FrameRect pictureRect(int width, int height, int box_width, int box_height, FrameFit fit) {
+    const auto size = targetFrameSize(width, height, box_width, box_height, fit);
+    if (fit != FrameFit::Pad || size.width != box_width || size.height != box_height) {
+        return {0, 0, size.width, size.height};
+    }
+    // Scaled up or down until one side touches the box.
+    const double scale = std::min(static_cast<double>(box_width) / width, static_cast<double>(box_height) / height);
+    FrameRect rect;
+    rect.width = std::min(box_width, std::max(2, static_cast<int>(width * scale + 0.5) & ~1));
+    rect.height = std::min(box_height, std::max(2, static_cast<int>(height * scale + 0.5) & ~1));
+    rect.x = ((box_width - rect.width) / 2) & ~1;
+    rect.y = ((box_height - rect.height) / 2) & ~1;
+    return rect;
+}
+
+} // namespace va::core
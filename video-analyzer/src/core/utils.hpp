@@ -1,7 +1,9 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <chrono>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -13,11 +15,122 @@ enum class DType {
     F16
 };
 
+class FramePool;
+
+namespace detail {
+struct FrameBlock;
+}
+
+// Reference-counted handle to pixel memory drawn from a FramePool. Copying a
+// handle shares the bytes, so a frame handed from one stage to the next is not
+// duplicated; the memory goes back to its pool when the last handle drops it.
+// Shared buffers are treated as immutable: writers call prepare() or assign(),
+// which only write in place when this handle is the sole owner.
+class FrameBuffer {
+public:
+    FrameBuffer() = default;
+    FrameBuffer(const FrameBuffer&) = default;
+    FrameBuffer& operator=(const FrameBuffer&) = default;
+    FrameBuffer(FrameBuffer&& other) noexcept;
+    FrameBuffer& operator=(FrameBuffer&& other) noexcept;
+
+    const uint8_t* data() const;
+    uint8_t* data();
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    bool unique() const { return block_ && block_.use_count() == 1; }
+
+    // Returns writable storage of `bytes` bytes with unspecified contents.
+    uint8_t* prepare(size_t bytes);
+    // Copy-on-write: returns the current bytes for writing, first moving them
+    // into a private pooled buffer if another handle shares them.
+    uint8_t* makeWritable();
+    void assign(const uint8_t* first, const uint8_t* last);
+    void reset();
+
+private:
+    friend class FramePool;
+
+    std::shared_ptr<detail::FrameBlock> block_;
+    size_t size_ {0};
+};
+
+struct FramePoolStats {
+    uint64_t allocations {0};
+    uint64_t reuses {0};
+    double allocations_per_sec {0.0};
+    uint64_t buffers_in_use {0};
+    uint64_t buffers_pooled {0};
+    uint64_t bytes_pooled {0};
+};
+
+// Free list of frame-sized allocations. Once every stage has seen a frame of
+// the current resolution, acquire() is served entirely from recycled buffers.
+class FramePool {
+public:
+    explicit FramePool(size_t max_pooled_buffers = 32);
+    ~FramePool();
+
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    static FramePool& shared();
+
+    FrameBuffer acquire(size_t bytes);
+    FramePoolStats stats() const;
+
+private:
+    struct State;
+    struct Recycler;
+    std::shared_ptr<State> state_;
+};
+
+enum class PixelFormat {
+    Bgr24, // packed B, G, R; width * 3 bytes per row
+    I420   // Y plane, then U and V at half resolution; rows are not padded
+};
+
+// Bytes a tightly packed frame of this format and size occupies.
+size_t frameBytes(PixelFormat format, int width, int height);
+PixelFormat parsePixelFormat(const std::string& value);
+const char* pixelFormatName(PixelFormat format);
+
+struct FrameSize {
+    int width {0};
+    int height {0};
+};
+
+// Where a picture lands inside a frame.
+struct FrameRect {
+    int x {0};
+    int y {0};
+    int width {0};
+    int height {0};
+};
+
+// How a source fits its picture to a target box.
+enum class FrameFit {
+    Fit,     // inside the box, never upscaled, even dimensions
+    Stretch, // exactly the box, aspect ratio not kept
+    Pad      // exactly the box; the picture fits inside it, centred on black bars
+};
+
+FrameFit parseFrameFit(const std::string& value);
+
+// Size a source delivers a width x height picture at for a target box
+// (0 = native).
+FrameSize targetFrameSize(int width, int height, int box_width, int box_height, FrameFit fit);
+// The picture's place in that frame: all of it except for FrameFit::Pad,
+// where offsets and sizes are even so I420 chroma stays aligned.
+FrameRect pictureRect(int width, int height, int box_width, int box_height, FrameFit fit);
+
 struct Frame {
     int width {0};
     int height {0};
-    double pts_ms {0.0};
-    std::vector<uint8_t> bgr;
+    double pts_ms {0.0};     // stream time when the source knows it, else capture time
+    double capture_ms {0.0}; // ms_now() when the source produced the frame
+    PixelFormat format {PixelFormat::Bgr24};
+    FrameBuffer pixels;
 };
 
 struct LetterboxMeta {
@@ -46,11 +159,50 @@ struct Box {
     int cls {0};
 };
 
+// Instance mask kept at the model's prototype resolution (160x160 for YOLO
+// seg heads) and cropped to its box: one bit per cell, rows padded to whole
+// bytes. Cell (x, y) covers cell_width x cell_height frame pixels starting at
+// (origin_x + x * cell_width, origin_y + y * cell_height); renderers upsample
+// lazily by looking up contains() for the pixels they touch.
+struct SegmentMask {
+    int width {0};
+    int height {0};
+    float origin_x {0.0f};
+    float origin_y {0.0f};
+    float cell_width {1.0f};
+    float cell_height {1.0f};
+    std::vector<uint8_t> bits;
+
+    bool empty() const { return width <= 0 || height <= 0; }
+    int stride() const { return (width + 7) / 8; }
+    bool test(int x, int y) const {
+        return (bits[static_cast<size_t>(y) * stride() + (x >> 3)] >> (x & 7)) & 1;
+    }
+    void set(int x, int y) {
+        bits[static_cast<size_t>(y) * stride() + (x >> 3)] |= static_cast<uint8_t>(1u << (x & 7));
+    }
+    // Nearest-cell lookup for a point in frame coordinates.
+    bool contains(float x, float y) const {
+        const float cx = (x - origin_x) / cell_width;
+        const float cy = (y - origin_y) / cell_height;
+        if (cx < 0.0f || cy < 0.0f || cx >= static_cast<float>(width) || cy >= static_cast<float>(height)) {
+            return false;
+        }
+        return test(static_cast<int>(cx), static_cast<int>(cy));
+    }
+};
+
 struct ModelOutput {
     std::vector<Box> boxes;
-    std::vector<std::vector<uint8_t>> masks;
+    // Empty for detection-only models; otherwise index-aligned with boxes.
+    std::vector<SegmentMask> masks;
+    // Empty unless a tracker assigned ids; otherwise index-aligned with boxes.
+    std::vector<int> track_ids;
 };
 
+// ASCII lower-case copy, for case-insensitive config values and protocol tokens.
+std::string toLower(std::string value);
+
 inline double ms_now() {
     using clock = std::chrono::steady_clock;
     return std::chrono::duration<double, std::milli>(clock::now().time_since_epoch()).count();
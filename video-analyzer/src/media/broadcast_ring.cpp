@@ -0,0 +1,86 @@
+#include "media/broadcast_ring.hpp"
+
+#include <algorithm>
+
+namespace va::media {
+
+BroadcastRing::BroadcastRing(size_t capacity, size_t max_lag)
+    : slots_(std::max<size_t>(capacity, 1)),
+      max_lag_(max_lag > 0 ? std::min(max_lag, slots_.size()) : std::max<size_t>(slots_.size() / 2, 1)) {}
+
+void BroadcastRing::push(PacketBuffer packet, bool keyframe) {
+    if (packet.empty()) {
+        return;
+    }
+    std::scoped_lock lock(mutex_);
+    Slot& slot = slots_[head_ % slots_.size()];
+    slot.packet = std::move(packet);
+    slot.seq = head_;
+    slot.keyframe = keyframe;
+    slot.pushed_at = Clock::now();
+    if (keyframe) {
+        last_keyframe_ = head_;
+        has_keyframe_ = true;
+    }
+    ++head_;
+}
+
+bool BroadcastRing::resync(Cursor& cursor) {
+    const uint64_t tail = head_ > slots_.size() ? head_ - slots_.size() : 0;
+    if (!has_keyframe_ || last_keyframe_ < tail || (cursor.synced && last_keyframe_ <= cursor.next)) {
+        return false;
+    }
+    if (cursor.started) {
+        const uint64_t skipped = last_keyframe_ - cursor.next;
+        cursor.skipped += skipped;
+        skipped_ += skipped;
+    }
+    cursor.next = last_keyframe_;
+    cursor.synced = true;
+    cursor.started = true;
+    return true;
+}
+
+bool BroadcastRing::read(Cursor& cursor, PacketBuffer& packet) {
+    Clock::time_point pushed_at;
+    return read(cursor, packet, pushed_at);
+}
+
+bool BroadcastRing::read(Cursor& cursor, PacketBuffer& packet, Clock::time_point& pushed_at) {
+    std::scoped_lock lock(mutex_);
+    const uint64_t tail = head_ > slots_.size() ? head_ - slots_.size() : 0;
+    if (cursor.synced && cursor.next < tail) {
+        // Overrun: the packets this reader needs are gone, wait for a keyframe.
+        cursor.skipped += tail - cursor.next;
+        skipped_ += tail - cursor.next;
+        cursor.next = tail;
+        cursor.synced = false;
+    }
+    if (!cursor.synced) {
+        if (!resync(cursor)) {
+            return false;
+        }
+    } else if (head_ - cursor.next > max_lag_) {
+        resync(cursor);
+    }
+    if (cursor.next >= head_) {
+        return false;
+    }
+    const Slot& slot = slots_[cursor.next % slots_.size()];
+    packet = slot.packet;
+    pushed_at = slot.pushed_at;
+    ++cursor.next;
+    return true;
+}
+
+uint64_t BroadcastRing::head() const {
+    std::scoped_lock lock(mutex_);
+    return head_;
+}
+
+uint64_t BroadcastRing::skippedPackets() const {
+    std::scoped_lock lock(mutex_);
+    return skipped_;
+}
+
+} // namespace va::media
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "media/packet_buffer.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace va::media {
+
+// Fixed-size history of one track's packets. The producer never waits: each
+// packet is stored once (by reference, see PacketBuffer) and every reader walks the ring with its own cursor.
+// A reader that falls out of the window or too far behind is moved to the
+// newest keyframe, so a slow subscriber loses frames instead of holding up
+// the others.
+class BroadcastRing {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Cursor {
+        uint64_t next {0};   // sequence number of the next packet to read
+        bool synced {false}; // false until positioned on a keyframe
+        bool started {false};
+        uint64_t skipped {0};
+    };
+
+    // max_lag: packets a reader may trail the head before it is moved to a
+    // newer keyframe; 0 uses half the capacity.
+    explicit BroadcastRing(size_t capacity = 120, size_t max_lag = 0);
+
+    void push(PacketBuffer packet, bool keyframe);
+    // Fills `packet` with the next packet for this reader; false when it is
+    // caught up or still waiting for its first keyframe.
+    bool read(Cursor& cursor, PacketBuffer& packet);
+    // Same, also reporting when the packet was pushed.
+    bool read(Cursor& cursor, PacketBuffer& packet, Clock::time_point& pushed_at);
+
+    // Next sequence number to be written.
+    uint64_t head() const;
+    uint64_t skippedPackets() const;
+
+private:
+    struct Slot {
+        PacketBuffer packet;
+        uint64_t seq {0};
+        bool keyframe {false};
+        Clock::time_point pushed_at;
+    };
+
+    // Caller holds mutex_. Moves the cursor to the newest keyframe still in
+    // the ring; false if there is none newer than the cursor.
+    bool resync(Cursor& cursor);
+
+    std::vector<Slot> slots_;
+    size_t max_lag_;
+    uint64_t head_ {0};
+    // Sequence number of the newest keyframe, valid while has_keyframe_.
+    uint64_t last_keyframe_ {0};
+    bool has_keyframe_ {false};
+    uint64_t skipped_ {0};
+    mutable std::mutex mutex_;
+};
+
+} // namespace va::media
@@ -0,0 +1,545 @@
+#include "media/detection_codec.hpp"
+
+#include "core/utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+namespace va::media {
+
+namespace {
+
+constexpr uint8_t kMagic0 = 'V';
+constexpr uint8_t kMagic1 = 'D';
+constexpr uint8_t kFlagKeyframe = 0x01;
+constexpr uint8_t kFlagTrackIds = 0x02;
+constexpr uint8_t kFlagMasks = 0x04;
+constexpr size_t kHeaderSize = 4;
+constexpr size_t kMinBoxBytes = 2;  // reference varint + score byte
+
+void appendEscaped(std::vector<uint8_t>& out, const std::string& text) {
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            out.push_back('\\');
+            out.push_back(c);
+        } else if (c >= 0x20) {
+            out.push_back(c);
+        }
+    }
+}
+
+template <typename... Args>
+void appendFormat(std::vector<uint8_t>& out, const char* format, Args... args) {
+    char buffer[96];
+    const int written = std::snprintf(buffer, sizeof(buffer), format, args...);
+    if (written > 0) {
+        out.insert(out.end(), buffer, buffer + std::min<size_t>(static_cast<size_t>(written), sizeof(buffer) - 1));
+    }
+}
+
+uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+size_t varintSize(uint64_t value) {
+    size_t bytes = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        ++bytes;
+    }
+    return bytes;
+}
+
+void putVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+void putSigned(std::vector<uint8_t>& out, int64_t value) {
+    putVarint(out, zigzag(value));
+}
+
+void putFloat(std::vector<uint8_t>& out, float value) {
+    uint32_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    for (int shift = 0; shift < 32; shift += 8) {
+        out.push_back(static_cast<uint8_t>(bits >> shift));
+    }
+}
+
+class Reader {
+public:
+    Reader(const uint8_t* data, size_t size) : data_(data), end_(data + size) {}
+
+    size_t remaining() const { return static_cast<size_t>(end_ - data_); }
+
+    bool byte(uint8_t& value) {
+        if (data_ >= end_) {
+            return false;
+        }
+        value = *data_++;
+        return true;
+    }
+
+    bool varint(uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t b = 0;
+            if (!byte(b)) {
+                return false;
+            }
+            value |= static_cast<uint64_t>(b & 0x7F) << shift;
+            if ((b & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool signedVarint(int64_t& value) {
+        uint64_t raw = 0;
+        if (!varint(raw)) {
+            return false;
+        }
+        value = unzigzag(raw);
+        return true;
+    }
+
+    bool int32(int32_t& value) {
+        int64_t wide = 0;
+        if (!signedVarint(wide) || wide < std::numeric_limits<int32_t>::min()
+            || wide > std::numeric_limits<int32_t>::max()) {
+            return false;
+        }
+        value = static_cast<int32_t>(wide);
+        return true;
+    }
+
+    bool count(uint64_t& value, size_t min_bytes_each) {
+        return varint(value) && value <= remaining() / std::max<size_t>(min_bytes_each, 1);
+    }
+
+    bool float32(float& value) {
+        if (remaining() < 4) {
+            return false;
+        }
+        uint32_t bits = 0;
+        for (int shift = 0; shift < 32; shift += 8) {
+            bits |= static_cast<uint32_t>(*data_++) << shift;
+        }
+        std::memcpy(&value, &bits, sizeof(value));
+        return true;
+    }
+
+    bool bytes(std::string& value, size_t size) {
+        if (remaining() < size) {
+            return false;
+        }
+        value.assign(reinterpret_cast<const char*>(data_), size);
+        data_ += size;
+        return true;
+    }
+
+private:
+    const uint8_t* data_;
+    const uint8_t* end_;
+};
+
+// `base + delta` in 64 bits; false when the sum leaves the int32 range, as a
+// corrupt or hostile record can make it.
+bool addDelta(int32_t base, int64_t delta, int32_t& value) {
+    if (delta < std::numeric_limits<int32_t>::min() || delta > std::numeric_limits<int32_t>::max()) {
+        return false;
+    }
+    const int64_t sum = static_cast<int64_t>(base) + delta;
+    if (sum < std::numeric_limits<int32_t>::min() || sum > std::numeric_limits<int32_t>::max()) {
+        return false;
+    }
+    value = static_cast<int32_t>(sum);
+    return true;
+}
+
+int32_t quantizeCoord(float value) {
+    return static_cast<int32_t>(std::lround(std::clamp(value, -1.0e6f, 1.0e6f)));
+}
+
+uint8_t quantizeScore(float score) {
+    return static_cast<uint8_t>(std::lround(std::clamp(score, 0.0f, 1.0f) * 255.0f));
+}
+
+size_t absoluteCost(const DetectionEncoder::QuantBox& box) {
+    return varintSize(static_cast<uint64_t>(box.cls)) + varintSize(zigzag(box.x1)) + varintSize(zigzag(box.y1))
+        + varintSize(zigzag(box.x2)) + varintSize(zigzag(box.y2));
+}
+
+size_t deltaCost(const DetectionEncoder::QuantBox& box, const DetectionEncoder::QuantBox& ref) {
+    return varintSize(zigzag(box.x1 - ref.x1)) + varintSize(zigzag(box.y1 - ref.y1))
+        + varintSize(zigzag(box.x2 - ref.x2)) + varintSize(zigzag(box.y2 - ref.y2));
+}
+
+// Masks are run-length coded over their cells in row-major order; runs
+// alternate starting with unset cells, so a leading zero-length run is legal.
+void putMask(std::vector<uint8_t>& out, const core::SegmentMask& mask) {
+    if (mask.empty()) {
+        putVarint(out, 0);
+        putVarint(out, 0);
+        return;
+    }
+    putVarint(out, static_cast<uint64_t>(mask.width));
+    putVarint(out, static_cast<uint64_t>(mask.height));
+    putFloat(out, mask.origin_x);
+    putFloat(out, mask.origin_y);
+    putFloat(out, mask.cell_width);
+    putFloat(out, mask.cell_height);
+
+    std::vector<uint32_t> runs;
+    bool value = false;
+    uint32_t run = 0;
+    for (int y = 0; y < mask.height; ++y) {
+        for (int x = 0; x < mask.width; ++x) {
+            if (mask.test(x, y) != value) {
+                runs.push_back(run);
+                value = !value;
+                run = 0;
+            }
+            ++run;
+        }
+    }
+    runs.push_back(run);
+    putVarint(out, runs.size());
+    for (uint32_t length : runs) {
+        putVarint(out, length);
+    }
+}
+
+bool readMask(Reader& reader, core::SegmentMask& mask) {
+    uint64_t width = 0;
+    uint64_t height = 0;
+    if (!reader.varint(width) || !reader.varint(height)) {
+        return false;
+    }
+    mask = {};
+    if (width == 0 || height == 0) {
+        return true;
+    }
+    constexpr uint64_t kMaxCells = 4096ull * 4096ull;
+    if (width > kMaxCells || height > kMaxCells / width) {
+        return false;
+    }
+    mask.width = static_cast<int>(width);
+    mask.height = static_cast<int>(height);
+    if (!reader.float32(mask.origin_x) || !reader.float32(mask.origin_y)
+        || !reader.float32(mask.cell_width) || !reader.float32(mask.cell_height)) {
+        return false;
+    }
+    mask.bits.assign(static_cast<size_t>(mask.stride()) * mask.height, 0);
+
+    uint64_t runs = 0;
+    if (!reader.count(runs, 1)) {
+        return false;
+    }
+    const uint64_t cells = width * height;
+    uint64_t cell = 0;
+    bool value = false;
+    for (uint64_t r = 0; r < runs; ++r, value = !value) {
+        uint64_t length = 0;
+        if (!reader.varint(length) || length > cells - cell) {
+            return false;
+        }
+        if (value) {
+            for (uint64_t i = cell; i < cell + length; ++i) {
+                mask.set(static_cast<int>(i % width), static_cast<int>(i / width));
+            }
+        }
+        cell += length;
+    }
+    return cell == cells;
+}
+
+} // namespace
+
+MetadataFormat parseMetadataFormat(const std::string& value) {
+    const std::string lower = core::toLower(value);
+    return lower == "json" ? MetadataFormat::Json : MetadataFormat::Binary;
+}
+
+const char* metadataFormatName(MetadataFormat format) {
+    return format == MetadataFormat::Json ? "json" : "binary";
+}
+
+void encodeDetectionsJson(const DetectionFrameInfo& info,
+                          const core::ModelOutput& output,
+                          std::vector<uint8_t>& out) {
+    out.clear();
+    out.reserve(64 + info.stream_id.size() + output.boxes.size() * 40);
+
+    appendFormat(out, "{\"v\":1,\"stream\":\"");
+    appendEscaped(out, info.stream_id);
+    appendFormat(out, "\",\"pts\":%.1f,\"w\":%d,\"h\":%d,\"det\":[", info.pts_ms, info.width, info.height);
+    for (size_t i = 0; i < output.boxes.size(); ++i) {
+        const auto& box = output.boxes[i];
+        appendFormat(out, "%s[%ld,%ld,%ld,%ld,%d,%.3f]",
+                     i == 0 ? "" : ",",
+                     std::lround(box.x1), std::lround(box.y1), std::lround(box.x2), std::lround(box.y2),
+                     box.cls, static_cast<double>(box.score));
+    }
+    appendFormat(out, "]}");
+}
+
+DetectionEncoder::DetectionEncoder()
+    : DetectionEncoder(Options{}) {}
+
+DetectionEncoder::DetectionEncoder(Options options)
+    : options_(options) {}
+
+int DetectionEncoder::pickReference(const QuantBox& box, bool use_tracks) {
+    int best = -1;
+    size_t best_cost = absoluteCost(box);
+    for (size_t i = 0; i < previous_.size(); ++i) {
+        const QuantBox& ref = previous_[i];
+        if (used_[i] || ref.cls != box.cls) {
+            continue;
+        }
+        if (use_tracks && box.track_id >= 0 && ref.track_id == box.track_id) {
+            best = static_cast<int>(i);
+            break;
+        }
+        const size_t cost = deltaCost(box, ref) + varintSize(i + 1);
+        if (cost < best_cost) {
+            best_cost = cost;
+            best = static_cast<int>(i);
+        }
+    }
+    return best;
+}
+
+void DetectionEncoder::encode(const DetectionFrameInfo& info,
+                              const core::ModelOutput& output,
+                              std::vector<uint8_t>& out) {
+    const size_t count = output.boxes.size();
+    const bool has_tracks = !output.track_ids.empty() && output.track_ids.size() == count;
+    const bool has_masks = !output.masks.empty() && output.masks.size() == count;
+    const int64_t pts_us = static_cast<int64_t>(std::llround(info.pts_ms * 1000.0));
+
+    const int interval = std::max(options_.keyframe_interval, 1);
+    const bool keyframe = force_keyframe_
+        || frames_since_key_ + 1 >= static_cast<uint32_t>(interval)
+        || info.stream_id != stream_id_ || info.width != width_ || info.height != height_;
+
+    uint8_t flags = 0;
+    flags |= keyframe ? kFlagKeyframe : 0;
+    flags |= has_tracks ? kFlagTrackIds : 0;
+    flags |= has_masks ? kFlagMasks : 0;
+
+    out.clear();
+    out.reserve(32 + info.stream_id.size() + count * 8);
+    out.push_back(kMagic0);
+    out.push_back(kMagic1);
+    out.push_back(kDetectionWireVersion);
+    out.push_back(flags);
+    putVarint(out, seq_);
+    if (keyframe) {
+        putVarint(out, info.stream_id.size());
+        out.insert(out.end(), info.stream_id.begin(), info.stream_id.end());
+        putVarint(out, static_cast<uint64_t>(std::max(info.width, 0)));
+        putVarint(out, static_cast<uint64_t>(std::max(info.height, 0)));
+        putSigned(out, pts_us);
+    } else {
+        putSigned(out, pts_us - last_pts_us_);
+    }
+
+    putVarint(out, count);
+    current_.resize(count);
+    used_.assign(keyframe ? 0 : previous_.size(), 0);
+    for (size_t i = 0; i < count; ++i) {
+        const core::Box& box = output.boxes[i];
+        QuantBox& q = current_[i];
+        q.x1 = quantizeCoord(box.x1);
+        q.y1 = quantizeCoord(box.y1);
+        q.x2 = quantizeCoord(box.x2);
+        q.y2 = quantizeCoord(box.y2);
+        q.cls = std::max(box.cls, 0);
+        q.track_id = has_tracks ? output.track_ids[i] : -1;
+
+        const int ref = keyframe ? -1 : pickReference(q, has_tracks);
+        if (ref < 0) {
+            putVarint(out, 0);
+            putVarint(out, static_cast<uint64_t>(q.cls));
+            putSigned(out, q.x1);
+            putSigned(out, q.y1);
+            putSigned(out, q.x2);
+            putSigned(out, q.y2);
+        } else {
+            const QuantBox& prev = previous_[static_cast<size_t>(ref)];
+            used_[static_cast<size_t>(ref)] = 1;
+            putVarint(out, static_cast<uint64_t>(ref) + 1);
+            putSigned(out, q.x1 - prev.x1);
+            putSigned(out, q.y1 - prev.y1);
+            putSigned(out, q.x2 - prev.x2);
+            putSigned(out, q.y2 - prev.y2);
+        }
+        out.push_back(quantizeScore(box.score));
+        if (has_tracks) {
+            putSigned(out, q.track_id);
+        }
+    }
+
+    if (has_masks) {
+        for (const auto& mask : output.masks) {
+            putMask(out, mask);
+        }
+    }
+
+    previous_.swap(current_);
+    last_pts_us_ = pts_us;
+    last_keyframe_ = keyframe;
+    ++seq_;
+    if (keyframe) {
+        force_keyframe_ = false;
+        frames_since_key_ = 0;
+        stream_id_ = info.stream_id;
+        width_ = info.width;
+        height_ = info.height;
+    } else {
+        ++frames_since_key_;
+    }
+}
+
+void DetectionDecoder::reset() {
+    synced_ = false;
+    previous_.clear();
+}
+
+bool DetectionDecoder::decode(const uint8_t* data, size_t size, DetectionRecord& record) {
+    if (!data || size < kHeaderSize || data[0] != kMagic0 || data[1] != kMagic1
+        || data[2] != kDetectionWireVersion) {
+        return false;
+    }
+    const uint8_t flags = data[3];
+    const bool keyframe = (flags & kFlagKeyframe) != 0;
+    const bool has_tracks = (flags & kFlagTrackIds) != 0;
+    const bool has_masks = (flags & kFlagMasks) != 0;
+
+    Reader reader(data + kHeaderSize, size - kHeaderSize);
+    uint64_t seq = 0;
+    if (!reader.varint(seq)) {
+        return false;
+    }
+    if (!keyframe && (!synced_ || static_cast<uint32_t>(seq) != seq_ + 1)) {
+        synced_ = false;
+        return false;
+    }
+
+    int64_t pts_us = 0;
+    if (keyframe) {
+        uint64_t id_size = 0;
+        uint64_t width = 0;
+        uint64_t height = 0;
+        if (!reader.count(id_size, 1) || !reader.bytes(stream_id_, static_cast<size_t>(id_size))
+            || !reader.varint(width) || !reader.varint(height) || !reader.signedVarint(pts_us)
+            || width > static_cast<uint64_t>(std::numeric_limits<int>::max())
+            || height > static_cast<uint64_t>(std::numeric_limits<int>::max())) {
+            synced_ = false;
+            return false;
+        }
+        width_ = static_cast<int>(width);
+        height_ = static_cast<int>(height);
+    } else {
+        int64_t delta = 0;
+        if (!reader.signedVarint(delta)) {
+            synced_ = false;
+            return false;
+        }
+        pts_us = last_pts_us_ + delta;
+    }
+
+    uint64_t count = 0;
+    if (!reader.count(count, kMinBoxBytes)) {
+        synced_ = false;
+        return false;
+    }
+
+    record.seq = static_cast<uint32_t>(seq);
+    record.keyframe = keyframe;
+    record.info.stream_id = stream_id_;
+    record.info.width = width_;
+    record.info.height = height_;
+    record.info.pts_ms = static_cast<double>(pts_us) / 1000.0;
+    record.output.boxes.resize(count);
+    record.output.masks.clear();
+    record.output.track_ids.clear();
+    if (has_tracks) {
+        record.output.track_ids.resize(count);
+    }
+
+    current_.resize(count);
+    bool ok = true;
+    for (size_t i = 0; i < count && ok; ++i) {
+        DetectionEncoder::QuantBox& q = current_[i];
+        uint64_t ref = 0;
+        ok = reader.varint(ref);
+        if (ok && ref == 0) {
+            uint64_t cls = 0;
+            ok = reader.varint(cls) && cls <= static_cast<uint64_t>(std::numeric_limits<int32_t>::max())
+                && reader.int32(q.x1) && reader.int32(q.y1) && reader.int32(q.x2) && reader.int32(q.y2);
+            q.cls = static_cast<int32_t>(cls);
+        } else if (ok) {
+            ok = !keyframe && ref <= previous_.size();
+            if (ok) {
+                const DetectionEncoder::QuantBox& prev = previous_[static_cast<size_t>(ref - 1)];
+                int64_t dx1 = 0;
+                int64_t dy1 = 0;
+                int64_t dx2 = 0;
+                int64_t dy2 = 0;
+                ok = reader.signedVarint(dx1) && reader.signedVarint(dy1) && reader.signedVarint(dx2)
+                    && reader.signedVarint(dy2) && addDelta(prev.x1, dx1, q.x1) && addDelta(prev.y1, dy1, q.y1)
+                    && addDelta(prev.x2, dx2, q.x2) && addDelta(prev.y2, dy2, q.y2);
+                q.cls = prev.cls;
+            }
+        }
+        uint8_t score = 0;
+        ok = ok && reader.byte(score);
+        q.track_id = -1;
+        if (ok && has_tracks) {
+            ok = reader.int32(q.track_id);
+            record.output.track_ids[i] = q.track_id;
+        }
+
+        core::Box& box = record.output.boxes[i];
+        box.x1 = static_cast<float>(q.x1);
+        box.y1 = static_cast<float>(q.y1);
+        box.x2 = static_cast<float>(q.x2);
+        box.y2 = static_cast<float>(q.y2);
+        box.cls = q.cls;
+        box.score = static_cast<float>(score) / 255.0f;
+    }
+
+    if (ok && has_masks) {
+        record.output.masks.resize(count);
+        for (size_t i = 0; i < count && ok; ++i) {
+            ok = readMask(reader, record.output.masks[i]);
+        }
+    }
+    if (!ok || reader.remaining() != 0) {
+        synced_ = false;
+        return false;
+    }
+
+    previous_.swap(current_);
+    seq_ = static_cast<uint32_t>(seq);
+    last_pts_us_ = pts_us;
+    synced_ = true;
+    return true;
+}
+
+} // namespace va::media
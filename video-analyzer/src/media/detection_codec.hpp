@@ -0,0 +1,114 @@
+#pragma once
+
+#include "core/utils.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace va::media {
+
+enum class MetadataFormat {
+    Binary,  // versioned, delta-coded records (see docs/webrtc-protocol.md)
+    Json     // one self-contained JSON object per frame
+};
+
+MetadataFormat parseMetadataFormat(const std::string& value);
+const char* metadataFormatName(MetadataFormat format);
+
+// Per-frame detection record sent to metadata consumers instead of (or next
+// to) the rendered video.
+struct DetectionFrameInfo {
+    std::string stream_id;
+    double pts_ms {0.0};
+    int width {0};
+    int height {0};
+};
+
+// Compact JSON, one object per frame:
+//   {"v":1,"stream":"cam:det_720p","pts":1234.5,"w":1280,"h":720,
+//    "det":[[x1,y1,x2,y2,cls,score],...]}
+// Coordinates are rounded to whole frame pixels, scores to three decimals.
+void encodeDetectionsJson(const DetectionFrameInfo& info,
+                          const core::ModelOutput& output,
+                          std::vector<uint8_t>& out);
+
+// Binary wire format, version 1. Integers are LEB128 varints, signed values
+// zigzag-coded. Boxes are quantised to whole frame pixels and scores to
+// 1/255. A keyframe is self-contained; a delta frame codes each box against a
+// box of the previous frame, so a lost record breaks the chain until the next
+// keyframe.
+constexpr uint8_t kDetectionWireVersion = 1;
+
+struct DetectionRecord {
+    uint32_t seq {0};
+    bool keyframe {false};
+    DetectionFrameInfo info;
+    core::ModelOutput output;
+};
+
+// Stateful encoder; one per metadata stream, not thread-safe.
+class DetectionEncoder {
+public:
+    struct Options {
+        // Frames between self-contained records; also bounds how long a
+        // consumer that joins mid-stream waits before it can decode.
+        int keyframe_interval {30};
+    };
+
+    DetectionEncoder();
+    explicit DetectionEncoder(Options options);
+
+    void encode(const DetectionFrameInfo& info, const core::ModelOutput& output, std::vector<uint8_t>& out);
+    // The next record is written as a keyframe.
+    void requestKeyframe() { force_keyframe_ = true; }
+    // Whether the record written by the last encode() was a keyframe.
+    bool lastWasKeyframe() const { return last_keyframe_; }
+
+    struct QuantBox {
+        int32_t x1 {0};
+        int32_t y1 {0};
+        int32_t x2 {0};
+        int32_t y2 {0};
+        int32_t cls {0};
+        int32_t track_id {-1};
+    };
+
+private:
+    // Index of the unused previous box cheapest to delta against, or -1.
+    int pickReference(const QuantBox& box, bool use_tracks);
+
+    Options options_;
+    bool force_keyframe_ {true};
+    bool last_keyframe_ {false};
+    uint32_t seq_ {0};
+    uint32_t frames_since_key_ {0};
+    int64_t last_pts_us_ {0};
+    std::string stream_id_;
+    int width_ {0};
+    int height_ {0};
+    std::vector<QuantBox> previous_;
+    std::vector<QuantBox> current_;
+    std::vector<uint8_t> used_;
+};
+
+// Mirror of DetectionEncoder. decode() returns false for malformed records
+// and for delta records that cannot be applied (missing keyframe or a gap in
+// seq); the decoder then waits for the next keyframe.
+class DetectionDecoder {
+public:
+    bool decode(const uint8_t* data, size_t size, DetectionRecord& record);
+    void reset();
+
+private:
+    bool synced_ {false};
+    uint32_t seq_ {0};
+    int64_t last_pts_us_ {0};
+    std::string stream_id_;
+    int width_ {0};
+    int height_ {0};
+    std::vector<DetectionEncoder::QuantBox> previous_;
+    std::vector<DetectionEncoder::QuantBox> current_;
+};
+
+} // namespace va::media
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "core/utils.hpp"
+#include "media/packet_buffer.hpp"
 
 #include <string>
 #include <vector>
@@ -22,17 +23,35 @@ public:
         std::string tune;
         std::string profile;
         std::string codec {"h264"};
+        // 0 lets the codec pick. Slice threading splits each picture and
+        // adds no delay; frame threading encodes several pictures at once
+        // and delays output by about one frame per thread.
+        int threads {1};
+        std::string thread_type {"slice"};
     };
 
     virtual bool open(const Settings& settings) = 0;
     struct Packet {
-        std::vector<uint8_t> data;
+        // Shared with the transport and its subscribers; never modified once
+        // encode() returns.
+        PacketBuffer data;
         bool keyframe {false};
         double pts_ms {0.0};
     };
 
     virtual bool encode(const core::Frame& frame, Packet& out_packet) = 0;
     virtual void close() = 0;
+    // Makes the next encoded picture an IDR frame. Safe to call from any
+    // thread; encoders where every picture is a keyframe ignore it.
+    virtual void requestKeyframe() {}
+    // Runtime rate control, applied before the next picture without
+    // reopening the codec. Return false when the encoder cannot honour it.
+    // A framerate below Settings::fps is reached by dropping input frames.
+    virtual bool setBitrate(int /*kbps*/) { return false; }
+    virtual bool setFramerate(int /*fps*/) { return false; }
+    // Rate currently in effect; 0 when unknown.
+    virtual int bitrateKbps() const { return 0; }
+    virtual int framerate() const { return 0; }
 };
 
 } // namespace va::media
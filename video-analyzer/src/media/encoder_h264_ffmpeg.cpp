@@ -1,7 +1,10 @@
 #include "media/encoder_h264_ffmpeg.hpp"
 
+#include "core/color_convert.hpp"
+#include "core/utils.hpp"
+
 #include <algorithm>
-#include <cctype>
+#include <cstring>
 
 #include <opencv2/core.hpp>
 
@@ -27,6 +30,36 @@ namespace va::media {
 #ifndef FF_PROFILE_H264_HIGH
 #define FF_PROFILE_H264_HIGH 100
 #endif
+
+// AVCodecContext::get_encode_buffer appeared in FFmpeg 4.4.
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(58, 132, 100)
+#define VA_HAS_GET_ENCODE_BUFFER 1
+#endif
+
+namespace {
+
+#ifdef VA_HAS_GET_ENCODE_BUFFER
+void releasePacketBuffer(void* opaque, uint8_t* /*data*/) {
+    delete static_cast<PacketBuffer*>(opaque);
+}
+
+// Lets DR1 encoders write the bitstream into a PacketBuffer with transport
+// headroom, so the packet never has to be copied out of the AVPacket.
+int getEncodeBuffer(AVCodecContext* /*ctx*/, AVPacket* pkt, int /*flags*/) {
+    const size_t padded = static_cast<size_t>(pkt->size) + AV_INPUT_BUFFER_PADDING_SIZE;
+    auto* holder = new PacketBuffer(PacketBuffer::allocate(padded));
+    pkt->buf = av_buffer_create(holder->data(), padded, releasePacketBuffer, holder, 0);
+    if (!pkt->buf) {
+        delete holder;
+        return AVERROR(ENOMEM);
+    }
+    pkt->data = pkt->buf->data;
+    std::memset(pkt->data + pkt->size, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+    return 0;
+}
+#endif
+
+} // namespace
 #endif
 
 FfmpegH264Encoder::FfmpegH264Encoder() = default;
@@ -40,10 +73,7 @@ bool FfmpegH264Encoder::open(const Settings& settings) {
     if (codec_name.empty()) {
         codec_name = "h264";
     }
-    std::string codec_lower = codec_name;
-    std::transform(codec_lower.begin(), codec_lower.end(), codec_lower.begin(), [](unsigned char c) {
-        return static_cast<char>(std::tolower(c));
-    });
+    std::string codec_lower = core::toLower(codec_name);
 
     if (codec_lower == "jpeg" || codec_lower == "jpg" || codec_lower == "mjpeg") {
         use_jpeg_ = true;
@@ -51,6 +81,8 @@ bool FfmpegH264Encoder::open(const Settings& settings) {
         height_ = settings.height;
         fps_ = settings.fps;
         pts_ = 0;
+        target_fps_ = settings.fps;
+        frame_credit_ = 0.0;
         opened_ = true;
         return true;
     }
@@ -83,7 +115,8 @@ bool FfmpegH264Encoder::open(const Settings& settings) {
         return false;
     }
 
-    codec_ctx_->thread_count = 1;
+    codec_ctx_->thread_count = std::max(0, settings.threads);
+    codec_ctx_->thread_type = settings.thread_type == "frame" ? FF_THREAD_FRAME : FF_THREAD_SLICE;
     codec_ctx_->width = settings.width;
     codec_ctx_->height = settings.height;
     codec_ctx_->time_base = AVRational{1, settings.fps};
@@ -95,6 +128,13 @@ bool FfmpegH264Encoder::open(const Settings& settings) {
 
     std::string encoder_name = codec && codec->name ? codec->name : "";
 
+#ifdef VA_HAS_GET_ENCODE_BUFFER
+    if (codec->capabilities & AV_CODEC_CAP_DR1) {
+        codec_ctx_->get_encode_buffer = getEncodeBuffer;
+        zero_copy_ = true;
+    }
+#endif
+
     if (encoder_name == "libx264") {
         const char* preset = settings.preset.empty() ? "veryfast" : settings.preset.c_str();
         av_opt_set(codec_ctx_->priv_data, "preset", preset, 0);
@@ -105,6 +145,10 @@ bool FfmpegH264Encoder::open(const Settings& settings) {
         if (!settings.profile.empty()) {
             av_opt_set(codec_ctx_->priv_data, "profile", settings.profile.c_str(), 0);
         }
+        // Forced I pictures (requestKeyframe) must be IDRs for a new viewer.
+        av_opt_set(codec_ctx_->priv_data, "forced-idr", "1", 0);
+        // ABR mode: the wrapper reconfigures x264 when bit_rate changes.
+        runtime_bitrate_ = settings.bitrate_kbps > 0;
     } else if (encoder_name == "libopenh264") {
         if (settings.zero_latency) {
             av_opt_set(codec_ctx_->priv_data, "skip_frame", "default", 0);
@@ -149,25 +193,16 @@ bool FfmpegH264Encoder::open(const Settings& settings) {
         return false;
     }
 
-    sws_ctx_ = sws_getContext(settings.width,
-                              settings.height,
-                              AV_PIX_FMT_BGR24,
-                              settings.width,
-                              settings.height,
-                              AV_PIX_FMT_YUV420P,
-                              SWS_BILINEAR,
-                              nullptr,
-                              nullptr,
-                              nullptr);
-    if (!sws_ctx_) {
-        close();
-        return false;
-    }
-
+    // Colour conversion shares the encoder's thread budget; it runs before
+    // the encoder touches the picture.
+    convert_threads_ = std::max(0, settings.threads);
     width_ = settings.width;
     height_ = settings.height;
     fps_ = settings.fps;
     pts_ = 0;
+    bitrate_kbps_ = settings.bitrate_kbps;
+    target_fps_ = settings.fps;
+    frame_credit_ = 0.0;
     opened_ = true;
     return true;
 #else
@@ -178,6 +213,8 @@ bool FfmpegH264Encoder::open(const Settings& settings) {
     height_ = settings.height;
     fps_ = settings.fps;
     pts_ = 0;
+    target_fps_ = settings.fps;
+    frame_credit_ = 0.0;
     return true;
 #endif
 }
@@ -191,32 +228,62 @@ bool FfmpegH264Encoder::encode(const core::Frame& frame, Packet& out_packet) {
     }
 
     if (use_jpeg_) {
-        if (frame.bgr.empty() || frame.width <= 0 || frame.height <= 0) {
+        if (frame.pixels.empty() || frame.width <= 0 || frame.height <= 0) {
             return false;
         }
+        if (skipForFramerate()) {
+            out_packet.data.reset();
+            out_packet.keyframe = false;
+            out_packet.pts_ms = frame.pts_ms;
+            return true;
+        }
 
-        width_ = frame.width;
-        height_ = frame.height;
+        return encodeJpeg(frame, out_packet);
+    }
 
-        const cv::Mat image(height_, width_, CV_8UC3, const_cast<uint8_t*>(frame.bgr.data()));
-        std::vector<int> params{cv::IMWRITE_JPEG_QUALITY, jpeg_quality_};
-        if (!cv::imencode(".jpg", image, out_packet.data, params)) {
-            return false;
-        }
-        out_packet.keyframe = true;
+    if (frame.width != width_ || frame.height != height_) {
+        return false;
+    }
+
+    applyRateChanges();
+    if (skipForFramerate()) {
+        // The dropped frame still advances pts, so rate control sees the
+        // real spacing between pictures.
+        ++pts_;
+        out_packet.data.reset();
+        out_packet.keyframe = false;
         out_packet.pts_ms = frame.pts_ms;
         return true;
     }
 
-    if (frame.width != width_ || frame.height != height_) {
+    if (frame.pixels.size() < core::frameBytes(frame.format, width_, height_)) {
         return false;
     }
-
-    const uint8_t* src_slices[1] = { frame.bgr.data() };
-    int src_stride[1] = { frame.width * 3 };
-    sws_scale(sws_ctx_, src_slices, src_stride, 0, height_, frame_->data, frame_->linesize);
+    // The encoder may still reference the previous picture's buffer.
+    if (av_frame_make_writable(frame_) < 0) {
+        return false;
+    }
+    if (frame.format == core::PixelFormat::I420) {
+        // Decoded YUV the renderer left untouched skips colour conversion.
+        const auto src = core::i420Planes(const_cast<uint8_t*>(frame.pixels.data()), width_, height_);
+        const int chroma_width = (width_ + 1) / 2;
+        const int chroma_height = (height_ + 1) / 2;
+        av_image_copy_plane(frame_->data[0], frame_->linesize[0], src.y, static_cast<int>(src.y_stride), width_, height_);
+        av_image_copy_plane(frame_->data[1], frame_->linesize[1], src.u, static_cast<int>(src.u_stride), chroma_width, chroma_height);
+        av_image_copy_plane(frame_->data[2], frame_->linesize[2], src.v, static_cast<int>(src.v_stride), chroma_width, chroma_height);
+    } else {
+        core::I420Planes dst;
+        dst.y = frame_->data[0];
+        dst.y_stride = static_cast<size_t>(frame_->linesize[0]);
+        dst.u = frame_->data[1];
+        dst.u_stride = static_cast<size_t>(frame_->linesize[1]);
+        dst.v = frame_->data[2];
+        dst.v_stride = static_cast<size_t>(frame_->linesize[2]);
+        core::bgrToI420(frame.pixels.data(), static_cast<size_t>(width_) * 3, width_, height_, dst, convert_threads_);
+    }
 
     frame_->pts = pts_++;
+    frame_->pict_type = keyframe_requested_.exchange(false) ? AV_PICTURE_TYPE_I : AV_PICTURE_TYPE_NONE;
 
     int ret = avcodec_send_frame(codec_ctx_, frame_);
     if (ret < 0) {
@@ -225,7 +292,7 @@ bool FfmpegH264Encoder::encode(const core::Frame& frame, Packet& out_packet) {
 
     ret = avcodec_receive_packet(codec_ctx_, packet_);
     if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
-        out_packet.data.clear();
+        out_packet.data.reset();
         out_packet.keyframe = false;
         out_packet.pts_ms = frame.pts_ms;
         return true;
@@ -234,7 +301,17 @@ bool FfmpegH264Encoder::encode(const core::Frame& frame, Packet& out_packet) {
         return false;
     }
 
-    out_packet.data.assign(packet_->data, packet_->data + packet_->size);
+    out_packet.data.reset();
+    if (zero_copy_ && packet_->buf) {
+        const auto* holder = static_cast<const PacketBuffer*>(av_buffer_get_opaque(packet_->buf));
+        if (holder && holder->data() == packet_->data) {
+            out_packet.data = *holder;
+            out_packet.data.truncate(static_cast<size_t>(packet_->size));
+        }
+    }
+    if (out_packet.data.empty()) {
+        out_packet.data = PacketBuffer::copyOf(packet_->data, static_cast<size_t>(packet_->size));
+    }
     out_packet.keyframe = (packet_->flags & AV_PKT_FLAG_KEY) != 0;
     out_packet.pts_ms = frame.pts_ms;
     av_packet_unref(packet_);
@@ -243,22 +320,96 @@ bool FfmpegH264Encoder::encode(const core::Frame& frame, Packet& out_packet) {
     if (!opened_) {
         return false;
     }
-    if (frame.bgr.empty() || frame.width <= 0 || frame.height <= 0) {
+    if (frame.pixels.empty() || frame.width <= 0 || frame.height <= 0) {
         return false;
     }
-    width_ = frame.width;
-    height_ = frame.height;
-    const cv::Mat image(height_, width_, CV_8UC3, const_cast<uint8_t*>(frame.bgr.data()));
+    if (skipForFramerate()) {
+        out_packet.data.reset();
+        out_packet.keyframe = false;
+        out_packet.pts_ms = frame.pts_ms;
+        return true;
+    }
+    return encodeJpeg(frame, out_packet);
+#endif
+}
+
+bool FfmpegH264Encoder::encodeJpeg(const core::Frame& frame, Packet& out_packet) {
+    core::Frame bgr = frame;
+    if (!core::ensureBgr(bgr) || bgr.pixels.size() < core::frameBytes(core::PixelFormat::Bgr24, bgr.width, bgr.height)) {
+        return false;
+    }
+    width_ = bgr.width;
+    height_ = bgr.height;
+
+    const cv::Mat image(height_, width_, CV_8UC3, const_cast<uint8_t*>(bgr.pixels.data()));
     std::vector<int> params{cv::IMWRITE_JPEG_QUALITY, jpeg_quality_};
-    if (!cv::imencode(".jpg", image, out_packet.data, params)) {
+    if (!cv::imencode(".jpg", image, jpeg_buffer_, params)) {
         return false;
     }
+    out_packet.data = PacketBuffer::copyOf(jpeg_buffer_.data(), jpeg_buffer_.size());
     out_packet.keyframe = true;
     out_packet.pts_ms = frame.pts_ms;
     return true;
+}
+
+void FfmpegH264Encoder::requestKeyframe() {
+    keyframe_requested_ = true;
+}
+
+bool FfmpegH264Encoder::setBitrate(int kbps) {
+    if (kbps <= 0 || !runtime_bitrate_) {
+        return false;
+    }
+    pending_bitrate_kbps_ = kbps;
+    return true;
+}
+
+bool FfmpegH264Encoder::setFramerate(int fps) {
+    if (fps <= 0) {
+        return false;
+    }
+    target_fps_ = fps;
+    return true;
+}
+
+int FfmpegH264Encoder::bitrateKbps() const {
+    return bitrate_kbps_.load();
+}
+
+int FfmpegH264Encoder::framerate() const {
+    const int target = target_fps_.load();
+    return fps_ > 0 && target > fps_ ? fps_ : target;
+}
+
+void FfmpegH264Encoder::applyRateChanges() {
+#ifdef USE_FFMPEG
+    const int kbps = pending_bitrate_kbps_.exchange(0);
+    if (kbps <= 0 || !codec_ctx_ || kbps == bitrate_kbps_.load()) {
+        return;
+    }
+    // libx264 compares bit_rate with its parameters before every picture and
+    // calls x264_encoder_reconfig() when they differ.
+    codec_ctx_->bit_rate = static_cast<int64_t>(kbps) * 1000;
+    bitrate_kbps_ = kbps;
 #endif
 }
 
+// Credit-based decimation: every input frame earns target/fps of a picture,
+// so e.g. 15 of 30 fps encodes every other frame.
+bool FfmpegH264Encoder::skipForFramerate() {
+    const int target = target_fps_.load();
+    if (fps_ <= 0 || target <= 0 || target >= fps_) {
+        frame_credit_ = 0.0;
+        return false;
+    }
+    frame_credit_ += static_cast<double>(target) / static_cast<double>(fps_);
+    if (frame_credit_ < 1.0) {
+        return true;
+    }
+    frame_credit_ -= 1.0;
+    return false;
+}
+
 void FfmpegH264Encoder::close() {
 #ifdef USE_FFMPEG
     if (packet_) {
@@ -273,16 +424,22 @@ void FfmpegH264Encoder::close() {
         avcodec_free_context(&codec_ctx_);
         codec_ctx_ = nullptr;
     }
-    if (sws_ctx_) {
-        sws_freeContext(sws_ctx_);
-        sws_ctx_ = nullptr;
-    }
 #endif
     width_ = 0;
     height_ = 0;
     fps_ = 0;
     pts_ = 0;
     use_jpeg_ = false;
+    convert_threads_ = 1;
+    keyframe_requested_ = false;
+    runtime_bitrate_ = false;
+    pending_bitrate_kbps_ = 0;
+    bitrate_kbps_ = 0;
+    target_fps_ = 0;
+    frame_credit_ = 0.0;
+#ifdef USE_FFMPEG
+    zero_copy_ = false;
+#endif
     opened_ = false;
 }
 
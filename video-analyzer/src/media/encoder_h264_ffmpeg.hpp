@@ -2,14 +2,15 @@
 
 #include "media/encoder.hpp"
 
+#include <atomic>
 #include <string>
+#include <vector>
 
 #ifdef USE_FFMPEG
 extern "C" {
 #include <libavcodec/avcodec.h>
 #include <libavutil/opt.h>
 #include <libavutil/imgutils.h>
-#include <libswscale/swscale.h>
 }
 #endif
 
@@ -25,8 +26,18 @@ public:
     bool open(const Settings& settings) override;
     bool encode(const core::Frame& frame, Packet& out_packet) override;
     void close() override;
+    void requestKeyframe() override;
+    bool setBitrate(int kbps) override;
+    bool setFramerate(int fps) override;
+    int bitrateKbps() const override;
+    int framerate() const override;
 
 private:
+    // Encode thread: picks up setBitrate()/setFramerate() requests.
+    void applyRateChanges();
+    bool skipForFramerate();
+    bool encodeJpeg(const core::Frame& frame, Packet& out_packet);
+
     bool opened_ {false};
     int width_ {0};
     int height_ {0};
@@ -34,11 +45,21 @@ private:
     int64_t pts_ {0};
     bool use_jpeg_ {false};
     int jpeg_quality_ {80};
+    int convert_threads_ {1};
+    std::vector<uint8_t> jpeg_buffer_;
+    std::atomic<bool> keyframe_requested_ {false};
+    // Only libx264 reconfigures its rate control on the fly.
+    std::atomic<bool> runtime_bitrate_ {false};
+    std::atomic<int> pending_bitrate_kbps_ {0};
+    std::atomic<int> bitrate_kbps_ {0};
+    std::atomic<int> target_fps_ {0};
+    double frame_credit_ {0.0};
 #ifdef USE_FFMPEG
     AVCodecContext* codec_ctx_ {nullptr};
     AVFrame* frame_ {nullptr};
     AVPacket* packet_ {nullptr};
-    SwsContext* sws_ctx_ {nullptr};
+    // Packets are written straight into PacketBuffers (get_encode_buffer).
+    bool zero_copy_ {false};
 #endif
 };
 
@@ -0,0 +1,151 @@
+#include "media/frame_ring.hpp"
+
+#include "core/utils.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace va::media {
+
+BufferPolicy parseBufferPolicy(const std::string& value) {
+    const std::string lower = core::toLower(value);
+    if (lower == "all" || lower == "keep_all" || lower == "keep-all") {
+        return BufferPolicy::KeepAll;
+    }
+    return BufferPolicy::KeepLatest;
+}
+
+const char* bufferPolicyName(BufferPolicy policy) {
+    return policy == BufferPolicy::KeepAll ? "keep_all" : "keep_latest";
+}
+
+FrameRing::FrameRing(size_t capacity, BufferPolicy policy)
+    : slots_(std::max<size_t>(capacity, 1)), policy_(policy) {}
+
+bool FrameRing::push(core::Frame&& frame, uint64_t generation) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (closed_) {
+        return false;
+    }
+    if (generation != generation_) {
+        return true;
+    }
+
+    if (count_ == slots_.size()) {
+        if (policy_ == BufferPolicy::KeepLatest) {
+            head_ = (head_ + 1) % slots_.size();
+            --count_;
+            ++dropped_frames_;
+        } else {
+            ++blocked_pushes_;
+            not_full_.wait(lock, [this]() { return closed_ || count_ < slots_.size(); });
+            if (closed_) {
+                return false;
+            }
+            if (generation != generation_) {
+                return true;
+            }
+        }
+    }
+
+    const size_t tail = (head_ + count_) % slots_.size();
+    slots_[tail] = std::move(frame);
+    ++count_;
+    lock.unlock();
+    not_empty_.notify_one();
+    return true;
+}
+
+bool FrameRing::tryPop(core::Frame& frame) {
+    {
+        std::scoped_lock lock(mutex_);
+        if (count_ == 0) {
+            return false;
+        }
+        frame = std::move(slots_[head_]);
+        slots_[head_] = core::Frame{};
+        head_ = (head_ + 1) % slots_.size();
+        --count_;
+    }
+    not_full_.notify_one();
+    return true;
+}
+
+bool FrameRing::popFor(core::Frame& frame, std::chrono::milliseconds timeout) {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait_for(lock, timeout, [this]() { return closed_ || count_ > 0; });
+        if (closed_ || count_ == 0) {
+            return false;
+        }
+        frame = std::move(slots_[head_]);
+        slots_[head_] = core::Frame{};
+        head_ = (head_ + 1) % slots_.size();
+        --count_;
+    }
+    not_full_.notify_one();
+    return true;
+}
+
+void FrameRing::open() {
+    std::scoped_lock lock(mutex_);
+    closed_ = false;
+}
+
+void FrameRing::close() {
+    {
+        std::scoped_lock lock(mutex_);
+        closed_ = true;
+    }
+    not_full_.notify_all();
+    not_empty_.notify_all();
+}
+
+void FrameRing::clear() {
+    {
+        std::scoped_lock lock(mutex_);
+        for (auto& slot : slots_) {
+            slot = core::Frame{};
+        }
+        head_ = 0;
+        count_ = 0;
+    }
+    not_full_.notify_all();
+}
+
+uint64_t FrameRing::beginGeneration() {
+    uint64_t generation = 0;
+    {
+        std::scoped_lock lock(mutex_);
+        for (auto& slot : slots_) {
+            slot = core::Frame{};
+        }
+        head_ = 0;
+        count_ = 0;
+        generation = ++generation_;
+    }
+    not_full_.notify_all();
+    return generation;
+}
+
+uint64_t FrameRing::generation() const {
+    std::scoped_lock lock(mutex_);
+    return generation_;
+}
+
+size_t FrameRing::size() const {
+    std::scoped_lock lock(mutex_);
+    return count_;
+}
+
+uint64_t FrameRing::droppedFrames() const {
+    std::scoped_lock lock(mutex_);
+    return dropped_frames_;
+}
+
+uint64_t FrameRing::blockedPushes() const {
+    std::scoped_lock lock(mutex_);
+    return blocked_pushes_;
+}
+
+} // namespace va::media
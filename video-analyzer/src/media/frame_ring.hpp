@@ -0,0 +1,66 @@
+#pragma once
+
+#include "core/utils.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace va::media {
+
+enum class BufferPolicy {
+    KeepLatest, // evict the oldest frame when full, the decoder never waits
+    KeepAll     // the decoder waits for the consumer when full, nothing is dropped
+};
+
+BufferPolicy parseBufferPolicy(const std::string& value);
+const char* bufferPolicyName(BufferPolicy policy);
+
+// Bounded hand-off between a source's decode thread and the pipeline worker.
+class FrameRing {
+public:
+    explicit FrameRing(size_t capacity = 2, BufferPolicy policy = BufferPolicy::KeepLatest);
+
+    // Producer side. Returns false once the ring has been closed. A frame
+    // read before the latest beginGeneration() is dropped.
+    bool push(core::Frame&& frame, uint64_t generation);
+    // Consumer side, never blocks.
+    bool tryPop(core::Frame& frame);
+    // Consumer side, waits up to `timeout` for a frame. Returns false on
+    // timeout and at once after close().
+    bool popFor(core::Frame& frame, std::chrono::milliseconds timeout);
+
+    void open();
+    void close();
+    void clear();
+    // Drops the buffered frames and any still being decoded for the old
+    // generation (a source switch). Returns the new generation.
+    uint64_t beginGeneration();
+    uint64_t generation() const;
+
+    size_t size() const;
+    size_t capacity() const { return slots_.size(); }
+    BufferPolicy policy() const { return policy_; }
+    uint64_t droppedFrames() const;
+    uint64_t blockedPushes() const;
+
+private:
+    std::vector<core::Frame> slots_;
+    BufferPolicy policy_;
+    size_t head_ {0};
+    size_t count_ {0};
+    bool closed_ {false};
+    uint64_t generation_ {0};
+    uint64_t dropped_frames_ {0};
+    uint64_t blocked_pushes_ {0};
+
+    mutable std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+};
+
+} // namespace va::media
@@ -0,0 +1,57 @@
+#include "media/packet_buffer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace va::media {
+
+PacketBuffer PacketBuffer::allocate(size_t size, size_t headroom) {
+    PacketBuffer buffer;
+    buffer.storage_ = std::shared_ptr<uint8_t[]>(new uint8_t[headroom + size]);
+    buffer.offset_ = headroom;
+    buffer.headroom_ = headroom;
+    buffer.size_ = size;
+    return buffer;
+}
+
+PacketBuffer PacketBuffer::copyOf(const uint8_t* data, size_t size, size_t headroom) {
+    PacketBuffer buffer = allocate(size, headroom);
+    if (data && size > 0) {
+        std::memcpy(buffer.data(), data, size);
+    }
+    return buffer;
+}
+
+void PacketBuffer::reset() {
+    storage_.reset();
+    offset_ = 0;
+    headroom_ = 0;
+    size_ = 0;
+}
+
+void PacketBuffer::truncate(size_t size) {
+    size_ = std::min(size_, size);
+}
+
+uint8_t* PacketBuffer::prepend(size_t bytes) {
+    if (!storage_ || bytes > headroom_) {
+        return nullptr;
+    }
+    offset_ -= bytes;
+    headroom_ -= bytes;
+    size_ += bytes;
+    return data();
+}
+
+PacketBuffer PacketBuffer::slice(size_t offset, size_t length) const {
+    PacketBuffer view;
+    if (!storage_ || offset >= size_) {
+        return view;
+    }
+    view.storage_ = storage_;
+    view.offset_ = offset_ + offset;
+    view.size_ = std::min(length, size_ - offset);
+    return view;
+}
+
+} // namespace va::media
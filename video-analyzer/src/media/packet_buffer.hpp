@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace va::media {
+
+// Reference-counted encoded payload. Copies of a PacketBuffer share storage,
+// so a packet travels from the encoder through the transport to every
+// subscriber without being copied. Spare bytes in front of the payload
+// (headroom) let a transport add its framing header in place.
+//
+// The payload is written once by its producer and read-only after it has
+// been handed on; prepend() only touches headroom no other view covers.
+class PacketBuffer {
+public:
+    // Room for the DataChannel length prefix and an RTP-style header.
+    static constexpr size_t kDefaultHeadroom = 16;
+
+    PacketBuffer() = default;
+
+    static PacketBuffer allocate(size_t size, size_t headroom = kDefaultHeadroom);
+    static PacketBuffer copyOf(const uint8_t* data, size_t size, size_t headroom = kDefaultHeadroom);
+
+    const uint8_t* data() const { return storage_ ? storage_.get() + offset_ : nullptr; }
+    uint8_t* data() { return storage_ ? storage_.get() + offset_ : nullptr; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    size_t headroom() const { return headroom_; }
+
+    void reset();
+    // Keeps the first `size` bytes of the payload.
+    void truncate(size_t size);
+    // Grows the payload `bytes` into the headroom and returns its new start,
+    // or nullptr when the headroom is too small.
+    uint8_t* prepend(size_t bytes);
+    // View of [offset, offset + length) sharing this buffer's storage. Views
+    // have no headroom of their own.
+    PacketBuffer slice(size_t offset, size_t length) const;
+
+private:
+    std::shared_ptr<uint8_t[]> storage_;
+    size_t offset_ {0};   // payload start within storage_
+    size_t headroom_ {0};
+    size_t size_ {0};
+};
+
+} // namespace va::media
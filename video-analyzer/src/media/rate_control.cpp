@@ -0,0 +1,22 @@
+#include "media/rate_control.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace va::media {
+
+bool RateController::update(Signal signal) {
+    double next = scale_;
+    if (signal == Signal::Congested) {
+        next = std::max(kMinScale, scale_ * kDecrease);
+    } else if (signal == Signal::Clear) {
+        next = std::min(1.0, scale_ + kIncrease);
+    }
+    if (std::abs(next - scale_) < 1e-9) {
+        return false;
+    }
+    scale_ = next;
+    return true;
+}
+
+} // namespace va::media
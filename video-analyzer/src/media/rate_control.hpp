@@ -0,0 +1,30 @@
+#pragma once
+
+namespace va::media {
+
+// Turns a periodic congestion verdict about a transport's subscribers into a
+// scale for the encoder's configured rate: multiplicative decrease while
+// they fall behind, additive increase once they keep up again. Not
+// thread-safe; transports drive it from one thread about once per second.
+class RateController {
+public:
+    enum class Signal {
+        Congested, // queues grow, packets are skipped or lost
+        Steady,    // no loss, but no headroom either: hold the rate
+        Clear      // subscribers keep up with room to spare
+    };
+
+    static constexpr double kMinScale = 0.25;
+    static constexpr double kDecrease = 0.7;
+    static constexpr double kIncrease = 0.05;
+
+    // Returns true when the scale changed.
+    bool update(Signal signal);
+    void reset() { scale_ = 1.0; }
+    double scale() const { return scale_; }
+
+private:
+    double scale_ {1.0};
+};
+
+} // namespace va::media
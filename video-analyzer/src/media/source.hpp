@@ -2,15 +2,35 @@
 
 #include "core/utils.hpp"
 
+#include <chrono>
 #include <memory>
 #include <string>
 
 namespace va::media {
 
 struct SourceStats {
+    std::string state;            // connecting | streaming | stalled | backoff | failed
+    double last_frame_age_ms {0.0};
+    uint32_t consecutive_failures {0};
+    uint64_t reconnects {0};      // inputs reopened after being lost
+    double retry_in_ms {0.0};     // backoff: time until the next open attempt
+    std::string decoder;          // ffmpeg | opencv
+    std::string pixel_format;     // bgr24 | i420
     double fps {0.0};
     double avg_latency_ms {0.0};
     uint64_t last_frame_id {0};
+    double last_pts_ms {0.0};     // stream time of the newest decoded frame
+    std::string buffer_policy;
+    uint64_t buffer_capacity {0};
+    uint64_t buffered_frames {0};
+    uint64_t skipped_frames {0};  // decoded but not delivered because of the frame stride
+    uint64_t dropped_frames {0};  // evicted by keep_latest before the pipeline read them
+    uint64_t blocked_pushes {0};  // keep_all: times the decode thread waited on the pipeline
+    uint64_t switches {0};          // completed switchUri() swaps
+    double last_switch_gap_ms {0.0}; // last frame of the old URI to the first of the new one
+    bool switch_pending {false};    // the new URI is still being opened and primed
+    uint64_t failed_switches {0};   // switches whose URI could not be opened or primed
+    std::string last_switch_error;  // why the latest switch failed, cleared by one that succeeds
 };
 
 class IFrameSource {
@@ -19,11 +39,18 @@ public:
     virtual bool start() = 0;
     virtual void stop() = 0;
     virtual bool read(core::Frame& frame) = 0;
+    // Like read(), but blocks up to `timeout` for the next frame.
+    virtual bool readFor(core::Frame& frame, std::chrono::milliseconds timeout) = 0;
+    // Releases readFor() callers at once and makes later calls return false
+    // until the next start(); stop() may still wait for the decode thread.
+    virtual void interruptReads() = 0;
     virtual SourceStats stats() const = 0;
 };
 
 class ISwitchableSource : public IFrameSource {
 public:
+    // Returns once the switch is accepted; the new URI is opened in the
+    // background and the outcome shows up in stats().
     virtual bool switchUri(const std::string& uri) = 0;
 };
 
@@ -0,0 +1,781 @@
+#include "media/source_ffmpeg_rtsp.hpp"
+
+#include "core/color_convert.hpp"
+#include "core/logger.hpp"
+
+#include <algorithm>
+
+#ifdef USE_FFMPEG
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/imgutils.h>
+#include <libswscale/swscale.h>
+}
+#endif
+
+namespace va::media {
+
+namespace {
+int64_t steadyNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Inputs without a network protocol (plain paths, file:) are read faster than
+// real time, so their frames are paced to the stream clock.
+bool isLocalInput(const std::string& uri) {
+    return uri.find("://") == std::string::npos || uri.rfind("file:", 0) == 0;
+}
+
+#ifdef USE_FFMPEG
+std::string errorString(int err) {
+    char buf[AV_ERROR_MAX_STRING_SIZE] = {0};
+    av_strerror(err, buf, sizeof(buf));
+    return buf;
+}
+#endif
+} // namespace
+
+#ifdef USE_FFMPEG
+struct FfmpegRtspSource::Input {
+    ~Input() {
+        if (sws_ctx) {
+            sws_freeContext(sws_ctx);
+        }
+        av_packet_free(&packet);
+        av_frame_free(&av_frame);
+        avcodec_free_context(&codec_ctx);
+        if (format_ctx) {
+            avformat_close_input(&format_ctx);
+        }
+    }
+
+    // stop(), or a newer switch while this input is still being prefetched;
+    // deadlines are checked separately.
+    bool interrupted() const {
+        return !running->load() || (switch_seq && switch_seq->load() != seq);
+    }
+
+    std::string uri;
+    AVFormatContext* format_ctx {nullptr};
+    AVCodecContext* codec_ctx {nullptr};
+    AVFrame* av_frame {nullptr};
+    AVPacket* packet {nullptr};
+    SwsContext* sws_ctx {nullptr};
+    int stream_index {-1};
+    AVRational time_base {1, 1000};
+    double frame_interval_ms {40.0};
+    bool draining {false};
+    bool pace {false};
+    bool keyframe_seen {false};  // packets before the first keyframe are not decoded
+    bool primed {false};         // av_frame holds a decoded frame not handed out yet
+
+    // Stream time of the first frame, and the offset that keeps pts_ms
+    // increasing across reopens and switches.
+    int64_t first_pts {0};
+    bool have_first_pts {false};
+    double pts_offset_ms {0.0};
+    std::chrono::steady_clock::time_point opened_at;
+    // Packets that keep arriving re-arm the read deadline, so a stream whose
+    // packets no longer decode is caught by this one instead.
+    std::chrono::steady_clock::time_point frame_deadline;
+
+    const std::atomic<bool>* running {nullptr};
+    const std::atomic<uint64_t>* switch_seq {nullptr}; // set while prefetching
+    uint64_t seq {0};
+    std::atomic<int64_t> deadline_ns {0};
+};
+#else
+struct FfmpegRtspSource::Input {};
+#endif
+
+FfmpegRtspSource::FfmpegRtspSource(std::string uri)
+    : FfmpegRtspSource(std::move(uri), Options{}) {}
+
+FfmpegRtspSource::FfmpegRtspSource(std::string uri, Options options)
+    : options_(std::move(options)),
+      ring_(options_.buffer_depth, options_.buffer_policy),
+      uri_(std::move(uri)),
+      health_(options_.reconnect) {}
+
+FfmpegRtspSource::~FfmpegRtspSource() {
+    stop();
+}
+
+bool FfmpegRtspSource::start() {
+#ifndef USE_FFMPEG
+    VA_LOG_ERROR() << "[RTSP] FfmpegRtspSource needs a build with FFmpeg; use decoder.impl: opencv";
+    return false;
+#else
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_.load()) {
+        return true;
+    }
+    ring_.clear();
+    ring_.open();
+    health_.reset();
+    frame_counter_ = 0;
+    skipped_frames_.store(0);
+    avg_latency_ms_ = 0.0;
+    last_delivered_ms_ = -1.0;
+    switched_ = false;
+    started_at_ = std::chrono::steady_clock::now();
+    last_frame_time_ = started_at_;
+    running_.store(true);
+    capture_thread_ = std::thread(&FfmpegRtspSource::captureLoop, this);
+    return true;
+#endif
+}
+
+void FfmpegRtspSource::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_.exchange(false)) {
+            return;
+        }
+    }
+    // Blocked libavformat calls return through interruptCallback() once
+    // running_ is false, in the capture and the prefetch thread alike.
+    wake_cv_.notify_all();
+    ring_.close();
+    if (capture_thread_.joinable()) {
+        capture_thread_.join();
+    }
+    // switchUri() no longer starts a prefetch once running_ is false.
+    if (prefetch_thread_.joinable()) {
+        prefetch_thread_.join();
+    }
+    input_.reset();
+    std::unique_ptr<Input> unused;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        unused = std::move(prefetched_);
+        pending_uri_.clear();
+    }
+    ring_.clear();
+}
+
+bool FfmpegRtspSource::read(core::Frame& frame) {
+    if (!running_.load() || !ring_.tryPop(frame)) {
+        return false;
+    }
+    recordQueued(frame);
+    return true;
+}
+
+bool FfmpegRtspSource::readFor(core::Frame& frame, std::chrono::milliseconds timeout) {
+    // Before start() the ring is open and empty, so this still waits out
+    // the timeout rather than returning at once.
+    if (!ring_.popFor(frame, timeout)) {
+        return false;
+    }
+    recordQueued(frame);
+    return true;
+}
+
+void FfmpegRtspSource::interruptReads() {
+    ring_.close();
+}
+
+void FfmpegRtspSource::recordQueued(const core::Frame& frame) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const double queued_ms = core::ms_now() - frame.capture_ms;
+    avg_latency_ms_ = avg_latency_ms_ == 0.0 ? queued_ms : avg_latency_ms_ + (queued_ms - avg_latency_ms_) / 10.0;
+}
+
+SourceStats FfmpegRtspSource::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    SourceStats stats;
+    health_.fillStats(stats);
+    stats.decoder = "ffmpeg";
+    stats.pixel_format = core::pixelFormatName(options_.output);
+    const auto now = std::chrono::steady_clock::now();
+    const double elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - started_at_).count();
+    if (elapsed > 0.0) {
+        stats.fps = static_cast<double>(frame_counter_) * 1000.0 / elapsed;
+    }
+    stats.avg_latency_ms = avg_latency_ms_;
+    stats.last_frame_id = frame_counter_;
+    stats.last_pts_ms = std::max(0.0, last_pts_ms_);
+    stats.skipped_frames = skipped_frames_.load();
+    stats.buffer_policy = bufferPolicyName(ring_.policy());
+    stats.buffer_capacity = ring_.capacity();
+    stats.buffered_frames = ring_.size();
+    stats.dropped_frames = ring_.droppedFrames();
+    stats.blocked_pushes = ring_.blockedPushes();
+    stats.switches = switches_;
+    stats.last_switch_gap_ms = last_switch_gap_ms_;
+    stats.switch_pending = !pending_uri_.empty();
+    stats.failed_switches = failed_switches_;
+    stats.last_switch_error = last_switch_error_;
+    return stats;
+}
+
+bool FfmpegRtspSource::switchUri(const std::string& uri) {
+#ifndef USE_FFMPEG
+    (void)uri;
+    return false;
+#else
+    std::unique_ptr<Input> superseded;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_.load()) {
+            uri_ = uri; // opened by the next start()
+            return true;
+        }
+        // A newer switch wins: an input primed for the previous one is
+        // dropped, and one still opening is interrupted through switch_seq_.
+        superseded = std::move(prefetched_);
+        pending_uri_ = uri;
+        switch_seq_.fetch_add(1);
+        if (!prefetching_) {
+            if (prefetch_thread_.joinable()) {
+                // Done with its last URI; it returns right after clearing prefetching_.
+                prefetch_thread_.join();
+            }
+            prefetching_ = true;
+            prefetch_thread_ = std::thread(&FfmpegRtspSource::prefetchLoop, this);
+        }
+    }
+    wake_cv_.notify_all(); // a failed source waits for exactly this
+    return true;
+#endif
+}
+
+void FfmpegRtspSource::waitForRetry(std::chrono::milliseconds delay) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    wake_cv_.wait_for(lock, delay, [this]() { return !running_.load() || prefetched_ != nullptr; });
+}
+
+void FfmpegRtspSource::waitForSwitch() {
+    // No timeout: a failed source sleeps until a switch starts, and one
+    // waiting for a switch until its URI opens or fails.
+    std::unique_lock<std::mutex> lock(mutex_);
+    const bool pending = !pending_uri_.empty();
+    wake_cv_.wait(lock, [&]() {
+        return !running_.load() || prefetched_ != nullptr || pending_uri_.empty() == pending;
+    });
+}
+
+#ifdef USE_FFMPEG
+
+void FfmpegRtspSource::captureLoop() {
+    while (running_.load()) {
+        std::unique_ptr<Input> next;
+        bool switching = false;
+        std::string uri;
+        uint64_t generation = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            next = std::move(prefetched_);
+            // Read together with prefetched_: a frame decoded from the old
+            // input after a switch no longer matches and is dropped.
+            generation = ring_.generation();
+            if (next) {
+                uri_ = next->uri;
+                pending_uri_.clear();
+                switch_from_ms_ = last_delivered_ms_;
+                switched_ = true;
+                health_.reset();
+            }
+            switching = !pending_uri_.empty();
+            uri = uri_;
+        }
+
+        if (next) {
+            adoptInput(std::move(next));
+        }
+        if (!input_) {
+            bool failed = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                failed = health_.state() == SourceState::Failed;
+                if (!switching && !failed) {
+                    health_.connecting();
+                }
+            }
+            if (switching || failed) {
+                // Reopening the old URI is pointless; wait for a new one.
+                waitForSwitch();
+                continue;
+            }
+            std::string error;
+            auto opened = openInput(uri, std::nullopt, error);
+            if (!opened) {
+                inputFailed(uri, error);
+                continue;
+            }
+            adoptInput(std::move(opened));
+        }
+
+        core::Frame frame;
+        if (!decodeFrame(*input_, frame)) {
+            const bool delivered = input_delivered_;
+            input_.reset();
+            if (!running_.load()) {
+                continue;
+            }
+            if (delivered) {
+                // A stream that was playing is reopened straight away.
+                VA_LOG_WARN() << "[RTSP] failed to read frame for URI " << uri << ", reconnecting";
+            } else {
+                // Opens but never produces a frame: back off like a failed open.
+                inputFailed(uri, "no frame decoded");
+            }
+            continue;
+        }
+        input_delivered_ = true;
+        if (input_->pace) {
+            paceTo(*input_, frame.pts_ms);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!running_.load()) {
+                continue;
+            }
+            const double now_ms = core::ms_now();
+            if (switched_) {
+                switched_ = false;
+                ++switches_;
+                if (switch_from_ms_ >= 0.0) {
+                    last_switch_gap_ms_ = now_ms - switch_from_ms_;
+                    VA_LOG_INFO() << "[RTSP] switched to " << uri_ << ", gap " << last_switch_gap_ms_ << " ms";
+                }
+            }
+            health_.frameDelivered();
+            frame_counter_++;
+            last_frame_time_ = std::chrono::steady_clock::now();
+            last_pts_ms_ = frame.pts_ms;
+            last_delivered_ms_ = now_ms;
+        }
+
+        ring_.push(std::move(frame), generation);
+    }
+}
+
+void FfmpegRtspSource::adoptInput(std::unique_ptr<Input> input) {
+    input->pts_offset_ms = decoded_pts_ms_ >= 0.0 ? decoded_pts_ms_ + input->frame_interval_ms : 0.0;
+    input->opened_at = std::chrono::steady_clock::now();
+    if (input->primed) {
+        // Primed a while ago by prefetchLoop().
+        input->frame_deadline = input->opened_at + std::chrono::milliseconds(std::max(options_.timeout_ms, 1000));
+    }
+    input->switch_seq = nullptr; // later switches must not interrupt the live input
+    next_due_ms_ = -1.0;
+    input_delivered_ = false;
+    input_ = std::move(input);
+}
+
+void FfmpegRtspSource::prefetchLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    // One attempt per switch; a switch that arrives meanwhile is served next.
+    while (running_.load() && !pending_uri_.empty() && !prefetched_) {
+        const std::string uri = pending_uri_;
+        const uint64_t seq = switch_seq_.load();
+        lock.unlock();
+
+        // The new input is opened and decoded up to its first keyframe here,
+        // while the capture thread keeps delivering the old one.
+        const auto started = std::chrono::steady_clock::now();
+        std::string error;
+        auto input = openInput(uri, seq, error);
+        const bool primed = input && primeInput(*input, error);
+        const auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                    std::chrono::steady_clock::now() - started).count();
+        if (!primed) {
+            input.reset(); // closing may still talk to the server, so not under mutex_
+        }
+
+        lock.lock();
+        if (!running_.load() || seq != switch_seq_.load()) {
+            // Superseded: the input is interrupted, so closing it is quick.
+            lock.unlock();
+            input.reset();
+            lock.lock();
+            continue;
+        }
+        if (primed) {
+            // Frames of the old input, queued or being decoded right now, are dropped.
+            ring_.beginGeneration();
+            prefetched_ = std::move(input);
+            last_switch_error_.clear();
+            VA_LOG_INFO() << "[RTSP] " << uri << " primed in " << elapsed_ms
+                          << " ms, switching at its first keyframe";
+        } else {
+            pending_uri_.clear();
+            ++failed_switches_;
+            last_switch_error_ = error;
+            VA_LOG_WARN() << "[RTSP] switch to URI " << uri << " failed (" << error << "), keeping " << uri_;
+        }
+        wake_cv_.notify_all();
+    }
+    prefetching_ = false;
+}
+
+void FfmpegRtspSource::inputFailed(const std::string& uri, const std::string& what) {
+    std::optional<std::chrono::milliseconds> delay;
+    uint32_t attempt = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        delay = health_.failed();
+        attempt = health_.failures();
+    }
+    if (!running_.load()) {
+        return;
+    }
+    if (!delay) {
+        VA_LOG_ERROR() << "[RTSP] " << what << " for URI " << uri << ", giving up after " << attempt
+                       << " attempts; switch the source to retry";
+        return;
+    }
+    // The first failure is a warning; repeats of a known outage only go to debug.
+    if (attempt == 1) {
+        VA_LOG_WARN() << "[RTSP] " << what << " for URI " << uri << ", retrying in " << delay->count() << " ms";
+    } else {
+        VA_LOG_DEBUG() << "[RTSP] " << what << " for URI " << uri << " (attempt " << attempt << "), retrying in "
+                       << delay->count() << " ms";
+    }
+    waitForRetry(*delay);
+}
+
+void FfmpegRtspSource::armDeadline(Input& input) const {
+    input.deadline_ns.store(options_.timeout_ms > 0
+                                ? steadyNowNs() + static_cast<int64_t>(options_.timeout_ms) * 1000000
+                                : 0);
+}
+
+void FfmpegRtspSource::paceTo(const Input& input, double pts_ms) {
+    const auto due = input.opened_at + std::chrono::microseconds(
+                                           static_cast<int64_t>(std::max(0.0, pts_ms - input.pts_offset_ms) * 1000.0));
+    std::unique_lock<std::mutex> lock(mutex_);
+    wake_cv_.wait_until(lock, due, [this]() { return !running_.load() || prefetched_ != nullptr; });
+}
+
+int FfmpegRtspSource::interruptCallback(void* opaque) {
+    const auto* input = static_cast<const Input*>(opaque);
+    if (input->interrupted()) {
+        return 1;
+    }
+    const int64_t deadline = input->deadline_ns.load();
+    return deadline > 0 && steadyNowNs() > deadline ? 1 : 0;
+}
+
+std::unique_ptr<FfmpegRtspSource::Input> FfmpegRtspSource::openInput(const std::string& uri,
+                                                                     std::optional<uint64_t> switch_seq,
+                                                                     std::string& error) {
+    auto input = std::make_unique<Input>();
+    input->uri = uri;
+    input->running = &running_;
+    if (switch_seq) {
+        input->switch_seq = &switch_seq_;
+        input->seq = *switch_seq;
+    }
+
+    AVDictionary* opts = nullptr;
+    if (uri.rfind("rtsp", 0) == 0) {
+        // tcp+udp with prefer_tcp tries interleaved TCP first and falls back
+        // to UDP; without it libavformat starts with UDP.
+        av_dict_set(&opts, "rtsp_transport", options_.prefer_tcp ? "tcp+udp" : "udp+tcp", 0);
+        if (options_.prefer_tcp) {
+            av_dict_set(&opts, "rtsp_flags", "prefer_tcp", 0);
+        }
+        if (options_.timeout_ms > 0) {
+            // Socket I/O timeout, in microseconds.
+            av_dict_set(&opts, "timeout", std::to_string(static_cast<int64_t>(options_.timeout_ms) * 1000).c_str(), 0);
+        }
+    }
+
+    input->format_ctx = avformat_alloc_context();
+    if (!input->format_ctx) {
+        av_dict_free(&opts);
+        error = "out of memory";
+        return nullptr;
+    }
+    input->format_ctx->interrupt_callback.callback = &FfmpegRtspSource::interruptCallback;
+    input->format_ctx->interrupt_callback.opaque = input.get();
+    if (options_.low_delay) {
+        input->format_ctx->flags |= AVFMT_FLAG_NOBUFFER;
+        input->format_ctx->max_analyze_duration = 1000000; // 1 s instead of 5 s before the first frame
+    }
+
+    armDeadline(*input);
+    int ret = avformat_open_input(&input->format_ctx, uri.c_str(), nullptr, &opts);
+    av_dict_free(&opts);
+    if (ret < 0) {
+        // avformat_open_input() frees the context on failure.
+        input->format_ctx = nullptr;
+        error = "avformat_open_input: " + errorString(ret);
+        return nullptr;
+    }
+    armDeadline(*input);
+    ret = avformat_find_stream_info(input->format_ctx, nullptr);
+    if (ret < 0) {
+        error = "no stream info: " + errorString(ret);
+        return nullptr;
+    }
+
+    const AVCodec* codec = nullptr;
+    input->stream_index = av_find_best_stream(input->format_ctx, AVMEDIA_TYPE_VIDEO, -1, -1, &codec, 0);
+    if (input->stream_index < 0 || !codec) {
+        error = "no decodable video stream";
+        return nullptr;
+    }
+    for (unsigned int i = 0; i < input->format_ctx->nb_streams; ++i) {
+        if (static_cast<int>(i) != input->stream_index) {
+            input->format_ctx->streams[i]->discard = AVDISCARD_ALL;
+        }
+    }
+    AVStream* stream = input->format_ctx->streams[input->stream_index];
+
+    AVCodecContext* codec_ctx = avcodec_alloc_context3(codec);
+    input->codec_ctx = codec_ctx;
+    if (!codec_ctx || avcodec_parameters_to_context(codec_ctx, stream->codecpar) < 0) {
+        error = std::string("failed to set up decoder ") + codec->name;
+        return nullptr;
+    }
+    codec_ctx->pkt_timebase = stream->time_base;
+
+    // Decode no larger than needed: lowres halves the picture inside the
+    // decoder (MJPEG, MPEG-2/4; H.264/HEVC have no lowres mode), and when the
+    // output is at most half size, deblocking is skipped on frames nothing
+    // else predicts from. The rest of the scaling happens in the sws pass.
+    const int coded_width = stream->codecpar->width;
+    const int coded_height = stream->codecpar->height;
+    const auto target = core::pictureRect(coded_width, coded_height, options_.target_width,
+                                          options_.target_height, options_.fit);
+    if (target.width > 0 && target.height > 0 && target.width * 2 <= coded_width && target.height * 2 <= coded_height) {
+        int lowres = 0;
+        while (lowres < codec->max_lowres && (coded_width >> (lowres + 1)) >= target.width
+               && (coded_height >> (lowres + 1)) >= target.height) {
+            ++lowres;
+        }
+        codec_ctx->lowres = lowres;
+        codec_ctx->skip_loop_filter = AVDISCARD_NONREF;
+    }
+    if (options_.skip_nonref && options_.frame_stride > 1) {
+        // Most of these would be dropped by the stride anyway.
+        codec_ctx->skip_frame = AVDISCARD_NONREF;
+    }
+    codec_ctx->thread_count = std::max(0, options_.threads);
+    const bool slice_threads = options_.thread_type == "slice";
+    codec_ctx->thread_type = slice_threads ? FF_THREAD_SLICE : FF_THREAD_FRAME;
+    // libavcodec turns frame threading off under LOW_DELAY, so the flag is
+    // only set when slice threading was asked for anyway.
+    if (options_.low_delay && slice_threads) {
+        codec_ctx->flags |= AV_CODEC_FLAG_LOW_DELAY;
+    }
+    ret = avcodec_open2(codec_ctx, codec, nullptr);
+    if (ret < 0) {
+        error = std::string("avcodec_open2 failed for ") + codec->name + ": " + errorString(ret);
+        return nullptr;
+    }
+
+    input->av_frame = av_frame_alloc();
+    input->packet = av_packet_alloc();
+    if (!input->av_frame || !input->packet) {
+        error = "out of memory";
+        return nullptr;
+    }
+
+    input->time_base = stream->time_base;
+    const AVRational rate = stream->avg_frame_rate.num > 0 ? stream->avg_frame_rate : stream->r_frame_rate;
+    if (rate.num > 0 && rate.den > 0) {
+        input->frame_interval_ms = 1000.0 / av_q2d(rate);
+    }
+    input->pace = isLocalInput(uri);
+    input->opened_at = std::chrono::steady_clock::now();
+    // Room for the keyframe wait plus the first decode.
+    input->frame_deadline = input->opened_at + 2 * std::chrono::milliseconds(std::max(options_.timeout_ms, 1000));
+
+    VA_LOG_INFO() << "[RTSP] opened " << uri << " (" << codec->name << ' '
+                  << stream->codecpar->width << 'x' << stream->codecpar->height
+                  << ", threads=" << codec_ctx->thread_count << ' ' << (slice_threads ? "slice" : "frame")
+                  << ", output=" << core::pixelFormatName(options_.output) << ' ' << target.width << 'x'
+                  << target.height << ", lowres=" << codec_ctx->lowres << ", stride=" << options_.frame_stride
+                  << (codec_ctx->skip_frame == AVDISCARD_NONREF ? " skip_nonref" : "") << ')';
+    return input;
+}
+
+bool FfmpegRtspSource::primeInput(Input& input, std::string& error) {
+    const int ret = receiveFrame(input);
+    if (ret < 0) {
+        error = "no frame decoded: " + errorString(ret);
+        return false;
+    }
+    input.primed = true;
+    return true;
+}
+
+int FfmpegRtspSource::receiveFrame(Input& input) {
+    while (!input.interrupted()) {
+        const int ret = avcodec_receive_frame(input.codec_ctx, input.av_frame);
+        const auto now = std::chrono::steady_clock::now();
+        if (ret == 0) {
+            input.frame_deadline = now + std::chrono::milliseconds(std::max(options_.timeout_ms, 1000));
+            return 0;
+        }
+        if (ret != AVERROR(EAGAIN) || input.draining) {
+            return ret; // AVERROR_EOF once a file input is drained
+        }
+        if (options_.timeout_ms > 0 && now > input.frame_deadline) {
+            if (!input.interrupted()) {
+                VA_LOG_WARN() << "[RTSP] no frame decoded for " << options_.timeout_ms << " ms from URI " << input.uri;
+            }
+            return AVERROR(ETIMEDOUT);
+        }
+
+        armDeadline(input);
+        const int read = av_read_frame(input.format_ctx, input.packet);
+        if (read == AVERROR_EOF) {
+            input.draining = true;
+            avcodec_send_packet(input.codec_ctx, nullptr);
+            continue;
+        }
+        if (read < 0) {
+            if (!input.interrupted()) {
+                VA_LOG_WARN() << "[RTSP] av_read_frame failed: " << errorString(read);
+            }
+            return read;
+        }
+        if (input.packet->stream_index == input.stream_index) {
+            // Decoding starts at a keyframe so the first picture (and the
+            // swap point of a switch) is clean; streams that never flag one,
+            // e.g. intra refresh, are decoded anyway after timeout_ms.
+            if (!input.keyframe_seen) {
+                const auto waited = std::chrono::steady_clock::now() - input.opened_at;
+                input.keyframe_seen = (input.packet->flags & AV_PKT_FLAG_KEY) != 0
+                                      || waited > std::chrono::milliseconds(std::max(options_.timeout_ms, 1000));
+            }
+            // Corrupt packets are common on lossy links; the decoder resyncs
+            // on its own, so errors here are not fatal.
+            const int sent = input.keyframe_seen ? avcodec_send_packet(input.codec_ctx, input.packet) : 0;
+            if (sent < 0 && sent != AVERROR(EAGAIN)) {
+                VA_LOG_DEBUG() << "[RTSP] decoder rejected packet: " << errorString(sent);
+            }
+        }
+        av_packet_unref(input.packet);
+    }
+    return AVERROR_EXIT;
+}
+
+bool FfmpegRtspSource::decodeFrame(Input& input, core::Frame& frame) {
+    while (running_.load()) {
+        // An input opened by switchUri() arrives holding its first (key)frame.
+        if (!input.primed && receiveFrame(input) < 0) {
+            return false;
+        }
+        input.primed = false;
+        const double pts_ms = framePtsMs(input);
+        // Frames the stride skips are never converted.
+        const bool converted = dueForDelivery(input, pts_ms) && convertFrame(input, frame, pts_ms);
+        av_frame_unref(input.av_frame);
+        if (converted) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool FfmpegRtspSource::dueForDelivery(const Input& input, double pts_ms) {
+    if (options_.frame_stride <= 1) {
+        return true;
+    }
+    // Paced on stream time rather than by counting, so frames the decoder
+    // already dropped (skip_nonref) do not stretch the stride.
+    const double interval = input.frame_interval_ms;
+    const double period = interval * options_.frame_stride;
+    if (next_due_ms_ >= 0.0 && pts_ms < next_due_ms_ - interval / 2.0) {
+        skipped_frames_.fetch_add(1);
+        return false;
+    }
+    next_due_ms_ = next_due_ms_ >= 0.0 && pts_ms < next_due_ms_ + period ? next_due_ms_ + period : pts_ms + period;
+    return true;
+}
+
+bool FfmpegRtspSource::convertFrame(Input& input, core::Frame& frame, double pts_ms) {
+    const AVFrame* av_frame = input.av_frame;
+    const int src_width = av_frame->width;
+    const int src_height = av_frame->height;
+    if (src_width <= 0 || src_height <= 0) {
+        return false;
+    }
+    const auto size = core::targetFrameSize(src_width, src_height, options_.target_width, options_.target_height,
+                                            options_.fit);
+    const int width = size.width;
+    const int height = size.height;
+    // With FrameFit::Pad the picture covers only part of the frame.
+    const auto rect = core::pictureRect(src_width, src_height, options_.target_width, options_.target_height,
+                                        options_.fit);
+    const bool scaled = rect.width != src_width || rect.height != src_height;
+    uint8_t* dst = frame.pixels.prepare(core::frameBytes(options_.output, width, height));
+    if (!dst) {
+        return false;
+    }
+
+    const auto src_format = static_cast<AVPixelFormat>(av_frame->format);
+    const bool i420 = options_.output == core::PixelFormat::I420;
+    uint8_t* dst_data[4] = {dst + (static_cast<size_t>(rect.y) * width + rect.x) * 3, nullptr, nullptr, nullptr};
+    int dst_linesize[4] = {width * 3, 0, 0, 0};
+    if (i420) {
+        const auto planes = core::i420Planes(dst, width, height);
+        dst_data[0] = planes.y + static_cast<size_t>(rect.y) * planes.y_stride + rect.x;
+        dst_data[1] = planes.u + static_cast<size_t>(rect.y / 2) * planes.u_stride + rect.x / 2;
+        dst_data[2] = planes.v + static_cast<size_t>(rect.y / 2) * planes.v_stride + rect.x / 2;
+        dst_linesize[0] = static_cast<int>(planes.y_stride);
+        dst_linesize[1] = static_cast<int>(planes.u_stride);
+        dst_linesize[2] = static_cast<int>(planes.v_stride);
+    }
+    if (i420 && src_format == AV_PIX_FMT_YUV420P && !scaled) {
+        // Already the layout we hand out: copy the planes, no conversion.
+        av_image_copy_plane(dst_data[0], dst_linesize[0], av_frame->data[0], av_frame->linesize[0],
+                            rect.width, rect.height);
+        av_image_copy_plane(dst_data[1], dst_linesize[1], av_frame->data[1], av_frame->linesize[1],
+                            (rect.width + 1) / 2, (rect.height + 1) / 2);
+        av_image_copy_plane(dst_data[2], dst_linesize[2], av_frame->data[2], av_frame->linesize[2],
+                            (rect.width + 1) / 2, (rect.height + 1) / 2);
+    } else {
+        // Scaling and colour conversion share one pass.
+        input.sws_ctx = sws_getCachedContext(input.sws_ctx, src_width, src_height, src_format, rect.width,
+                                             rect.height, i420 ? AV_PIX_FMT_YUV420P : AV_PIX_FMT_BGR24,
+                                             scaled && rect.width < src_width ? SWS_AREA : SWS_BILINEAR,
+                                             nullptr, nullptr, nullptr);
+        if (!input.sws_ctx) {
+            VA_LOG_ERROR() << "[RTSP] no conversion from pixel format " << av_frame->format;
+            return false;
+        }
+        sws_scale(input.sws_ctx, av_frame->data, av_frame->linesize, 0, src_height, dst_data, dst_linesize);
+    }
+    core::fillOutside(dst, options_.output, width, height, rect);
+
+    frame.width = width;
+    frame.height = height;
+    frame.format = options_.output;
+    frame.capture_ms = core::ms_now();
+    frame.pts_ms = pts_ms;
+    return true;
+}
+
+double FfmpegRtspSource::framePtsMs(Input& input) {
+    int64_t ts = input.av_frame->best_effort_timestamp;
+    if (ts == AV_NOPTS_VALUE) {
+        ts = input.av_frame->pts;
+    }
+    if (ts == AV_NOPTS_VALUE) {
+        // Raw streams without timestamps advance by the nominal interval.
+        decoded_pts_ms_ = decoded_pts_ms_ >= input.pts_offset_ms ? decoded_pts_ms_ + input.frame_interval_ms
+                                                                 : input.pts_offset_ms;
+        return decoded_pts_ms_;
+    }
+    if (!input.have_first_pts) {
+        input.first_pts = ts;
+        input.have_first_pts = true;
+    }
+    decoded_pts_ms_ = input.pts_offset_ms + static_cast<double>(ts - input.first_pts) * av_q2d(input.time_base) * 1000.0;
+    return decoded_pts_ms_;
+}
+
+#endif
+
+} // namespace va::media
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "media/frame_ring.hpp"
+#include "media/source_health.hpp"
+#include "media/source.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+namespace va::media {
+
+// RTSP (or any libavformat input) demuxed and decoded directly with
+// libavformat/libavcodec, so transport, timeouts and decoder threading are
+// under our control and frames keep their stream timestamps. switchUri()
+// returns at once; a prefetch thread opens the new input while the old one
+// keeps delivering and the capture thread swaps at its first keyframe, so a
+// switch costs about one frame interval instead of a reconnect. A URI that
+// cannot be played leaves the old input running and shows up in stats().
+class FfmpegRtspSource : public ISwitchableSource {
+public:
+    struct Options {
+        size_t buffer_depth {2};
+        BufferPolicy buffer_policy {BufferPolicy::KeepLatest};
+        bool prefer_tcp {true};
+        int timeout_ms {5000};         // open / read deadline before the input is reopened
+        bool low_delay {true};         // no demuxer buffering, decoder outputs as early as it can
+        int threads {0};               // decoder threads, 0 lets libavcodec decide
+        std::string thread_type {"frame"}; // frame | slice
+        core::PixelFormat output {core::PixelFormat::Bgr24};
+        // Delivered size, 0 = native (see core::targetFrameSize()).
+        int target_width {0};
+        int target_height {0};
+        core::FrameFit fit {core::FrameFit::Fit};
+        int frame_stride {1};          // deliver every Nth frame of the stream
+        bool skip_nonref {false};      // decoder drops non-reference frames when frame_stride > 1
+        ReconnectOptions reconnect;
+    };
+
+    explicit FfmpegRtspSource(std::string uri);
+    FfmpegRtspSource(std::string uri, Options options);
+    ~FfmpegRtspSource() override;
+
+    bool start() override;
+    void stop() override;
+    bool read(core::Frame& frame) override;
+    bool readFor(core::Frame& frame, std::chrono::milliseconds timeout) override;
+    void interruptReads() override;
+    SourceStats stats() const override;
+    bool switchUri(const std::string& uri) override;
+
+private:
+    // One opened input: demuxer, decoder, converter and its stream clock.
+    // Defined in the .cpp so the libav types stay out of this header.
+    struct Input;
+
+    static int interruptCallback(void* opaque);
+    void captureLoop();
+    void prefetchLoop();
+    void recordQueued(const core::Frame& frame);
+    // On failure `error` says why; callers log it according to the backoff.
+    // A prefetch passes the switch_seq_ it serves and is interrupted once
+    // that changes.
+    std::unique_ptr<Input> openInput(const std::string& uri, std::optional<uint64_t> switch_seq,
+                                     std::string& error);
+    bool primeInput(Input& input, std::string& error);
+    void adoptInput(std::unique_ptr<Input> input);
+    int receiveFrame(Input& input);
+    bool decodeFrame(Input& input, core::Frame& frame);
+    bool convertFrame(Input& input, core::Frame& frame, double pts_ms);
+    double framePtsMs(Input& input);
+    bool dueForDelivery(const Input& input, double pts_ms);
+    void armDeadline(Input& input) const;
+    void waitForRetry(std::chrono::milliseconds delay);
+    void waitForSwitch();
+    void inputFailed(const std::string& uri, const std::string& what);
+    void paceTo(const Input& input, double pts_ms);
+
+    Options options_;
+    FrameRing ring_;
+
+    std::string uri_;
+    mutable std::mutex mutex_;
+    std::condition_variable wake_cv_;
+    std::atomic<bool> running_ {false};
+    std::thread capture_thread_;
+
+    // prefetch_thread_ opens and primes pending_uri_ while input_ keeps
+    // delivering; the capture thread swaps to prefetched_, which holds a
+    // decoded keyframe. Every switchUri() bumps switch_seq_, which
+    // interrupts an open of a URI that has been superseded.
+    std::thread prefetch_thread_;           // guarded by mutex_
+    bool prefetching_ {false};              // guarded by mutex_
+    std::atomic<uint64_t> switch_seq_ {0};
+    std::string pending_uri_;               // guarded by mutex_
+    std::unique_ptr<Input> prefetched_;     // guarded by mutex_
+
+    // Only touched by the capture thread while it is running.
+    std::unique_ptr<Input> input_;
+    bool input_delivered_ {false};   // input_ produced a frame
+    double decoded_pts_ms_ {-1.0};   // newest decoded frame, delivered or not
+    double next_due_ms_ {-1.0};
+
+    // Guarded by mutex_.
+    SourceHealth health_;
+    double last_pts_ms_ {-1.0};      // newest delivered frame
+    double last_delivered_ms_ {-1.0};
+    double switch_from_ms_ {-1.0};   // last delivery before a swap, -1 when none is in flight
+    bool switched_ {false};
+    uint64_t switches_ {0};
+    uint64_t failed_switches_ {0};
+    double last_switch_gap_ms_ {0.0};
+    std::string last_switch_error_;
+
+    uint64_t frame_counter_ {0};
+    std::atomic<uint64_t> skipped_frames_ {0};
+    std::chrono::steady_clock::time_point started_at_;
+    std::chrono::steady_clock::time_point last_frame_time_;
+    double avg_latency_ms_ {0.0};
+};
+
+} // namespace va::media
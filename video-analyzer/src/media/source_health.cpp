@@ -0,0 +1,87 @@
+#include "media/source_health.hpp"
+
+#include "media/source.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace va::media {
+
+const char* sourceStateName(SourceState state) {
+    switch (state) {
+        case SourceState::Connecting: return "connecting";
+        case SourceState::Streaming: return "streaming";
+        case SourceState::Stalled: return "stalled";
+        case SourceState::Backoff: return "backoff";
+        case SourceState::Failed: return "failed";
+    }
+    return "connecting";
+}
+
+SourceHealth::SourceHealth(ReconnectOptions options)
+    : options_(options) {}
+
+void SourceHealth::reset() {
+    state_ = SourceState::Connecting;
+    streamed_ = false;
+    failures_ = 0;
+}
+
+void SourceHealth::connecting() {
+    if (streamed_) {
+        ++reconnects_;
+    }
+    streamed_ = false;
+    state_ = SourceState::Connecting;
+}
+
+void SourceHealth::frameDelivered() {
+    state_ = SourceState::Streaming;
+    streamed_ = true;
+    have_frame_ = true;
+    failures_ = 0;
+    last_frame_ = Clock::now();
+}
+
+std::optional<std::chrono::milliseconds> SourceHealth::failed() {
+    ++failures_;
+    if (options_.max_attempts > 0 && failures_ >= static_cast<uint32_t>(options_.max_attempts)) {
+        state_ = SourceState::Failed;
+        return std::nullopt;
+    }
+    const double initial = std::max(1, options_.initial_ms);
+    const double cap = std::max(initial, static_cast<double>(options_.max_ms));
+    const double base = std::min(cap, initial * std::pow(2.0, std::min<uint32_t>(failures_ - 1, 30)));
+    const double jitter = std::clamp(options_.jitter, 0.0, 1.0);
+    static thread_local std::mt19937 rng(std::random_device{}());
+    std::uniform_real_distribution<double> spread(1.0 - jitter, 1.0 + jitter);
+    const auto delay = std::chrono::milliseconds(static_cast<int64_t>(base * spread(rng)));
+    state_ = SourceState::Backoff;
+    retry_at_ = Clock::now() + delay;
+    return delay;
+}
+
+SourceState SourceHealth::state() const {
+    if (state_ == SourceState::Streaming && options_.stall_timeout_ms > 0
+        && Clock::now() - last_frame_ > std::chrono::milliseconds(options_.stall_timeout_ms)) {
+        return SourceState::Stalled;
+    }
+    return state_;
+}
+
+void SourceHealth::fillStats(SourceStats& stats) const {
+    const auto now = Clock::now();
+    const SourceState current = state();
+    stats.state = sourceStateName(current);
+    stats.consecutive_failures = failures_;
+    stats.reconnects = reconnects_;
+    if (have_frame_) {
+        stats.last_frame_age_ms = std::chrono::duration<double, std::milli>(now - last_frame_).count();
+    }
+    if (current == SourceState::Backoff && retry_at_ > now) {
+        stats.retry_in_ms = std::chrono::duration<double, std::milli>(retry_at_ - now).count();
+    }
+}
+
+} // namespace va::media
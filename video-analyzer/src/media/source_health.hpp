@@ -0,0 +1,65 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+namespace va::media {
+
+struct SourceStats;
+
+enum class SourceState {
+    Connecting, // opening the input
+    Streaming,  // frames are arriving
+    Stalled,    // input open, but no frame for stall_timeout_ms
+    Backoff,    // waiting before the next open attempt
+    Failed      // max_attempts exhausted; idle until the URI is switched
+};
+
+const char* sourceStateName(SourceState state);
+
+struct ReconnectOptions {
+    int initial_ms {500};     // delay after the first failed attempt
+    int max_ms {30000};       // cap of the doubling delay
+    double jitter {0.2};      // each delay is scaled by a random factor in [1 - jitter, 1 + jitter]
+    int max_attempts {0};     // consecutive failures before giving up, 0 = never
+    int stall_timeout_ms {3000};
+};
+
+// Connection state of one source, driven by its capture thread. Failed opens
+// back off exponentially with jitter, so a dead camera costs one attempt per
+// max_ms and many sources that lost the same server do not retry in step.
+// Not thread-safe; sources call it under their own lock.
+class SourceHealth {
+public:
+    explicit SourceHealth(ReconnectOptions options = {});
+
+    // Back to Connecting with no failures, for start() and a switched URI.
+    void reset();
+    // An open attempt is about to start; after a lost input this counts as a
+    // reconnect.
+    void connecting();
+    void frameDelivered();
+    // A failed open or a lost input. Returns the wait before the next attempt,
+    // or nothing once max_attempts is exhausted (Failed).
+    std::optional<std::chrono::milliseconds> failed();
+
+    // Streaming turns into Stalled once the last frame is stall_timeout_ms old.
+    SourceState state() const;
+    uint32_t failures() const { return failures_; }
+    void fillStats(SourceStats& stats) const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    ReconnectOptions options_;
+    SourceState state_ {SourceState::Connecting};
+    bool streamed_ {false};     // delivered a frame since the last connect
+    bool have_frame_ {false};   // delivered any frame at all
+    uint32_t failures_ {0};     // consecutive
+    uint64_t reconnects_ {0};
+    Clock::time_point last_frame_;
+    Clock::time_point retry_at_;
+};
+
+} // namespace va::media
@@ -2,75 +2,118 @@
 
 #include <opencv2/imgproc.hpp>
 
+#include <vector>
+
+#include "core/color_convert.hpp"
 #include "core/logger.hpp"
 
 namespace va::media {
 
+namespace {
+bool openVideoCapture(cv::VideoCapture& capture, const std::string& uri, int timeout_ms) {
+    std::vector<int> params;
+    if (timeout_ms > 0) {
+        // Without these a dead camera blocks open()/read() for about 30 s.
+        params = {cv::CAP_PROP_OPEN_TIMEOUT_MSEC, timeout_ms, cv::CAP_PROP_READ_TIMEOUT_MSEC, timeout_ms};
+    }
+    return capture.open(uri, cv::CAP_FFMPEG, params) && capture.isOpened();
+}
+}
+
 SwitchableRtspSource::SwitchableRtspSource(std::string uri)
-    : uri_(std::move(uri)) {}
+    : SwitchableRtspSource(std::move(uri), Options{}) {}
+
+SwitchableRtspSource::SwitchableRtspSource(std::string uri, Options options)
+    : options_(options),
+      ring_(options.buffer_depth, options.buffer_policy),
+      uri_(std::move(uri)),
+      health_(options.reconnect) {}
+
+SwitchableRtspSource::~SwitchableRtspSource() {
+    stop();
+}
 
 bool SwitchableRtspSource::start() {
     std::lock_guard<std::mutex> lock(mutex_);
-    if (running_) {
+    if (running_.load()) {
         return true;
     }
-    if (!openCapture()) {
-        VA_LOG_WARN() << "[RTSP] initial capture open failed for URI " << uri_ << ", will retry lazily";
-    }
-    running_ = true;
+    ring_.clear();
+    ring_.open();
+    health_.reset();
     frame_counter_ = 0;
+    skipped_frames_ = 0;
     avg_latency_ms_ = 0.0;
+    last_delivered_ms_ = -1.0;
+    switched_ = false;
     started_at_ = std::chrono::steady_clock::now();
     last_frame_time_ = started_at_;
+    running_.store(true);
+    capture_thread_ = std::thread(&SwitchableRtspSource::captureLoop, this);
     return true;
 }
 
 void SwitchableRtspSource::stop() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (!running_) {
-        return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_.exchange(false)) {
+            return;
+        }
+    }
+    wake_cv_.notify_all();
+    ring_.close();
+    if (capture_thread_.joinable()) {
+        capture_thread_.join();
+    }
+    // switchUri() no longer starts a prefetch once running_ is false. A
+    // capture still opening finishes first; VideoCapture cannot be
+    // interrupted, so this waits up to the open timeout.
+    if (prefetch_thread_.joinable()) {
+        prefetch_thread_.join();
     }
-    running_ = false;
     closeCapture();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        prefetched_.reset();
+        pending_uri_.clear();
+    }
+    ring_.clear();
 }
 
 bool SwitchableRtspSource::read(core::Frame& frame) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (!running_) {
+    if (!running_.load() || !ring_.tryPop(frame)) {
         return false;
     }
-    if (!capture_.isOpened()) {
-        if (!openCapture()) {
-            VA_LOG_WARN() << "[RTSP] reopen failed for URI " << uri_;
-            return false;
-        }
-    }
+    recordQueued(frame);
+    return true;
+}
 
-    cv::Mat mat;
-    if (!capture_.read(mat) || mat.empty()) {
-        VA_LOG_WARN() << "[RTSP] failed to read frame for URI " << uri_;
+bool SwitchableRtspSource::readFor(core::Frame& frame, std::chrono::milliseconds timeout) {
+    // Before start() the ring is open and empty, so this still waits out
+    // the timeout rather than returning at once.
+    if (!ring_.popFor(frame, timeout)) {
         return false;
     }
+    recordQueued(frame);
+    return true;
+}
 
-    frame_counter_++;
-    last_frame_time_ = std::chrono::steady_clock::now();
-
-    avg_latency_ms_ = 0.0;
-
-    frame.width = mat.cols;
-    frame.height = mat.rows;
-    frame.pts_ms = core::ms_now();
-    if (!mat.isContinuous()) {
-        mat = mat.clone();
-    }
-    frame.bgr.assign(mat.datastart, mat.dataend);
+void SwitchableRtspSource::interruptReads() {
+    ring_.close();
+}
 
-    return true;
+void SwitchableRtspSource::recordQueued(const core::Frame& frame) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const double queued_ms = core::ms_now() - frame.capture_ms;
+    avg_latency_ms_ = avg_latency_ms_ == 0.0 ? queued_ms : avg_latency_ms_ + (queued_ms - avg_latency_ms_) / 10.0;
 }
 
 SourceStats SwitchableRtspSource::stats() const {
     std::lock_guard<std::mutex> lock(mutex_);
     SourceStats stats;
+    health_.fillStats(stats);
+    stats.decoder = "opencv";
+    stats.pixel_format = core::pixelFormatName(core::PixelFormat::Bgr24);
     const auto now = std::chrono::steady_clock::now();
     const double elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - started_at_).count();
     if (elapsed > 0.0) {
@@ -78,24 +121,244 @@ SourceStats SwitchableRtspSource::stats() const {
     }
     stats.avg_latency_ms = avg_latency_ms_;
     stats.last_frame_id = frame_counter_;
+    stats.last_pts_ms = last_pts_ms_;
+    stats.skipped_frames = skipped_frames_;
+    stats.buffer_policy = bufferPolicyName(ring_.policy());
+    stats.buffer_capacity = ring_.capacity();
+    stats.buffered_frames = ring_.size();
+    stats.dropped_frames = ring_.droppedFrames();
+    stats.blocked_pushes = ring_.blockedPushes();
+    stats.switches = switches_;
+    stats.last_switch_gap_ms = last_switch_gap_ms_;
+    stats.switch_pending = !pending_uri_.empty();
+    stats.failed_switches = failed_switches_;
+    stats.last_switch_error = last_switch_error_;
     return stats;
 }
 
 bool SwitchableRtspSource::switchUri(const std::string& uri) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    uri_ = uri;
-    closeCapture();
-    if (running_) {
-        return openCapture();
+    std::unique_ptr<Prefetched> superseded;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_.load()) {
+            uri_ = uri; // opened by the next start()
+            return true;
+        }
+        // A newer switch wins: a capture opened for the previous one is
+        // dropped, and one still opening is discarded once it returns.
+        superseded = std::move(prefetched_);
+        pending_uri_ = uri;
+        ++switch_seq_;
+        if (!prefetching_) {
+            if (prefetch_thread_.joinable()) {
+                // Done with its last URI; it returns right after clearing prefetching_.
+                prefetch_thread_.join();
+            }
+            prefetching_ = true;
+            prefetch_thread_ = std::thread(&SwitchableRtspSource::prefetchLoop, this);
+        }
+    }
+    wake_cv_.notify_all(); // a failed source waits for exactly this
+    return true;
+}
+
+void SwitchableRtspSource::prefetchLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    // One attempt per switch; a switch that arrives meanwhile is served next.
+    while (running_.load() && !pending_uri_.empty() && !prefetched_) {
+        const std::string uri = pending_uri_;
+        const uint64_t seq = switch_seq_;
+        lock.unlock();
+
+        // The new capture is opened here while the capture thread keeps
+        // delivering the old one. The first decoded frame doubles as proof the
+        // stream is playable.
+        auto next = std::make_unique<Prefetched>();
+        next->uri = uri;
+        const bool opened = openVideoCapture(next->capture, uri, options_.timeout_ms)
+                            && next->capture.read(next->first) && !next->first.empty();
+        if (!opened || !running_.load()) {
+            next.reset();
+        }
+
+        lock.lock();
+        if (!running_.load() || seq != switch_seq_) {
+            // Superseded; released outside mutex_ like any capture.
+            lock.unlock();
+            next.reset();
+            lock.lock();
+            continue;
+        }
+        if (opened) {
+            // Frames of the old URI, queued or being read right now, are dropped.
+            ring_.beginGeneration();
+            prefetched_ = std::move(next);
+            last_switch_error_.clear();
+        } else {
+            pending_uri_.clear();
+            ++failed_switches_;
+            last_switch_error_ = "cv::VideoCapture open failed";
+            VA_LOG_WARN() << "[RTSP] switch to URI " << uri << " failed: cv::VideoCapture open failed, keeping "
+                          << uri_;
+        }
+        wake_cv_.notify_all();
+    }
+    prefetching_ = false;
+}
+
+void SwitchableRtspSource::captureLoop() {
+    while (running_.load()) {
+        std::unique_ptr<Prefetched> next;
+        bool switching = false;
+        std::string uri;
+        uint64_t generation = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            next = std::move(prefetched_);
+            // Read together with prefetched_: a frame read from the old
+            // capture after a switch no longer matches and is dropped.
+            generation = ring_.generation();
+            if (next) {
+                uri_ = next->uri;
+                pending_uri_.clear();
+                switch_from_ms_ = last_delivered_ms_;
+                switched_ = true;
+                health_.reset();
+            }
+            switching = !pending_uri_.empty();
+            uri = uri_;
+        }
+
+        if (next) {
+            capture_ = std::move(next->capture);
+            primed_ = std::move(next->first);
+            stride_phase_ = 0;
+            capture_delivered_ = false;
+        }
+
+        if (!capture_.isOpened()) {
+            bool failed = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                failed = health_.state() == SourceState::Failed;
+                if (!switching && !failed) {
+                    health_.connecting();
+                }
+            }
+            if (switching || failed) {
+                // Reopening the old URI is pointless; wait for a new one.
+                waitForSwitch();
+                continue;
+            }
+            if (!openCapture(uri)) {
+                captureFailed(uri, "cv::VideoCapture open failed");
+                continue;
+            }
+            capture_delivered_ = false;
+        }
+
+        if (options_.frame_stride > 1 && (stride_phase_++ % static_cast<uint64_t>(options_.frame_stride)) != 0) {
+            // grab() demuxes and decodes but skips the BGR conversion.
+            if (!capture_.grab()) {
+                closeCapture();
+                captureFailed(uri, "failed to read frame");
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++skipped_frames_;
+            continue;
+        }
+
+        core::Frame frame;
+        if (!readFrame(frame)) {
+            closeCapture();
+            captureFailed(uri, "failed to read frame");
+            continue;
+        }
+        capture_delivered_ = true;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (switched_) {
+                switched_ = false;
+                ++switches_;
+                if (switch_from_ms_ >= 0.0) {
+                    last_switch_gap_ms_ = frame.capture_ms - switch_from_ms_;
+                    VA_LOG_INFO() << "[RTSP] switched to " << uri_ << ", gap " << last_switch_gap_ms_ << " ms";
+                }
+            }
+            health_.frameDelivered();
+            frame_counter_++;
+            last_frame_time_ = std::chrono::steady_clock::now();
+            last_pts_ms_ = frame.pts_ms;
+            last_delivered_ms_ = frame.capture_ms;
+        }
+
+        ring_.push(std::move(frame), generation);
+    }
+}
+
+bool SwitchableRtspSource::readFrame(core::Frame& frame) {
+    // VideoCapture hides the stream clock; the capture time stands in.
+    const bool scale = options_.target_width > 0 && options_.target_height > 0;
+    if (scale || !primed_.empty()) {
+        if (!primed_.empty()) {
+            decoded_ = primed_;
+            primed_.release();
+        } else if (!capture_.read(decoded_) || decoded_.empty()) {
+            return false;
+        }
+        const auto size = core::targetFrameSize(decoded_.cols, decoded_.rows, options_.target_width,
+                                                options_.target_height, options_.fit);
+        const auto rect = core::pictureRect(decoded_.cols, decoded_.rows, options_.target_width,
+                                            options_.target_height, options_.fit);
+        uint8_t* dst = frame.pixels.prepare(core::frameBytes(core::PixelFormat::Bgr24, size.width, size.height));
+        cv::Mat out(size.height, size.width, CV_8UC3, dst);
+        cv::Mat picture = out(cv::Rect(rect.x, rect.y, rect.width, rect.height));
+        if (rect.width == decoded_.cols && rect.height == decoded_.rows) {
+            decoded_.copyTo(picture);
+        } else {
+            cv::resize(decoded_, picture, picture.size(), 0.0, 0.0,
+                       rect.width < decoded_.cols ? cv::INTER_AREA : cv::INTER_LINEAR);
+        }
+        core::fillOutside(dst, core::PixelFormat::Bgr24, size.width, size.height, rect);
+        frame.width = size.width;
+        frame.height = size.height;
+        frame.capture_ms = core::ms_now();
+        frame.pts_ms = frame.capture_ms;
+        return true;
+    }
+
+    // Decode straight into a pooled buffer sized for the previous frame;
+    // OpenCV only reallocates (and we copy) when the resolution changes.
+    cv::Mat mat;
+    if (last_width_ > 0 && last_height_ > 0) {
+        uint8_t* dst = frame.pixels.prepare(static_cast<size_t>(last_width_) * last_height_ * 3);
+        mat = cv::Mat(last_height_, last_width_, CV_8UC3, dst);
+    }
+    if (!capture_.read(mat) || mat.empty()) {
+        return false;
+    }
+
+    frame.width = mat.cols;
+    frame.height = mat.rows;
+    frame.capture_ms = core::ms_now();
+    frame.pts_ms = frame.capture_ms;
+    if (mat.data != frame.pixels.data()) {
+        if (!mat.isContinuous()) {
+            mat = mat.clone();
+        }
+        frame.pixels.assign(mat.datastart, mat.dataend);
+        last_width_ = mat.cols;
+        last_height_ = mat.rows;
     }
     return true;
 }
 
-bool SwitchableRtspSource::openCapture() {
+bool SwitchableRtspSource::openCapture(const std::string& uri) {
     capture_.release();
-    cv::VideoCapture cap(uri_, cv::CAP_FFMPEG);
-    if (!cap.isOpened()) {
-        VA_LOG_ERROR() << "[RTSP] cv::VideoCapture open failed for URI " << uri_;
+    cv::VideoCapture cap;
+    if (!openVideoCapture(cap, uri, options_.timeout_ms)) {
         return false;
     }
     capture_ = std::move(cap);
@@ -103,9 +366,57 @@ bool SwitchableRtspSource::openCapture() {
 }
 
 void SwitchableRtspSource::closeCapture() {
+    primed_.release();
     if (capture_.isOpened()) {
         capture_.release();
     }
 }
 
+void SwitchableRtspSource::waitForRetry(std::chrono::milliseconds delay) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    wake_cv_.wait_for(lock, delay, [this]() { return !running_.load() || prefetched_ != nullptr; });
+}
+
+void SwitchableRtspSource::waitForSwitch() {
+    // No timeout: a failed source sleeps until a switch starts, and one
+    // waiting for a switch until its URI opens or fails.
+    std::unique_lock<std::mutex> lock(mutex_);
+    const bool pending = !pending_uri_.empty();
+    wake_cv_.wait(lock, [&]() {
+        return !running_.load() || prefetched_ != nullptr || pending_uri_.empty() == pending;
+    });
+}
+
+void SwitchableRtspSource::captureFailed(const std::string& uri, const char* what) {
+    if (!running_.load()) {
+        return;
+    }
+    if (capture_delivered_) {
+        // A stream that was playing is reopened straight away.
+        VA_LOG_WARN() << "[RTSP] " << what << " for URI " << uri << ", reconnecting";
+        capture_delivered_ = false;
+        return;
+    }
+    std::optional<std::chrono::milliseconds> delay;
+    uint32_t attempt = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        delay = health_.failed();
+        attempt = health_.failures();
+    }
+    if (!delay) {
+        VA_LOG_ERROR() << "[RTSP] " << what << " for URI " << uri << ", giving up after " << attempt
+                       << " attempts; switch the source to retry";
+        return;
+    }
+    // The first failure is a warning; repeats of a known outage only go to debug.
+    if (attempt == 1) {
+        VA_LOG_WARN() << "[RTSP] " << what << " for URI " << uri << ", retrying in " << delay->count() << " ms";
+    } else {
+        VA_LOG_DEBUG() << "[RTSP] " << what << " for URI " << uri << " (attempt " << attempt << "), retrying in "
+                       << delay->count() << " ms";
+    }
+    waitForRetry(*delay);
+}
+
 } // namespace va::media
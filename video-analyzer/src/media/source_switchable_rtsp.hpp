@@ -1,38 +1,109 @@
 #pragma once
 
+#include "media/frame_ring.hpp"
+#include "media/source_health.hpp"
 #include "media/source.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
 #include <mutex>
 #include <string>
-#include <chrono>
+#include <thread>
 
 #include <opencv2/videoio.hpp>
 
 namespace va::media {
 
+// cv::VideoCapture-backed source. switchUri() returns at once; a prefetch
+// thread opens the new URI and decodes its first frame while the capture
+// thread keeps delivering the old one, then hands the capture over. A URI
+// that cannot be played leaves the old one running and shows up in stats().
 class SwitchableRtspSource : public ISwitchableSource {
 public:
+    struct Options {
+        size_t buffer_depth {2};
+        BufferPolicy buffer_policy {BufferPolicy::KeepLatest};
+        // Delivered size, 0 = native (see core::targetFrameSize()).
+        int target_width {0};
+        int target_height {0};
+        core::FrameFit fit {core::FrameFit::Fit};
+        int frame_stride {1};  // deliver every Nth frame; the others are grabbed, not converted
+        int timeout_ms {5000}; // VideoCapture open / read timeout
+        ReconnectOptions reconnect;
+    };
+
     explicit SwitchableRtspSource(std::string uri);
+    SwitchableRtspSource(std::string uri, Options options);
+    ~SwitchableRtspSource() override;
 
     bool start() override;
     void stop() override;
     bool read(core::Frame& frame) override;
+    bool readFor(core::Frame& frame, std::chrono::milliseconds timeout) override;
+    void interruptReads() override;
     SourceStats stats() const override;
     bool switchUri(const std::string& uri) override;
 
 private:
-    bool openCapture();
+    // A capture opened by prefetchLoop(), with the first frame it read.
+    struct Prefetched {
+        std::string uri;
+        cv::VideoCapture capture;
+        cv::Mat first;
+    };
+
+    void captureLoop();
+    void prefetchLoop();
+    void recordQueued(const core::Frame& frame);
+    bool openCapture(const std::string& uri);
+    bool readFrame(core::Frame& frame);
     void closeCapture();
+    void waitForRetry(std::chrono::milliseconds delay);
+    void waitForSwitch();
+    void captureFailed(const std::string& uri, const char* what);
+
+    Options options_;
+    FrameRing ring_;
 
     std::string uri_;
     mutable std::mutex mutex_;
+    std::condition_variable wake_cv_;
+    std::atomic<bool> running_ {false};
+    std::thread capture_thread_;
+
+    // Guarded by mutex_. switch_seq_ counts switchUri() calls so the
+    // prefetch thread can tell that the URI it opened has been superseded.
+    std::thread prefetch_thread_;
+    bool prefetching_ {false};
+    uint64_t switch_seq_ {0};
+    std::string pending_uri_;           // switch in progress
+    std::unique_ptr<Prefetched> prefetched_;
+    SourceHealth health_;
+    double last_delivered_ms_ {-1.0};
+    double switch_from_ms_ {-1.0};
+    bool switched_ {false};
+    uint64_t switches_ {0};
+    uint64_t failed_switches_ {0};
+    double last_switch_gap_ms_ {0.0};
+    std::string last_switch_error_;
+
+    // Only touched by the capture thread while it is running.
     cv::VideoCapture capture_;
-    bool running_ {false};
+    cv::Mat primed_;   // first frame of a capture taken over from prefetchLoop()
+    bool capture_delivered_ {false};
+    int last_width_ {0};
+    int last_height_ {0};
+    cv::Mat decoded_;  // full-size picture when frames are scaled
+    uint64_t stride_phase_ {0};
 
     uint64_t frame_counter_ {0};
+    uint64_t skipped_frames_ {0};
     std::chrono::steady_clock::time_point started_at_;
     std::chrono::steady_clock::time_point last_frame_time_;
     double avg_latency_ms_ {0.0};
+    double last_pts_ms_ {0.0};
 };
 
 } // namespace va::media
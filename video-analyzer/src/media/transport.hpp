@@ -1,7 +1,12 @@
 #pragma once
 
+#include "media/packet_buffer.hpp"
+
 #include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <string>
+#include <vector>
 
 namespace va::media {
 
@@ -9,13 +14,85 @@ class ITransport {
 public:
     virtual ~ITransport() = default;
     virtual bool connect(const std::string& endpoint) = 0;
-    virtual bool send(const std::string& track_id, const uint8_t* data, size_t size) = 0;
+    // `keyframe` marks packets a subscriber can start decoding from; fan-out
+    // transports use it to resynchronise clients that fall behind. The packet
+    // is shared, not copied: transports keep a reference as long as they need
+    // it and may frame it in its headroom, but never modify the payload.
+    virtual bool send(const std::string& track_id, const PacketBuffer& packet, bool keyframe) = 0;
+    // Per-frame detection record for metadata consumers. Transports without a
+    // metadata channel drop it.
+    virtual bool sendMetadata(const std::string& /*track_id*/,
+                              const uint8_t* /*data*/,
+                              size_t /*size*/,
+                              bool /*keyframe*/) {
+        return false;
+    }
+    // WHEP-style egress: a viewer posts an SDP offer and gets the answer
+    // back; `session_id` names the session for closeSession(). Transports
+    // negotiated through their own signalling refuse.
+    virtual bool acceptOffer(const std::string& /*offer_sdp*/,
+                             std::string& /*answer_sdp*/,
+                             std::string& /*session_id*/) {
+        return false;
+    }
+    // Trickle ICE for such a session: `fragment` holds the viewer's candidates
+    // (an SDP fragment with a=candidate lines), `local_fragment` receives the
+    // ones gathered here since the last call, empty when there are none.
+    virtual bool updateSession(const std::string& /*session_id*/,
+                               const std::string& /*fragment*/,
+                               std::string& /*local_fragment*/) {
+        return false;
+    }
+    virtual bool closeSession(const std::string& /*session_id*/) {
+        return false;
+    }
+    // What subscribers ask of the encoder feeding this transport. Both are
+    // invoked from network or sender threads.
+    struct EncoderFeedback {
+        // A subscriber joined or lost the picture (RTCP PLI/FIR).
+        std::function<void()> request_keyframe;
+        // Share of the configured rate, in (0, 1], the subscribers currently
+        // keep up with; derived from queue depth or RTCP loss.
+        std::function<void(double)> rate_scale;
+    };
+    virtual void setEncoderFeedback(EncoderFeedback /*feedback*/) {}
     virtual void disconnect() = 0;
 
+    // One connected fan-out subscriber.
+    struct ClientStats {
+        std::string client_id;
+        std::string source_id;
+        uint64_t packets {0};
+        uint64_t skipped_packets {0};
+        // Time packets waited between the encoder push and the hand-off to
+        // the client's channel (moving average), plus what that channel still
+        // has queued for the network.
+        double queue_delay_ms {0.0};
+        uint64_t buffered_bytes {0};
+        // From RTCP receiver reports; zero on transports without RTCP.
+        double rtt_ms {0.0};
+        double fraction_lost {0.0};
+        int64_t packets_lost {0};
+        double jitter_ms {0.0};
+    };
+
     struct Stats {
         bool connected {false};
         uint64_t packets {0};
         uint64_t bytes {0};
+        uint64_t metadata_packets {0};
+        uint64_t metadata_bytes {0};
+        uint64_t subscribers {0};
+        // Packets fan-out subscribers skipped to catch up with a newer keyframe.
+        uint64_t skipped_packets {0};
+        // Payload bytes the transport had to copy on the way to the wire
+        // (0 on the zero-copy path).
+        uint64_t bytes_copied {0};
+        double bytes_copied_per_sec {0.0};
+        uint64_t keyframe_requests {0};
+        // Last value passed to EncoderFeedback::rate_scale.
+        double rate_scale {1.0};
+        std::vector<ClientStats> clients;
     };
 
     virtual Stats stats() const = 0;
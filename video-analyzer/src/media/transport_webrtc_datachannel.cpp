@@ -1,6 +1,8 @@
 #include "media/transport_webrtc_datachannel.hpp"
 
 #include "core/logger.hpp"
+#include "media/broadcast_ring.hpp"
+#include "media/rate_control.hpp"
 
 #include <ixwebsocket/IXWebSocketServer.h>
 #include <json/json.h>
@@ -10,6 +12,7 @@
 #include <atomic>
 #include <chrono>
 #include <cctype>
+#include <condition_variable>
 #include <cstddef>
 #include <cstring>
 #include <functional>
@@ -34,6 +37,20 @@ constexpr uint16_t kDefaultSignalingPort = 8083;
 constexpr uint16_t kDefaultStreamerPort = 8080;
 constexpr char kDefaultEndpoint[] = "ws://127.0.0.1:8083";
 
+// Per-client pacing. A client whose channel holds more than the high
+// watermark gets no new frames until it drains below the low watermark;
+// meanwhile its ring cursor falls behind and is moved to a newer keyframe.
+constexpr size_t kSendHighWatermark = 1024 * 1024;
+constexpr size_t kSendLowWatermark = 256 * 1024;
+// Upper bound on how long the sender sleeps without a wake-up, so state that
+// changes without one (a channel closing) is still noticed.
+constexpr auto kSenderIdleWait = std::chrono::milliseconds(200);
+// Rate adaptation: once per interval the slowest client decides whether the
+// encoder backs off (skips, a full channel or a long queue delay), holds, or
+// recovers (every channel below the low watermark).
+constexpr auto kRateInterval = std::chrono::seconds(1);
+constexpr double kCongestedDelayMs = 250.0;
+
 uint16_t parsePort(const std::string& endpoint) {
     auto pos = endpoint.rfind(':');
     if (pos == std::string::npos) {
@@ -280,56 +297,16 @@ private:
     std::function<void(const std::string&, const Json::Value&)> message_callback_;
 };
 
-class WebRTCVideoSource {
-public:
-    WebRTCVideoSource() = default;
-
-    void PushEncodedFrame(const std::string& source_id, std::vector<uint8_t>&& data) {
-        if (data.empty()) {
-            return;
-        }
-        std::scoped_lock lock(mutex_);
-        auto& queue = frames_[source_id];
-        queue.push(std::move(data));
-        while (queue.size() > 10) {
-            queue.pop();
-        }
-    }
-
-    bool HasEncodedFrame(const std::string& source_id) const {
-        std::scoped_lock lock(mutex_);
-        auto it = frames_.find(source_id);
-        return it != frames_.end() && !it->second.empty();
-    }
-
-    std::vector<uint8_t> GetEncodedFrame(const std::string& source_id) {
-        std::scoped_lock lock(mutex_);
-        auto it = frames_.find(source_id);
-        if (it == frames_.end() || it->second.empty()) {
-            return {};
-        }
-        std::vector<uint8_t> data = std::move(it->second.front());
-        it->second.pop();
-        return data;
-    }
-
-private:
-    mutable std::mutex mutex_;
-    std::map<std::string, std::queue<std::vector<uint8_t>>> frames_;
-};
-
 class WebRTCStreamer {
 public:
     WebRTCStreamer()
-        : initialized_(false), port_(0), should_stop_sender_(false) {
-        video_source_ = std::make_unique<WebRTCVideoSource>();
-    }
+        : initialized_(false), port_(0), should_stop_sender_(false) {}
 
     ~WebRTCStreamer() {
         Shutdown();
     }
 
-    bool Initialize(int port) {
+    bool Initialize(int port, const WebRTCDataChannelTransport::Options& options) {
         if (initialized_) {
             return true;
         }
@@ -337,8 +314,8 @@ public:
             port_ = port;
             rtc_config_.enableIceTcp = false;
             rtc_config_.disableAutoNegotiation = false;
-            rtc_config_.portRangeBegin = 10000;
-            rtc_config_.portRangeEnd = 10100;
+            rtc_config_.portRangeBegin = options.ice_port_min;
+            rtc_config_.portRangeEnd = options.ice_port_max;
             rtc_config_.bindAddress = "127.0.0.1";
 
             should_stop_sender_ = false;
@@ -358,6 +335,7 @@ public:
             return;
         }
         should_stop_sender_ = true;
+        Wake();
         if (video_sender_thread_.joinable()) {
             video_sender_thread_.join();
         }
@@ -385,14 +363,28 @@ public:
             client->requested_source = "camera_01";
             client->data_channel = peer_connection->createDataChannel("video");
 
-            client->data_channel->onOpen([client_id]() {
+            client->data_channel->onOpen([this, client_id]() {
                 VA_LOG_INFO() << "Data channel opened for client " << client_id;
+                // The newest keyframe may already be waiting in the ring.
+                Wake();
+            });
+            client->data_channel->setBufferedAmountLowThreshold(kSendLowWatermark);
+            client->data_channel->onBufferedAmountLow([this]() {
+                Wake();
             });
 
             client->data_channel->onClosed([client_id]() {
                 VA_LOG_INFO() << "Data channel closed for client " << client_id;
             });
 
+            // Detection records travel on their own channel so metadata-only
+            // consumers never have to parse the video framing.
+            client->meta_channel = peer_connection->createDataChannel("meta");
+            client->meta_channel->setBufferedAmountLowThreshold(kSendLowWatermark);
+            client->meta_channel->onBufferedAmountLow([this]() {
+                Wake();
+            });
+
             {
                 std::scoped_lock lock(clients_mutex_);
                 clients_[client_id] = std::move(client);
@@ -440,8 +432,41 @@ public:
         }
     }
 
-    void PushEncodedFrame(const std::string& source_id, std::vector<uint8_t>&& data) {
-        video_source_->PushEncodedFrame(source_id, std::move(data));
+    void PushEncodedFrame(const std::string& source_id, PacketBuffer packet, bool keyframe) {
+        ringFor(video_rings_, source_id)->push(std::move(packet), keyframe);
+        Wake();
+    }
+
+    void PushMetadata(const std::string& source_id, PacketBuffer packet, bool keyframe) {
+        ringFor(meta_rings_, source_id)->push(std::move(packet), keyframe);
+        Wake();
+    }
+
+    size_t ConnectedClients() const {
+        std::scoped_lock lock(clients_mutex_);
+        return static_cast<size_t>(std::count_if(clients_.begin(), clients_.end(), [](const auto& entry) {
+            return entry.second->connected;
+        }));
+    }
+
+    std::vector<ITransport::ClientStats> ClientStats() const {
+        std::vector<ITransport::ClientStats> result;
+        std::scoped_lock lock(clients_mutex_);
+        for (const auto& [client_id, client] : clients_) {
+            if (client->connected) {
+                result.push_back(client->stats);
+            }
+        }
+        return result;
+    }
+
+    uint64_t SkippedPackets() const {
+        std::scoped_lock lock(rings_mutex_);
+        uint64_t total = 0;
+        for (const auto& [source_id, ring] : video_rings_) {
+            total += ring->skippedPackets();
+        }
+        return total;
     }
 
     void SetClientSource(const std::string& client_id, const std::string& source_id) {
@@ -450,6 +475,7 @@ public:
         if (it != clients_.end()) {
             it->second->requested_source = source_id;
         }
+        Wake();
     }
 
     void SetOnClientConnected(std::function<void(const std::string&)> callback) {
@@ -464,15 +490,40 @@ public:
         on_signaling_message_ = std::move(callback);
     }
 
+    // Called from the sender thread with the new RateController scale.
+    void SetOnRateScale(std::function<void(double)> callback) {
+        on_rate_scale_ = std::move(callback);
+    }
+
 private:
     struct ClientConnection {
         std::string client_id;
         std::string requested_source;
         std::shared_ptr<rtc::PeerConnection> peer_connection;
         std::shared_ptr<rtc::DataChannel> data_channel;
+        std::shared_ptr<rtc::DataChannel> meta_channel;
         bool connected;
+        // Touched by the sender thread only; reset when it sees the client
+        // switch to another source.
+        std::string cursor_source;
+        BroadcastRing::Cursor video_cursor;
+        BroadcastRing::Cursor meta_cursor;
+        uint64_t skipped_at_rate_check {0};
+        // Published by the sender thread under clients_mutex_.
+        ITransport::ClientStats stats;
     };
 
+    using RingMap = std::map<std::string, std::shared_ptr<BroadcastRing>>;
+
+    std::shared_ptr<BroadcastRing> ringFor(RingMap& rings, const std::string& source_id) {
+        std::scoped_lock lock(rings_mutex_);
+        auto& ring = rings[source_id];
+        if (!ring) {
+            ring = std::make_shared<BroadcastRing>();
+        }
+        return ring;
+    }
+
     std::shared_ptr<rtc::PeerConnection> CreatePeerConnection(const std::string& client_id) {
         try {
             auto peer_connection = std::make_shared<rtc::PeerConnection>(rtc_config_);
@@ -487,6 +538,7 @@ private:
                 }
 
                 if (connected) {
+                    Wake();
                     if (on_client_connected_) {
                         on_client_connected_(client_id);
                     }
@@ -515,101 +567,200 @@ private:
         }
     }
 
-    void SendVideoFrames() {
-        int frames_sent_count = 0;
-        const size_t MAX_CHUNK_SIZE = 16384;
+    // Wakes the sender; called whenever a ring gets a packet, a client
+    // becomes sendable again or the streamer stops.
+    void Wake() {
+        {
+            std::scoped_lock lock(wake_mutex_);
+            ++wake_seq_;
+        }
+        wake_cv_.notify_one();
+    }
 
+    void SendVideoFrames() {
+        uint64_t seen = 0;
         while (!should_stop_sender_) {
-            std::vector<std::pair<std::string, std::string>> clients;
+            {
+                // A wake-up that arrives while the clients are being served
+                // bumps wake_seq_, so the next wait returns immediately.
+                std::unique_lock lock(wake_mutex_);
+                wake_cv_.wait_for(lock, kSenderIdleWait, [&]() {
+                    return should_stop_sender_ || wake_seq_ != seen;
+                });
+                seen = wake_seq_;
+            }
+            if (should_stop_sender_) {
+                break;
+            }
+
+            std::vector<std::shared_ptr<ClientConnection>> clients;
             {
                 std::scoped_lock lock(clients_mutex_);
                 for (auto& [client_id, client] : clients_) {
                     if (client->connected && client->data_channel && client->data_channel->isOpen()) {
-                        clients.emplace_back(client_id, client->requested_source);
+                        clients.push_back(client);
                     }
                 }
             }
 
-            for (const auto& [client_id, requested_source] : clients) {
-                if (!video_source_->HasEncodedFrame(requested_source)) {
-                    continue;
-                }
-                auto encoded_frame = video_source_->GetEncodedFrame(requested_source);
-                if (encoded_frame.empty()) {
-                    continue;
-                }
+            for (const auto& client : clients) {
+                ServeClient(*client);
+            }
+            AdaptRate(clients);
+        }
+    }
 
-                std::shared_ptr<ClientConnection> client;
+    // One encoder feeds every client, so the slowest one sets the rate.
+    void AdaptRate(const std::vector<std::shared_ptr<ClientConnection>>& clients) {
+        const auto now = std::chrono::steady_clock::now();
+        if (now - last_rate_check_ < kRateInterval) {
+            return;
+        }
+        last_rate_check_ = now;
+
+        bool changed = false;
+        if (clients.empty()) {
+            changed = rate_.scale() < 1.0;
+            rate_.reset();
+        } else {
+            bool congested = false;
+            bool clear = true;
+            for (const auto& client : clients) {
+                const size_t buffered = client->data_channel->bufferedAmount();
+                const bool skipped = client->video_cursor.skipped > client->skipped_at_rate_check;
+                client->skipped_at_rate_check = client->video_cursor.skipped;
+                double queue_delay_ms = 0.0;
                 {
                     std::scoped_lock lock(clients_mutex_);
-                    auto it = clients_.find(client_id);
-                    if (it == clients_.end()) {
-                        continue;
-                    }
-                    client = it->second;
-                    if (!client->connected || !client->data_channel || !client->data_channel->isOpen()) {
-                        continue;
-                    }
+                    queue_delay_ms = client->stats.queue_delay_ms;
                 }
+                if (skipped || buffered >= kSendHighWatermark || queue_delay_ms > kCongestedDelayMs) {
+                    congested = true;
+                } else if (buffered >= kSendLowWatermark) {
+                    clear = false;
+                }
+            }
+            changed = rate_.update(congested ? RateController::Signal::Congested
+                                   : clear   ? RateController::Signal::Clear
+                                             : RateController::Signal::Steady);
+        }
+        if (changed && on_rate_scale_) {
+            on_rate_scale_(rate_.scale());
+        }
+    }
 
-                try {
-                    uint32_t total_size = static_cast<uint32_t>(encoded_frame.size());
-                    if (total_size <= MAX_CHUNK_SIZE - 4) {
-                        std::string packet(4 + encoded_frame.size(), '\0');
-                        packet[0] = static_cast<char>((total_size >> 24) & 0xFF);
-                        packet[1] = static_cast<char>((total_size >> 16) & 0xFF);
-                        packet[2] = static_cast<char>((total_size >> 8) & 0xFF);
-                        packet[3] = static_cast<char>(total_size & 0xFF);
-                        std::memcpy(packet.data() + 4, encoded_frame.data(), encoded_frame.size());
-                        client->data_channel->send(packet);
-                    } else {
-                        std::string header(4, '\0');
-                        header[0] = static_cast<char>((total_size >> 24) & 0xFF);
-                        header[1] = static_cast<char>((total_size >> 16) & 0xFF);
-                        header[2] = static_cast<char>((total_size >> 8) & 0xFF);
-                        header[3] = static_cast<char>(total_size & 0xFF);
-                        client->data_channel->send(header);
-
-                        size_t offset = 0;
-                        while (offset < encoded_frame.size()) {
-                            size_t chunk_size = encoded_frame.size() - offset;
-                            if (chunk_size > MAX_CHUNK_SIZE) {
-                                chunk_size = MAX_CHUNK_SIZE;
-                            }
-                            std::string chunk_buffer(chunk_size, '\0');
-                            std::memcpy(chunk_buffer.data(), encoded_frame.data() + offset, chunk_size);
-                            client->data_channel->send(chunk_buffer);
-                            offset += chunk_size;
-                            std::this_thread::sleep_for(std::chrono::milliseconds(1));
-                        }
-                    }
+    void ServeClient(ClientConnection& client) {
+        std::string requested_source;
+        {
+            std::scoped_lock lock(clients_mutex_);
+            requested_source = client.requested_source;
+        }
+        if (requested_source != client.cursor_source) {
+            client.cursor_source = requested_source;
+            client.video_cursor = {};
+            client.meta_cursor = {};
+        }
 
-                    frames_sent_count++;
-                } catch (const std::exception& ex) {
-                    VA_LOG_WARN() << "Failed to send frame to client " << client_id << ": " << ex.what();
-                }
+        SendMetadata(client);
+
+        // Every client reads the same shared packets through its own cursor;
+        // nothing is consumed on behalf of the others. A client whose channel
+        // is backed up is left alone until its low-watermark callback fires.
+        auto ring = ringFor(video_rings_, requested_source);
+        PacketBuffer framed;
+        BroadcastRing::Clock::time_point pushed_at;
+        uint64_t sent = 0;
+        double delay_sum_ms = 0.0;
+        while (client.data_channel->bufferedAmount() < kSendHighWatermark
+               && ring->read(client.video_cursor, framed, pushed_at)) {
+            if (!SendFramed(client, framed)) {
+                break;
+            }
+            ++sent;
+            delay_sum_ms += std::chrono::duration<double, std::milli>(BroadcastRing::Clock::now() - pushed_at).count();
+        }
+
+        std::scoped_lock lock(clients_mutex_);
+        auto& stats = client.stats;
+        stats.client_id = client.client_id;
+        stats.source_id = client.cursor_source;
+        stats.packets += sent;
+        stats.skipped_packets = client.video_cursor.skipped;
+        stats.buffered_bytes = static_cast<uint64_t>(client.data_channel->bufferedAmount());
+        if (sent > 0) {
+            const double batch_ms = delay_sum_ms / static_cast<double>(sent);
+            stats.queue_delay_ms = stats.packets == sent ? batch_ms : stats.queue_delay_ms + 0.2 * (batch_ms - stats.queue_delay_ms);
+        }
+    }
+
+    // `framed` already carries the 4-byte length prefix. Large frames go out
+    // as consecutive views of the shared buffer; the first one starts with
+    // the prefix, which is all the receiver needs to reassemble them. The
+    // chunks are queued back to back: pacing happens per frame, against the
+    // channel's buffered amount, not by sleeping between chunks.
+    bool SendFramed(ClientConnection& client, const PacketBuffer& framed) {
+        const size_t MAX_CHUNK_SIZE = 16384;
+        try {
+            size_t offset = 0;
+            while (offset < framed.size()) {
+                const size_t chunk_size = std::min(MAX_CHUNK_SIZE, framed.size() - offset);
+                client.data_channel->send(reinterpret_cast<const std::byte*>(framed.data() + offset), chunk_size);
+                offset += chunk_size;
             }
+            return true;
+        } catch (const std::exception& ex) {
+            VA_LOG_WARN() << "Failed to send frame to client " << client.client_id << ": " << ex.what();
+            return false;
+        }
+    }
 
-            std::this_thread::sleep_for(std::chrono::milliseconds(33));
+    // Records are small, so each one is a single binary message with no length
+    // prefix. A dropped record only costs binary consumers the frames up to
+    // the next keyframe.
+    void SendMetadata(ClientConnection& client) {
+        if (!client.meta_channel || !client.meta_channel->isOpen()) {
+            return;
+        }
+        auto ring = ringFor(meta_rings_, client.cursor_source);
+        PacketBuffer record;
+        while (client.meta_channel->bufferedAmount() < kSendHighWatermark && ring->read(client.meta_cursor, record)) {
+            try {
+                client.meta_channel->send(reinterpret_cast<const std::byte*>(record.data()), record.size());
+            } catch (const std::exception& ex) {
+                VA_LOG_WARN() << "Failed to send metadata to client " << client.client_id << ": " << ex.what();
+                return;
+            }
         }
     }
 
     bool initialized_;
     int port_;
     std::atomic<bool> should_stop_sender_;
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    uint64_t wake_seq_ {0};
     rtc::Configuration rtc_config_;
-    std::unique_ptr<WebRTCVideoSource> video_source_;
+    mutable std::mutex rings_mutex_;
+    RingMap video_rings_;
+    RingMap meta_rings_;
     mutable std::mutex clients_mutex_;
     std::map<std::string, std::shared_ptr<ClientConnection>> clients_;
     std::function<void(const std::string&)> on_client_connected_;
     std::function<void(const std::string&)> on_client_disconnected_;
     std::function<void(const std::string&, const Json::Value&)> on_signaling_message_;
+    std::function<void(double)> on_rate_scale_;
+    // Sender thread only.
+    RateController rate_;
+    std::chrono::steady_clock::time_point last_rate_check_ {};
     std::thread video_sender_thread_;
 };
 
 } // namespace
 
 struct WebRTCDataChannelTransport::Impl {
+    explicit Impl(WebRTCDataChannelTransport::Options options)
+        : options_(options) {}
+
     bool ensureStarted(const std::string& endpoint) {
         if (running_) {
             return true;
@@ -623,8 +774,30 @@ struct WebRTCDataChannelTransport::Impl {
         });
 
         streamer_.SetOnClientConnected([this](const std::string&) {
-            std::scoped_lock lock(mutex_);
-            aggregate_.connected = true;
+            std::function<void()> handler;
+            {
+                std::scoped_lock lock(mutex_);
+                aggregate_.connected = true;
+                aggregate_.keyframe_requests += 1;
+                handler = feedback_.request_keyframe;
+            }
+            // A fresh IDR lets the new client start without waiting out the
+            // GOP when the ring no longer holds a keyframe.
+            if (handler) {
+                handler();
+            }
+        });
+
+        streamer_.SetOnRateScale([this](double scale) {
+            std::function<void(double)> handler;
+            {
+                std::scoped_lock lock(mutex_);
+                aggregate_.rate_scale = scale;
+                handler = feedback_.rate_scale;
+            }
+            if (handler) {
+                handler(scale);
+            }
         });
 
         streamer_.SetOnClientDisconnected([this](const std::string&) {
@@ -636,7 +809,7 @@ struct WebRTCDataChannelTransport::Impl {
             handleSignalingMessage(client_id, message);
         });
 
-        if (!streamer_.Initialize(kDefaultStreamerPort)) {
+        if (!streamer_.Initialize(kDefaultStreamerPort, options_)) {
             return false;
         }
         if (!signaling_.start(port)) {
@@ -658,17 +831,36 @@ struct WebRTCDataChannelTransport::Impl {
             std::scoped_lock lock(mutex_);
             track_stats_.clear();
             aggregate_ = {};
+            window_copied_ = 0;
+            window_start_ = std::chrono::steady_clock::now();
         }
         running_ = false;
     }
 
-    bool sendPacket(const std::string& track_id, const uint8_t* data, size_t size) {
-        if (!running_ || !data || size == 0) {
+    bool sendPacket(const std::string& track_id, const PacketBuffer& packet, bool keyframe) {
+        if (!running_ || packet.empty()) {
             return false;
         }
 
-        std::vector<uint8_t> buffer(data, data + size);
-        streamer_.PushEncodedFrame(track_id, std::move(buffer));
+        // The length prefix is written into the packet's headroom, so the
+        // encoder's buffer is what every client sends. Only packets without
+        // headroom (not from our encoders) are copied once here.
+        const size_t size = packet.size();
+        size_t copied = 0;
+        PacketBuffer framed = packet;
+        uint8_t* header = framed.prepend(4);
+        if (!header) {
+            framed = PacketBuffer::copyOf(packet.data(), size);
+            header = framed.prepend(4);
+            copied = size;
+        }
+        const auto total_size = static_cast<uint32_t>(size);
+        header[0] = static_cast<uint8_t>((total_size >> 24) & 0xFF);
+        header[1] = static_cast<uint8_t>((total_size >> 16) & 0xFF);
+        header[2] = static_cast<uint8_t>((total_size >> 8) & 0xFF);
+        header[3] = static_cast<uint8_t>(total_size & 0xFF);
+
+        streamer_.PushEncodedFrame(track_id, std::move(framed), keyframe);
 
         std::scoped_lock lock(mutex_);
         auto& stat = track_stats_[track_id];
@@ -678,12 +870,63 @@ struct WebRTCDataChannelTransport::Impl {
         aggregate_.connected = true;
         aggregate_.packets += 1;
         aggregate_.bytes += static_cast<uint64_t>(size);
+        countCopy(stat, copied);
         return true;
     }
 
-    ITransport::Stats aggregateStats() const {
+    bool sendMetadata(const std::string& track_id, const uint8_t* data, size_t size, bool keyframe) {
+        if (!running_ || !data || size == 0) {
+            return false;
+        }
+
+        // Records are serialised into a buffer the pipeline reuses, so the
+        // ring keeps its own copy.
+        streamer_.PushMetadata(track_id, PacketBuffer::copyOf(data, size, 0), keyframe);
+
         std::scoped_lock lock(mutex_);
-        return aggregate_;
+        auto& stat = track_stats_[track_id];
+        stat.metadata_packets += 1;
+        stat.metadata_bytes += static_cast<uint64_t>(size);
+        aggregate_.metadata_packets += 1;
+        aggregate_.metadata_bytes += static_cast<uint64_t>(size);
+        countCopy(stat, size);
+        return true;
+    }
+
+    void setEncoderFeedback(ITransport::EncoderFeedback feedback) {
+        std::scoped_lock lock(mutex_);
+        feedback_ = std::move(feedback);
+    }
+
+    // Caller holds mutex_.
+    void countCopy(ITransport::Stats& stat, size_t bytes) {
+        stat.bytes_copied += static_cast<uint64_t>(bytes);
+        aggregate_.bytes_copied += static_cast<uint64_t>(bytes);
+        window_copied_ += static_cast<uint64_t>(bytes);
+        rollCopyWindow(std::chrono::steady_clock::now());
+    }
+
+    // Caller holds mutex_.
+    void rollCopyWindow(std::chrono::steady_clock::time_point now) const {
+        const double elapsed_s = std::chrono::duration<double>(now - window_start_).count();
+        if (elapsed_s >= 1.0) {
+            aggregate_.bytes_copied_per_sec = static_cast<double>(window_copied_) / elapsed_s;
+            window_copied_ = 0;
+            window_start_ = now;
+        }
+    }
+
+    ITransport::Stats aggregateStats() const {
+        ITransport::Stats stats;
+        {
+            std::scoped_lock lock(mutex_);
+            rollCopyWindow(std::chrono::steady_clock::now());
+            stats = aggregate_;
+        }
+        stats.subscribers = streamer_.ConnectedClients();
+        stats.skipped_packets = streamer_.SkippedPackets();
+        stats.clients = streamer_.ClientStats();
+        return stats;
     }
 
     void handleSignalingMessage(const std::string& client_id, const Json::Value& message) {
@@ -733,17 +976,24 @@ struct WebRTCDataChannelTransport::Impl {
         }
     }
 
+    const WebRTCDataChannelTransport::Options options_;
     SignalingServer signaling_;
     WebRTCStreamer streamer_;
     bool running_{false};
     std::string endpoint_;
     mutable std::mutex mutex_;
     std::unordered_map<std::string, ITransport::Stats> track_stats_;
-    ITransport::Stats aggregate_;
+    mutable ITransport::Stats aggregate_;
+    ITransport::EncoderFeedback feedback_;
+    mutable uint64_t window_copied_ {0};
+    mutable std::chrono::steady_clock::time_point window_start_ {std::chrono::steady_clock::now()};
 };
 
 WebRTCDataChannelTransport::WebRTCDataChannelTransport()
-    : impl_(std::make_shared<Impl>()) {}
+    : WebRTCDataChannelTransport(Options{}) {}
+
+WebRTCDataChannelTransport::WebRTCDataChannelTransport(Options options)
+    : impl_(std::make_shared<Impl>(options)) {}
 
 WebRTCDataChannelTransport::~WebRTCDataChannelTransport() {
     disconnect();
@@ -753,11 +1003,27 @@ bool WebRTCDataChannelTransport::connect(const std::string& endpoint) {
     return impl_ && impl_->ensureStarted(endpoint);
 }
 
-bool WebRTCDataChannelTransport::send(const std::string& track_id, const uint8_t* data, size_t size) {
+bool WebRTCDataChannelTransport::send(const std::string& track_id, const PacketBuffer& packet, bool keyframe) {
     if (!impl_) {
         return false;
     }
-    return impl_->sendPacket(track_id, data, size);
+    return impl_->sendPacket(track_id, packet, keyframe);
+}
+
+bool WebRTCDataChannelTransport::sendMetadata(const std::string& track_id,
+                                              const uint8_t* data,
+                                              size_t size,
+                                              bool keyframe) {
+    if (!impl_) {
+        return false;
+    }
+    return impl_->sendMetadata(track_id, data, size, keyframe);
+}
+
+void WebRTCDataChannelTransport::setEncoderFeedback(EncoderFeedback feedback) {
+    if (impl_) {
+        impl_->setEncoderFeedback(std::move(feedback));
+    }
 }
 
 void WebRTCDataChannelTransport::disconnect() {
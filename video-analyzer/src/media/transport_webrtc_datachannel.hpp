@@ -2,6 +2,7 @@
 
 #include "media/transport.hpp"
 
+#include <cstdint>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -10,11 +11,20 @@ namespace va::media {
 
 class WebRTCDataChannelTransport : public ITransport {
 public:
+    struct Options {
+        // Local UDP ports ICE may bind (webrtc.ice_port_min/max in app.yaml).
+        uint16_t ice_port_min {10000};
+        uint16_t ice_port_max {10100};
+    };
+
     WebRTCDataChannelTransport();
+    explicit WebRTCDataChannelTransport(Options options);
     ~WebRTCDataChannelTransport() override;
 
     bool connect(const std::string& endpoint) override;
-    bool send(const std::string& track_id, const uint8_t* data, size_t size) override;
+    bool send(const std::string& track_id, const PacketBuffer& packet, bool keyframe) override;
+    bool sendMetadata(const std::string& track_id, const uint8_t* data, size_t size, bool keyframe) override;
+    void setEncoderFeedback(EncoderFeedback feedback) override;
     void disconnect() override;
     Stats stats() const override;
 
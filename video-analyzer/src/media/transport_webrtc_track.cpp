@@ -0,0 +1,698 @@
+#include "media/transport_webrtc_track.hpp"
+
+#include "core/logger.hpp"
+#include "core/utils.hpp"
+#include "media/rate_control.hpp"
+
+#include <rtc/rtc.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <iomanip>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+namespace va::media {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr uint32_t kVideoClockRate = 90000;
+// acceptOffer() answers with the candidates gathered within this bound (host
+// candidates are ready almost at once); later ones are trickled through
+// updateSession().
+constexpr auto kAnswerGatheringBound = std::chrono::milliseconds(250);
+// Sender reports remembered for matching the LSR field of receiver reports.
+constexpr size_t kMaxSenderReports = 16;
+// Rate adaptation looks at the worst viewer's RTCP loss once per interval.
+constexpr auto kRateInterval = std::chrono::seconds(1);
+constexpr double kLossCongested = 0.10;
+constexpr double kLossClear = 0.02;
+
+constexpr uint8_t kRtcpSenderReport = 200;
+constexpr uint8_t kRtcpReceiverReport = 201;
+constexpr uint8_t kRtcpPayloadFeedback = 206;
+constexpr uint8_t kFeedbackPli = 1;
+constexpr uint8_t kFeedbackFir = 4;
+
+uint16_t readU16(const uint8_t* p) {
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+uint32_t readU32(const uint8_t* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16)
+           | (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+std::string randomHex(size_t bytes) {
+    static thread_local std::mt19937_64 rng(std::random_device{}());
+    std::ostringstream oss;
+    oss << std::hex << std::setfill('0');
+    for (size_t i = 0; i < bytes; ++i) {
+        oss << std::setw(2) << static_cast<unsigned>(rng() & 0xFF);
+    }
+    return oss.str();
+}
+
+uint32_t randomSsrc() {
+    static thread_local std::mt19937 rng(std::random_device{}());
+    return std::uniform_int_distribution<uint32_t>(1, 0xFFFFFFFEu)(rng);
+}
+
+struct OfferedVideo {
+    std::string mid;
+    int payload_type {-1};
+    std::string fmtp;
+};
+
+// Finds the offer's video section and an H.264 payload type we can feed
+// (packetization-mode=1), preferring constrained baseline.
+bool findOfferedH264(rtc::Description& offer, OfferedVideo& out) {
+    for (int i = 0; i < offer.mediaCount(); ++i) {
+        auto entry = offer.media(static_cast<unsigned int>(i));
+        auto* const* media_ptr = std::get_if<rtc::Description::Media*>(&entry);
+        if (!media_ptr || !*media_ptr || (*media_ptr)->type() != "video") {
+            continue;
+        }
+        auto* media = *media_ptr;
+        for (int payload_type : media->payloadTypes()) {
+            auto* map = media->rtpMap(payload_type);
+            if (!map || core::toLower(map->format) != "h264") {
+                continue;
+            }
+            std::string fmtp;
+            for (const auto& param : map->fmtps) {
+                fmtp += (fmtp.empty() ? "" : ";") + param;
+            }
+            const std::string lowered = core::toLower(fmtp);
+            if (lowered.find("packetization-mode=1") == std::string::npos) {
+                continue;
+            }
+            const bool baseline = lowered.find("profile-level-id=42e01f") != std::string::npos;
+            if (out.payload_type < 0 || baseline) {
+                out.mid = media->mid();
+                out.payload_type = payload_type;
+                out.fmtp = fmtp;
+            }
+            if (baseline) {
+                return true;
+            }
+        }
+        return out.payload_type >= 0;
+    }
+    return false;
+}
+
+// Watches RTCP in both directions without consuming it. Outgoing sender
+// reports are remembered so a receiver report's LSR/DLSR yields the round
+// trip time; incoming PLI/FIR for our SSRC become keyframe requests.
+class RtcpObserver : public rtc::MediaHandler {
+public:
+    struct Report {
+        double rtt_ms {0.0};
+        double fraction_lost {0.0};
+        int64_t packets_lost {0};
+        double jitter_ms {0.0};
+    };
+
+    RtcpObserver(uint32_t ssrc, std::function<void()> on_keyframe_request)
+        : ssrc_(ssrc), on_keyframe_request_(std::move(on_keyframe_request)) {}
+
+    void incoming(rtc::message_vector& messages, const rtc::message_callback& /*send*/) override {
+        for (const auto& message : messages) {
+            if (message && message->type == rtc::Message::Control) {
+                parse(reinterpret_cast<const uint8_t*>(message->data()), message->size(), false);
+            }
+        }
+    }
+
+    void outgoing(rtc::message_vector& messages, const rtc::message_callback& /*send*/) override {
+        for (const auto& message : messages) {
+            if (message && message->type == rtc::Message::Control) {
+                parse(reinterpret_cast<const uint8_t*>(message->data()), message->size(), true);
+            }
+        }
+    }
+
+    Report report() const {
+        std::scoped_lock lock(mutex_);
+        return report_;
+    }
+
+private:
+    struct SentReport {
+        uint32_t ntp_middle {0};
+        Clock::time_point sent_at;
+    };
+
+    void parse(const uint8_t* data, size_t size, bool outgoing) {
+        bool keyframe_request = false;
+        size_t offset = 0;
+        while (offset + 8 <= size) {
+            const uint8_t* packet = data + offset;
+            if ((packet[0] >> 6) != 2) {
+                break;
+            }
+            const uint8_t count = packet[0] & 0x1F;
+            const uint8_t type = packet[1];
+            const size_t length = (static_cast<size_t>(readU16(packet + 2)) + 1) * 4;
+            if (offset + length > size) {
+                break;
+            }
+
+            if (outgoing) {
+                if (type == kRtcpSenderReport && length >= 28 && readU32(packet + 4) == ssrc_) {
+                    rememberSenderReport(readU32(packet + 10));
+                }
+            } else if (type == kRtcpSenderReport && length >= 28) {
+                handleReportBlocks(packet + 28, count, length - 28);
+            } else if (type == kRtcpReceiverReport) {
+                handleReportBlocks(packet + 8, count, length - 8);
+            } else if (type == kRtcpPayloadFeedback && length >= 12) {
+                if (count == kFeedbackPli) {
+                    const uint32_t media_ssrc = readU32(packet + 8);
+                    keyframe_request |= media_ssrc == ssrc_ || media_ssrc == 0;
+                } else if (count == kFeedbackFir) {
+                    for (size_t fci = 12; fci + 8 <= length; fci += 8) {
+                        keyframe_request |= readU32(packet + fci) == ssrc_;
+                    }
+                }
+            }
+            offset += length;
+        }
+        if (keyframe_request && on_keyframe_request_) {
+            on_keyframe_request_();
+        }
+    }
+
+    void rememberSenderReport(uint32_t ntp_middle) {
+        std::scoped_lock lock(mutex_);
+        sent_reports_.push_back(SentReport{ntp_middle, Clock::now()});
+        if (sent_reports_.size() > kMaxSenderReports) {
+            sent_reports_.pop_front();
+        }
+    }
+
+    void handleReportBlocks(const uint8_t* blocks, uint8_t count, size_t available) {
+        for (uint8_t i = 0; i < count && (static_cast<size_t>(i) + 1) * 24 <= available; ++i) {
+            const uint8_t* block = blocks + static_cast<size_t>(i) * 24;
+            if (readU32(block) != ssrc_) {
+                continue;
+            }
+            int32_t lost = static_cast<int32_t>((block[5] << 16) | (block[6] << 8) | block[7]);
+            if (lost & 0x800000) {
+                lost -= 0x1000000;
+            }
+            const uint32_t lsr = readU32(block + 16);
+            const uint32_t dlsr = readU32(block + 20);
+
+            std::scoped_lock lock(mutex_);
+            report_.fraction_lost = block[4] / 256.0;
+            report_.packets_lost = lost;
+            report_.jitter_ms = readU32(block + 12) * 1000.0 / kVideoClockRate;
+            if (lsr == 0) {
+                continue;
+            }
+            auto sent = std::find_if(sent_reports_.rbegin(), sent_reports_.rend(), [lsr](const SentReport& report) {
+                return report.ntp_middle == lsr;
+            });
+            if (sent != sent_reports_.rend()) {
+                const double since_sent_ms = std::chrono::duration<double, std::milli>(Clock::now() - sent->sent_at).count();
+                report_.rtt_ms = std::max(0.0, since_sent_ms - dlsr * 1000.0 / 65536.0);
+            }
+        }
+    }
+
+    const uint32_t ssrc_;
+    std::function<void()> on_keyframe_request_;
+    mutable std::mutex mutex_;
+    std::deque<SentReport> sent_reports_;
+    Report report_;
+};
+
+} // namespace
+
+struct WebRTCTrackTransport::Impl : std::enable_shared_from_this<WebRTCTrackTransport::Impl> {
+    explicit Impl(WebRTCTrackTransport::Options options)
+        : options_(options) {}
+
+    struct Session {
+        std::string id;
+        std::shared_ptr<rtc::PeerConnection> peer_connection;
+        std::shared_ptr<rtc::Track> track;
+        std::shared_ptr<rtc::RtpPacketizationConfig> rtp_config;
+        std::shared_ptr<RtcpObserver> rtcp;
+        std::atomic<bool> open {false};
+        std::atomic<bool> closed {false};
+        std::atomic<uint64_t> packets {0};
+        // Send thread only: nothing is sent until the first keyframe.
+        bool waiting_keyframe {true};
+        // Trickle ICE. Candidates gathered after the answer was taken wait
+        // here for the viewer's next PATCH.
+        std::string mid;
+        std::mutex ice_mutex;
+        std::condition_variable ice_cv;
+        bool answered {false};
+        bool gathering_complete {false};
+        std::vector<std::string> late_candidates;
+    };
+
+    bool start() {
+        if (running_) {
+            return true;
+        }
+        rtc_config_.enableIceTcp = false;
+        rtc_config_.portRangeBegin = options_.ice_port_min;
+        rtc_config_.portRangeEnd = options_.ice_port_max;
+        epoch_ = Clock::now();
+        {
+            std::scoped_lock lock(mutex_);
+            stats_ = {};
+        }
+        rate_.reset();
+        running_ = true;
+        return true;
+    }
+
+    void stop() {
+        running_ = false;
+        std::unordered_map<std::string, std::shared_ptr<Session>> sessions;
+        {
+            std::scoped_lock lock(mutex_);
+            sessions.swap(sessions_);
+        }
+        for (auto& [id, session] : sessions) {
+            closeConnection(*session);
+        }
+    }
+
+    bool acceptOffer(const std::string& offer_sdp, std::string& answer_sdp, std::string& session_id) {
+        if (!running_) {
+            return false;
+        }
+        try {
+            rtc::Description offer(offer_sdp, rtc::Description::Type::Offer);
+            OfferedVideo video;
+            if (!findOfferedH264(offer, video)) {
+                VA_LOG_WARN() << "WHEP offer has no H.264 (packetization-mode=1) video section";
+                return false;
+            }
+
+            auto session = std::make_shared<Session>();
+            session->id = randomHex(8);
+            session->mid = video.mid;
+            const uint32_t ssrc = randomSsrc();
+            const std::string cname = "va-" + session->id;
+
+            auto peer_connection = std::make_shared<rtc::PeerConnection>(rtc_config_);
+            rtc::Description::Video media(video.mid, rtc::Description::Direction::SendOnly);
+            media.addH264Codec(video.payload_type, video.fmtp);
+            media.addSSRC(ssrc, cname, std::string("va"), std::string("video"));
+            auto track = peer_connection->addTrack(media);
+
+            auto rtp_config = std::make_shared<rtc::RtpPacketizationConfig>(
+                ssrc, cname, static_cast<uint8_t>(video.payload_type), kVideoClockRate);
+            auto packetizer = std::make_shared<rtc::H264RtpPacketizer>(rtc::NalUnit::Separator::StartSequence, rtp_config);
+            packetizer->addToChain(std::make_shared<rtc::RtcpSrReporter>(rtp_config));
+            packetizer->addToChain(std::make_shared<rtc::RtcpNackResponder>());
+            std::weak_ptr<Impl> weak_self = shared_from_this();
+            auto rtcp = std::make_shared<RtcpObserver>(ssrc, [weak_self]() {
+                if (auto self = weak_self.lock()) {
+                    self->requestKeyframe();
+                }
+            });
+            packetizer->addToChain(rtcp);
+            track->setMediaHandler(packetizer);
+
+            std::weak_ptr<Session> weak_session = session;
+            track->onOpen([weak_self, weak_session]() {
+                if (auto opened = weak_session.lock()) {
+                    opened->open = true;
+                }
+                // A new viewer can only start decoding at an IDR.
+                if (auto self = weak_self.lock()) {
+                    self->requestKeyframe();
+                }
+            });
+            track->onClosed([weak_session]() {
+                if (auto closed = weak_session.lock()) {
+                    closed->closed = true;
+                }
+            });
+            const std::string id = session->id;
+            peer_connection->onStateChange([weak_session, id](rtc::PeerConnection::State state) {
+                // Disconnected is transient: ICE may still recover, so only
+                // Failed and Closed end the session.
+                if (state == rtc::PeerConnection::State::Failed || state == rtc::PeerConnection::State::Closed) {
+                    VA_LOG_INFO() << "WHEP session " << id << " ended";
+                    if (auto ended = weak_session.lock()) {
+                        ended->closed = true;
+                    }
+                }
+            });
+
+            peer_connection->onLocalCandidate([weak_session](rtc::Candidate candidate) {
+                if (auto gathered = weak_session.lock()) {
+                    std::scoped_lock lock(gathered->ice_mutex);
+                    if (gathered->answered) {
+                        gathered->late_candidates.emplace_back(candidate);
+                    }
+                }
+            });
+            peer_connection->onGatheringStateChange([weak_session](rtc::PeerConnection::GatheringState state) {
+                if (state != rtc::PeerConnection::GatheringState::Complete) {
+                    return;
+                }
+                if (auto gathered = weak_session.lock()) {
+                    {
+                        std::scoped_lock lock(gathered->ice_mutex);
+                        gathered->gathering_complete = true;
+                    }
+                    gathered->ice_cv.notify_all();
+                }
+            });
+
+            // With auto-negotiation the answer is created as soon as the offer
+            // is applied; the local track above answers the offer's video mid.
+            peer_connection->setRemoteDescription(offer);
+            {
+                // Marked answered before the description is read, so a
+                // candidate arriving in between is trickled (at worst twice)
+                // rather than lost.
+                std::unique_lock lock(session->ice_mutex);
+                session->ice_cv.wait_for(lock, kAnswerGatheringBound, [&]() { return session->gathering_complete; });
+                session->answered = true;
+            }
+
+            auto local = peer_connection->localDescription();
+            if (!local) {
+                peer_connection->close();
+                return false;
+            }
+            answer_sdp = std::string(*local);
+            session_id = id;
+
+            session->peer_connection = std::move(peer_connection);
+            session->track = std::move(track);
+            session->rtp_config = std::move(rtp_config);
+            session->rtcp = std::move(rtcp);
+            {
+                std::scoped_lock lock(mutex_);
+                sessions_[id] = std::move(session);
+            }
+            VA_LOG_INFO() << "WHEP session " << id << " created (H.264 pt " << video.payload_type << ")";
+            return true;
+        } catch (const std::exception& ex) {
+            VA_LOG_ERROR() << "Failed to answer WHEP offer: " << ex.what();
+            return false;
+        }
+    }
+
+    bool updateSession(const std::string& session_id, const std::string& fragment, std::string& local_fragment) {
+        std::shared_ptr<Session> session;
+        {
+            std::scoped_lock lock(mutex_);
+            auto it = sessions_.find(session_id);
+            if (it == sessions_.end()) {
+                return false;
+            }
+            session = it->second;
+        }
+        try {
+            std::istringstream lines(fragment);
+            std::string line;
+            std::string mid = session->mid;
+            while (std::getline(lines, line)) {
+                if (!line.empty() && line.back() == '\r') {
+                    line.pop_back();
+                }
+                if (line.rfind("a=mid:", 0) == 0) {
+                    mid = line.substr(6);
+                } else if (line.rfind("a=candidate:", 0) == 0) {
+                    session->peer_connection->addRemoteCandidate(rtc::Candidate(line.substr(2), mid));
+                }
+            }
+        } catch (const std::exception& ex) {
+            VA_LOG_WARN() << "WHEP session " << session_id << ": bad candidate: " << ex.what();
+            return false;
+        }
+
+        std::vector<std::string> candidates;
+        bool complete = false;
+        {
+            std::scoped_lock lock(session->ice_mutex);
+            candidates.swap(session->late_candidates);
+            complete = session->gathering_complete;
+        }
+        local_fragment.clear();
+        if (candidates.empty() && !complete) {
+            return true;
+        }
+        local_fragment = "a=mid:" + session->mid + "\r\n";
+        for (const auto& candidate : candidates) {
+            local_fragment += candidate + "\r\n";
+        }
+        if (complete) {
+            local_fragment += "a=end-of-candidates\r\n";
+        }
+        return true;
+    }
+
+    bool closeSession(const std::string& session_id) {
+        std::shared_ptr<Session> session;
+        {
+            std::scoped_lock lock(mutex_);
+            auto it = sessions_.find(session_id);
+            if (it == sessions_.end()) {
+                return false;
+            }
+            session = std::move(it->second);
+            sessions_.erase(it);
+        }
+        closeConnection(*session);
+        return true;
+    }
+
+    bool send(const PacketBuffer& packet, bool keyframe) {
+        if (!running_ || packet.empty()) {
+            return false;
+        }
+
+        // RTP time follows the send clock; the pipeline sends frames as soon
+        // as they are encoded, so this is also their capture spacing.
+        const auto rtp_ticks = static_cast<uint32_t>(
+            static_cast<uint64_t>(std::chrono::duration<double>(Clock::now() - epoch_).count() * kVideoClockRate));
+
+        std::vector<std::shared_ptr<Session>> sessions;
+        std::vector<std::shared_ptr<Session>> ended;
+        {
+            std::scoped_lock lock(mutex_);
+            for (auto it = sessions_.begin(); it != sessions_.end();) {
+                if (it->second->closed) {
+                    ended.push_back(std::move(it->second));
+                    it = sessions_.erase(it);
+                } else {
+                    sessions.push_back(it->second);
+                    ++it;
+                }
+            }
+        }
+        for (auto& session : ended) {
+            closeConnection(*session);
+        }
+
+        for (auto& session : sessions) {
+            if (!session->open || !session->track->isOpen()) {
+                continue;
+            }
+            if (session->waiting_keyframe) {
+                if (!keyframe) {
+                    continue;
+                }
+                session->waiting_keyframe = false;
+            }
+            try {
+                session->rtp_config->timestamp = session->rtp_config->startTimestamp + rtp_ticks;
+                session->track->send(reinterpret_cast<const std::byte*>(packet.data()), packet.size());
+                session->packets += 1;
+            } catch (const std::exception& ex) {
+                VA_LOG_WARN() << "WHEP session " << session->id << ": send failed: " << ex.what();
+            }
+        }
+
+        adaptRate(sessions);
+
+        std::scoped_lock lock(mutex_);
+        stats_.connected = true;
+        stats_.packets += 1;
+        stats_.bytes += static_cast<uint64_t>(packet.size());
+        return true;
+    }
+
+    void setEncoderFeedback(ITransport::EncoderFeedback feedback) {
+        std::scoped_lock lock(mutex_);
+        feedback_ = std::move(feedback);
+    }
+
+    void requestKeyframe() {
+        std::function<void()> handler;
+        {
+            std::scoped_lock lock(mutex_);
+            stats_.keyframe_requests += 1;
+            handler = feedback_.request_keyframe;
+        }
+        if (handler) {
+            handler();
+        }
+    }
+
+    // Send thread. One encoder feeds every viewer, so the one losing the most
+    // packets sets the rate for all of them.
+    void adaptRate(const std::vector<std::shared_ptr<Session>>& sessions) {
+        const auto now = Clock::now();
+        if (now - last_rate_check_ < kRateInterval) {
+            return;
+        }
+        last_rate_check_ = now;
+
+        bool changed = false;
+        bool any_viewer = false;
+        double worst_loss = 0.0;
+        for (const auto& session : sessions) {
+            if (session->open && session->rtcp) {
+                any_viewer = true;
+                worst_loss = std::max(worst_loss, session->rtcp->report().fraction_lost);
+            }
+        }
+        if (!any_viewer) {
+            changed = rate_.scale() < 1.0;
+            rate_.reset();
+        } else {
+            const auto signal = worst_loss > kLossCongested ? RateController::Signal::Congested
+                                : worst_loss < kLossClear   ? RateController::Signal::Clear
+                                                            : RateController::Signal::Steady;
+            changed = rate_.update(signal);
+        }
+        if (!changed) {
+            return;
+        }
+
+        std::function<void(double)> handler;
+        {
+            std::scoped_lock lock(mutex_);
+            stats_.rate_scale = rate_.scale();
+            handler = feedback_.rate_scale;
+        }
+        if (handler) {
+            handler(rate_.scale());
+        }
+    }
+
+    ITransport::Stats stats() const {
+        std::scoped_lock lock(mutex_);
+        ITransport::Stats stats = stats_;
+        stats.connected = running_;
+        for (const auto& [id, session] : sessions_) {
+            if (!session->open || session->closed) {
+                continue;
+            }
+            ITransport::ClientStats client;
+            client.client_id = id;
+            client.packets = session->packets;
+            if (session->rtcp) {
+                const auto report = session->rtcp->report();
+                client.rtt_ms = report.rtt_ms;
+                client.fraction_lost = report.fraction_lost;
+                client.packets_lost = report.packets_lost;
+                client.jitter_ms = report.jitter_ms;
+            }
+            stats.clients.push_back(std::move(client));
+        }
+        stats.subscribers = stats.clients.size();
+        return stats;
+    }
+
+    static void closeConnection(Session& session) {
+        try {
+            if (session.peer_connection) {
+                session.peer_connection->close();
+            }
+        } catch (const std::exception& ex) {
+            VA_LOG_WARN() << "WHEP session " << session.id << ": close failed: " << ex.what();
+        }
+    }
+
+    const WebRTCTrackTransport::Options options_;
+    std::atomic<bool> running_ {false};
+    rtc::Configuration rtc_config_;
+    Clock::time_point epoch_ {Clock::now()};
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, std::shared_ptr<Session>> sessions_;
+    ITransport::EncoderFeedback feedback_;
+    ITransport::Stats stats_;
+    // Send thread only.
+    RateController rate_;
+    Clock::time_point last_rate_check_ {};
+};
+
+WebRTCTrackTransport::WebRTCTrackTransport()
+    : WebRTCTrackTransport(Options{}) {}
+
+WebRTCTrackTransport::WebRTCTrackTransport(Options options)
+    : impl_(std::make_shared<Impl>(options)) {}
+
+WebRTCTrackTransport::~WebRTCTrackTransport() {
+    disconnect();
+}
+
+bool WebRTCTrackTransport::connect(const std::string& /*endpoint*/) {
+    return impl_ && impl_->start();
+}
+
+bool WebRTCTrackTransport::send(const std::string& /*track_id*/, const PacketBuffer& packet, bool keyframe) {
+    return impl_ && impl_->send(packet, keyframe);
+}
+
+bool WebRTCTrackTransport::acceptOffer(const std::string& offer_sdp, std::string& answer_sdp, std::string& session_id) {
+    return impl_ && impl_->acceptOffer(offer_sdp, answer_sdp, session_id);
+}
+
+bool WebRTCTrackTransport::updateSession(const std::string& session_id,
+                                         const std::string& fragment,
+                                         std::string& local_fragment) {
+    return impl_ && impl_->updateSession(session_id, fragment, local_fragment);
+}
+
+bool WebRTCTrackTransport::closeSession(const std::string& session_id) {
+    return impl_ && impl_->closeSession(session_id);
+}
+
+void WebRTCTrackTransport::setEncoderFeedback(EncoderFeedback feedback) {
+    if (impl_) {
+        impl_->setEncoderFeedback(std::move(feedback));
+    }
+}
+
+void WebRTCTrackTransport::disconnect() {
+    if (impl_) {
+        impl_->stop();
+    }
+}
+
+ITransport::Stats WebRTCTrackTransport::stats() const {
+    if (!impl_) {
+        return {};
+    }
+    return impl_->stats();
+}
+
+} // namespace va::media
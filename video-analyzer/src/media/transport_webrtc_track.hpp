@@ -0,0 +1,46 @@
+#pragma once
+
+#include "media/transport.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace va::media {
+
+// Sends H.264 as an RTP video track (libdatachannel packetizer, FU-A
+// fragmentation) so the browser decodes it natively. Viewers negotiate
+// WHEP-style through acceptOffer(): one recvonly offer in, one answer with
+// the candidates gathered within a short bound out; the rest, and the
+// viewer's own, trickle through updateSession(). RTCP PLI/FIR from a viewer becomes a
+// keyframe request; receiver reports feed RTT/loss into the client stats, and
+// the worst viewer's loss scales the encoder's rate (EncoderFeedback).
+class WebRTCTrackTransport : public ITransport {
+public:
+    struct Options {
+        // Local UDP ports ICE may bind (webrtc.ice_port_min/max in app.yaml).
+        uint16_t ice_port_min {10000};
+        uint16_t ice_port_max {10100};
+    };
+
+    WebRTCTrackTransport();
+    explicit WebRTCTrackTransport(Options options);
+    ~WebRTCTrackTransport() override;
+
+    bool connect(const std::string& endpoint) override;
+    bool send(const std::string& track_id, const PacketBuffer& packet, bool keyframe) override;
+    bool acceptOffer(const std::string& offer_sdp, std::string& answer_sdp, std::string& session_id) override;
+    bool updateSession(const std::string& session_id,
+                       const std::string& fragment,
+                       std::string& local_fragment) override;
+    bool closeSession(const std::string& session_id) override;
+    void setEncoderFeedback(EncoderFeedback feedback) override;
+    void disconnect() override;
+    Stats stats() const override;
+
+private:
+    struct Impl;
+    std::shared_ptr<Impl> impl_;
+};
+
+} // namespace va::media
@@ -12,12 +12,24 @@ bool WhipTransport::connect(const std::string& endpoint) {
     return true;
 }
 
-bool WhipTransport::send(const std::string& /*track_id*/, const uint8_t* data, size_t size) {
+bool WhipTransport::send(const std::string& /*track_id*/, const PacketBuffer& packet, bool /*keyframe*/) {
     if (!connected_) {
         return false;
     }
     stats_.packets += 1;
-    stats_.bytes += static_cast<uint64_t>(size);
+    stats_.bytes += static_cast<uint64_t>(packet.size());
+    return true;
+}
+
+bool WhipTransport::sendMetadata(const std::string& /*track_id*/,
+                                 const uint8_t* /*data*/,
+                                 size_t size,
+                                 bool /*keyframe*/) {
+    if (!connected_) {
+        return false;
+    }
+    stats_.metadata_packets += 1;
+    stats_.metadata_bytes += static_cast<uint64_t>(size);
     return true;
 }
 
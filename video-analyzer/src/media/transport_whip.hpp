@@ -11,7 +11,8 @@ public:
     WhipTransport();
 
     bool connect(const std::string& endpoint) override;
-    bool send(const std::string& track_id, const uint8_t* data, size_t size) override;
+    bool send(const std::string& track_id, const PacketBuffer& packet, bool keyframe) override;
+    bool sendMetadata(const std::string& track_id, const uint8_t* data, size_t size, bool keyframe) override;
     void disconnect() override;
     Stats stats() const override;
 
@@ -2,14 +2,17 @@
 
 #include "app/application.hpp"
 #include "analyzer/analyzer.hpp"
+#include "analyzer/class_names.hpp"
 #include "core/engine_manager.hpp"
 #include "core/logger.hpp"
+#include "core/utils.hpp"
 
 #include <json/json.h>
 
 #include <algorithm>
 #include <atomic>
 #include <cctype>
+#include <cmath>
 #include <cstddef>
 #include <initializer_list>
 #include <map>
@@ -73,13 +76,6 @@ Json::Value parseJson(const std::string& body) {
     return root;
 }
 
-std::string toLower(std::string value) {
-    std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) {
-        return static_cast<char>(std::tolower(c));
-    });
-    return value;
-}
-
 std::optional<std::string> getStringField(const Json::Value& node, std::initializer_list<const char*> keys) {
     for (const auto* key : keys) {
         if (node.isMember(key) && node[key].isString()) {
@@ -155,6 +151,23 @@ Json::Value metricsToJson(const va::core::Pipeline::Metrics& metrics) {
     node["last_processed_ms"] = metrics.last_processed_ms;
     node["processed_frames"] = static_cast<Json::UInt64>(metrics.processed_frames);
     node["dropped_frames"] = static_cast<Json::UInt64>(metrics.dropped_frames);
+    node["execution_mode"] = metrics.execution_mode;
+    node["output_mode"] = metrics.output_mode;
+    node["metadata_format"] = metrics.metadata_format;
+    node["avg_render_ms"] = metrics.avg_render_ms;
+    node["avg_encode_ms"] = metrics.avg_encode_ms;
+    node["encoder_bitrate_kbps"] = metrics.encoder_bitrate_kbps;
+    node["encoder_fps"] = metrics.encoder_fps;
+    Json::Value stages(Json::arrayValue);
+    for (const auto& stage : metrics.stages) {
+        Json::Value stage_node(Json::objectValue);
+        stage_node["name"] = stage.name;
+        stage_node["avg_latency_ms"] = stage.avg_latency_ms;
+        stage_node["queue_depth"] = static_cast<Json::UInt64>(stage.queue_depth);
+        stage_node["queue_capacity"] = static_cast<Json::UInt64>(stage.queue_capacity);
+        stages.append(std::move(stage_node));
+    }
+    node["stages"] = stages;
     return node;
 }
 
@@ -163,6 +176,57 @@ Json::Value transportStatsToJson(const va::media::ITransport::Stats& stats) {
     node["connected"] = stats.connected;
     node["packets"] = static_cast<Json::UInt64>(stats.packets);
     node["bytes"] = static_cast<Json::UInt64>(stats.bytes);
+    node["metadata_packets"] = static_cast<Json::UInt64>(stats.metadata_packets);
+    node["metadata_bytes"] = static_cast<Json::UInt64>(stats.metadata_bytes);
+    node["subscribers"] = static_cast<Json::UInt64>(stats.subscribers);
+    node["skipped_packets"] = static_cast<Json::UInt64>(stats.skipped_packets);
+    node["bytes_copied"] = static_cast<Json::UInt64>(stats.bytes_copied);
+    node["bytes_copied_per_sec"] = stats.bytes_copied_per_sec;
+    node["keyframe_requests"] = static_cast<Json::UInt64>(stats.keyframe_requests);
+    node["rate_scale"] = stats.rate_scale;
+    Json::Value clients(Json::arrayValue);
+    for (const auto& client : stats.clients) {
+        Json::Value entry(Json::objectValue);
+        entry["client_id"] = client.client_id;
+        entry["source_id"] = client.source_id;
+        entry["packets"] = static_cast<Json::UInt64>(client.packets);
+        entry["skipped_packets"] = static_cast<Json::UInt64>(client.skipped_packets);
+        entry["queue_delay_ms"] = client.queue_delay_ms;
+        entry["buffered_bytes"] = static_cast<Json::UInt64>(client.buffered_bytes);
+        entry["rtt_ms"] = client.rtt_ms;
+        entry["fraction_lost"] = client.fraction_lost;
+        entry["packets_lost"] = static_cast<Json::Int64>(client.packets_lost);
+        entry["jitter_ms"] = client.jitter_ms;
+        clients.append(entry);
+    }
+    node["clients"] = clients;
+    return node;
+}
+
+Json::Value sourceStatsToJson(const va::media::SourceStats& stats) {
+    Json::Value node(Json::objectValue);
+    node["decoder"] = stats.decoder;
+    node["pixel_format"] = stats.pixel_format;
+    node["fps"] = stats.fps;
+    node["avg_latency_ms"] = stats.avg_latency_ms;
+    node["last_frame_id"] = static_cast<Json::UInt64>(stats.last_frame_id);
+    node["last_pts_ms"] = stats.last_pts_ms;
+    node["buffer_policy"] = stats.buffer_policy;
+    node["buffer_capacity"] = static_cast<Json::UInt64>(stats.buffer_capacity);
+    node["buffered_frames"] = static_cast<Json::UInt64>(stats.buffered_frames);
+    node["skipped_frames"] = static_cast<Json::UInt64>(stats.skipped_frames);
+    node["dropped_frames"] = static_cast<Json::UInt64>(stats.dropped_frames);
+    node["blocked_pushes"] = static_cast<Json::UInt64>(stats.blocked_pushes);
+    node["switches"] = static_cast<Json::UInt64>(stats.switches);
+    node["last_switch_gap_ms"] = stats.last_switch_gap_ms;
+    node["switch_pending"] = stats.switch_pending;
+    node["failed_switches"] = static_cast<Json::UInt64>(stats.failed_switches);
+    node["last_switch_error"] = stats.last_switch_error;
+    node["state"] = stats.state;
+    node["last_frame_age_ms"] = stats.last_frame_age_ms;
+    node["consecutive_failures"] = stats.consecutive_failures;
+    node["reconnects"] = static_cast<Json::UInt64>(stats.reconnects);
+    node["retry_in_ms"] = stats.retry_in_ms;
     return node;
 }
 
@@ -382,7 +446,7 @@ private:
         size_t content_length = 0;
         bool has_content_length = false;
         for (const auto& entry : request.headers) {
-            std::string header_name = toLower(entry.first);
+            std::string header_name = core::toLower(entry.first);
             if (header_name == "content-length") {
                 try {
                     content_length = static_cast<size_t>(std::stoll(entry.second));
@@ -517,6 +581,7 @@ private:
             case 204: oss << "No Content"; break;
             case 400: oss << "Bad Request"; break;
             case 404: oss << "Not Found"; break;
+            case 429: oss << "Too Many Requests"; break;
             case 500: oss << "Internal Server Error"; break;
             default: oss << "Unknown"; break;
         }
@@ -569,14 +634,54 @@ Json::Value successPayload() {
     return root;
 }
 
-va::analyzer::AnalyzerParams buildParamsFromJson(const Json::Value& json) {
-    va::analyzer::AnalyzerParams params;
+// A switch refused by security.switch_limits is a 429 with Retry-After, so
+// clients can back off instead of treating it as a bad request.
+HttpResponse switchFailureResponse(const va::app::Application& app, double retry_after_ms,
+                                   const std::string& fallback) {
+    if (retry_after_ms > 0.0) {
+        HttpResponse response = errorResponse("switch rate limit exceeded", 429);
+        response.headers["Retry-After"] = std::to_string(static_cast<int>(std::ceil(retry_after_ms / 1000.0)));
+        response.headers["Access-Control-Expose-Headers"] = "Retry-After";
+        return response;
+    }
+    return errorResponse(app.lastError().empty() ? fallback : app.lastError(), 400);
+}
+
+// Applies the fields present in `json` on top of `params` (the pipeline's
+// current values), so a PATCH only changes what it mentions.
+va::analyzer::AnalyzerParams buildParamsFromJson(const Json::Value& json, va::analyzer::AnalyzerParams params) {
     if (json.isMember("conf")) {
         params.confidence_threshold = static_cast<float>(json["conf"].asDouble());
     }
     if (json.isMember("iou")) {
         params.iou_threshold = static_cast<float>(json["iou"].asDouble());
     }
+    if (json.isMember("max_det")) {
+        params.max_detections = json["max_det"].asInt();
+    } else if (json.isMember("max_detections")) {
+        params.max_detections = json["max_detections"].asInt();
+    }
+    if (json.isMember("mask_threshold")) {
+        params.mask_threshold = static_cast<float>(json["mask_threshold"].asDouble());
+    }
+
+    const char* classes_key = json.isMember("classes") ? "classes" : (json.isMember("class_whitelist") ? "class_whitelist" : nullptr);
+    if (classes_key) {
+        const Json::Value& classes = json[classes_key];
+        std::vector<std::string> tokens;
+        if (classes.isArray()) {
+            for (const auto& item : classes) {
+                tokens.emplace_back(item.isNumeric() ? std::to_string(item.asInt()) : item.asString());
+            }
+        } else if (classes.isString()) {
+            std::stringstream literal(classes.asString());
+            std::string token;
+            while (std::getline(literal, token, ',')) {
+                tokens.emplace_back(token);
+            }
+        }
+        params.class_whitelist = va::analyzer::resolveClassWhitelist(tokens);
+    }
     return params;
 }
 
@@ -636,6 +741,19 @@ struct RestServer::Impl {
         server.addRoute("POST", "/engine/set", setEngineHandler);
         server.addRoute("POST", "/api/engine/set", setEngineHandler);
 
+        auto whepOfferHandler = [this](const HttpRequest& req) { return handleWhepOffer(req); };
+        auto whepPatchHandler = [this](const HttpRequest& req) { return handleWhepPatch(req); };
+        auto whepDeleteHandler = [this](const HttpRequest& req) { return handleWhepDelete(req); };
+
+        server.addRoute("POST", "/whep/:stream/:profile", whepOfferHandler);
+        server.addRoute("POST", "/api/whep/:stream/:profile", whepOfferHandler);
+
+        server.addRoute("PATCH", "/whep/:stream/:profile/:session", whepPatchHandler);
+        server.addRoute("PATCH", "/api/whep/:stream/:profile/:session", whepPatchHandler);
+
+        server.addRoute("DELETE", "/whep/:stream/:profile/:session", whepDeleteHandler);
+        server.addRoute("DELETE", "/api/whep/:stream/:profile/:session", whepDeleteHandler);
+
         auto systemInfoHandler = [this](const HttpRequest& req) { return handleSystemInfo(req); };
         auto systemStatsHandler = [this](const HttpRequest& req) { return handleSystemStats(req); };
         auto modelsHandler = [this](const HttpRequest& req) { return handleModels(req); };
@@ -685,6 +803,10 @@ struct RestServer::Impl {
         engine_options["tensorrt_workspace_mb"] = config.engine.options.tensorrt_workspace_mb;
         engine_options["io_binding_input_bytes"] = static_cast<Json::UInt64>(config.engine.options.io_binding_input_bytes);
         engine_options["io_binding_output_bytes"] = static_cast<Json::UInt64>(config.engine.options.io_binding_output_bytes);
+        engine_options["batching"] = config.engine.options.batching_enabled;
+        engine_options["max_batch_size"] = config.engine.options.max_batch_size;
+        engine_options["max_batch_wait_us"] = config.engine.options.max_batch_wait_us;
+        engine_options["intra_op_threads"] = config.engine.options.intra_op_threads;
         engine["options"] = engine_options;
         data["engine"] = engine;
 
@@ -731,6 +853,29 @@ struct RestServer::Impl {
         data["dropped_frames"] = static_cast<Json::UInt64>(stats.dropped_frames);
         data["transport_packets"] = static_cast<Json::UInt64>(stats.transport_packets);
         data["transport_bytes"] = static_cast<Json::UInt64>(stats.transport_bytes);
+
+        Json::Value shared_engines(Json::arrayValue);
+        for (const auto& engine : stats.shared_engines) {
+            Json::Value node(Json::objectValue);
+            node["key"] = engine.key;
+            node["clients"] = static_cast<Json::UInt64>(engine.clients);
+            node["batches"] = static_cast<Json::UInt64>(engine.batches);
+            node["requests"] = static_cast<Json::UInt64>(engine.requests);
+            node["avg_batch_size"] = engine.avg_batch_size;
+            node["max_batch_size"] = engine.max_batch_size;
+            node["dynamic_batch"] = engine.dynamic_batch;
+            shared_engines.append(node);
+        }
+        data["shared_engines"] = shared_engines;
+
+        Json::Value frame_pool(Json::objectValue);
+        frame_pool["allocations"] = static_cast<Json::UInt64>(stats.frame_pool.allocations);
+        frame_pool["reuses"] = static_cast<Json::UInt64>(stats.frame_pool.reuses);
+        frame_pool["allocations_per_sec"] = stats.frame_pool.allocations_per_sec;
+        frame_pool["buffers_in_use"] = static_cast<Json::UInt64>(stats.frame_pool.buffers_in_use);
+        frame_pool["buffers_pooled"] = static_cast<Json::UInt64>(stats.frame_pool.buffers_pooled);
+        frame_pool["bytes_pooled"] = static_cast<Json::UInt64>(stats.frame_pool.bytes_pooled);
+        data["frame_pool"] = frame_pool;
         payload["data"] = data;
         return jsonResponse(payload, 200);
     }
@@ -769,8 +914,10 @@ struct RestServer::Impl {
             node["running"] = info.running;
             node["last_active_ms"] = info.last_active_ms;
             node["track_id"] = info.track_id;
+            node["subscriptions"] = info.subscriptions;
             node["metrics"] = metricsToJson(info.metrics);
             node["transport_stats"] = transportStatsToJson(info.transport_stats);
+            node["source_stats"] = sourceStatsToJson(info.source_stats);
             node["encoder"] = encoderConfigToJson(info.encoder_cfg);
             data.append(std::move(node));
         }
@@ -874,8 +1021,9 @@ struct RestServer::Impl {
                 return errorResponse("Missing required field: source_uri", 400);
             }
 
-            if (!app.switchSource(*stream_opt, *profile_opt, *uri_opt)) {
-                return errorResponse(app.lastError().empty() ? "switch source failed" : app.lastError(), 400);
+            double retry_after_ms = 0.0;
+            if (!app.switchSource(*stream_opt, *profile_opt, *uri_opt, retry_after_ms)) {
+                return switchFailureResponse(app, retry_after_ms, "switch source failed");
             }
 
             Json::Value payload = successPayload();
@@ -904,8 +1052,9 @@ struct RestServer::Impl {
                 return errorResponse("Missing required field: model_id", 400);
             }
 
-            if (!app.switchModel(*stream_opt, *profile_opt, *model_opt)) {
-                return errorResponse(app.lastError().empty() ? "switch model failed" : app.lastError(), 400);
+            double retry_after_ms = 0.0;
+            if (!app.switchModel(*stream_opt, *profile_opt, *model_opt, retry_after_ms)) {
+                return switchFailureResponse(app, retry_after_ms, "switch model failed");
             }
 
             Json::Value payload = successPayload();
@@ -959,7 +1108,8 @@ struct RestServer::Impl {
                 return errorResponse("Missing required field: profile", 400);
             }
 
-            auto params = buildParamsFromJson(body);
+            auto current = app.currentParams(*stream_opt, *profile_opt);
+            auto params = buildParamsFromJson(body, current.value_or(va::analyzer::AnalyzerParams{}));
             if (!app.updateParams(*stream_opt, *profile_opt, params)) {
                 return errorResponse(app.lastError().empty() ? "update params failed" : app.lastError(), 400);
             }
@@ -967,6 +1117,13 @@ struct RestServer::Impl {
             Json::Value payload = successPayload();
             payload["conf"] = params.confidence_threshold;
             payload["iou"] = params.iou_threshold;
+            payload["max_det"] = params.max_detections;
+            payload["mask_threshold"] = params.mask_threshold;
+            Json::Value classes(Json::arrayValue);
+            for (int cls : params.class_whitelist) {
+                classes.append(cls);
+            }
+            payload["classes"] = classes;
             return jsonResponse(payload, 200);
         } catch (const std::exception& ex) {
             return errorResponse(ex.what(), 400);
@@ -994,6 +1151,57 @@ struct RestServer::Impl {
             return errorResponse(ex.what(), 400);
         }
     }
+
+    // WHEP (RFC 9725 style): the body is the viewer's SDP offer, the response
+    // the answer with the candidates gathered so far; Location names the
+    // session to PATCH (trickle ICE) and DELETE.
+    HttpResponse handleWhepOffer(const HttpRequest& req) {
+        const std::string& stream_id = req.params.at("stream");
+        const std::string& profile = req.params.at("profile");
+        if (req.body.empty()) {
+            return errorResponse("Missing SDP offer", 400);
+        }
+
+        std::string answer;
+        auto session = app.acceptViewerOffer(stream_id, profile, req.body, answer);
+        if (!session) {
+            return errorResponse(app.lastError(), 400);
+        }
+
+        HttpResponse response;
+        response.status_code = 201;
+        response.headers["Content-Type"] = "application/sdp";
+        response.headers["Location"] = req.path + "/" + *session;
+        response.headers["Access-Control-Expose-Headers"] = "Location";
+        response.body = answer;
+        return response;
+    }
+
+    // Trickle ICE: the body carries the viewer's candidates, the response the
+    // server's gathered since the answer (204 when there are none yet).
+    HttpResponse handleWhepPatch(const HttpRequest& req) {
+        std::string local_fragment;
+        if (!app.updateViewerSession(req.params.at("stream"), req.params.at("profile"), req.params.at("session"),
+                                     req.body, local_fragment)) {
+            return errorResponse(app.lastError(), 404);
+        }
+        HttpResponse response;
+        if (local_fragment.empty()) {
+            response.status_code = 204;
+            return response;
+        }
+        response.status_code = 200;
+        response.headers["Content-Type"] = "application/trickle-ice-sdpfrag";
+        response.body = local_fragment;
+        return response;
+    }
+
+    HttpResponse handleWhepDelete(const HttpRequest& req) {
+        if (!app.closeViewerSession(req.params.at("stream"), req.params.at("profile"), req.params.at("session"))) {
+            return errorResponse(app.lastError(), 404);
+        }
+        return jsonResponse(successPayload(), 200);
+    }
 };
 
 RestServer::RestServer(RestServerOptions options, va::app::Application& app)
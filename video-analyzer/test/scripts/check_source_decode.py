@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+"""Check the decode source against a local file or a local RTSP server.
+
+This helper assumes the Video Analyzer backend is already running. It:
+
+1. Optionally publishes --publish-file to a local RTSP server (e.g. MediaMTX)
+   with ``ffmpeg -re -stream_loop -1 ... -f rtsp`` so --url has something to
+   play.
+2. Issues `/api/subscribe` for a temporary stream ID.
+3. Samples `source_stats` from `/api/pipelines` for --seconds and checks that
+   frames arrive, that `last_pts_ms` (stream time) advances at roughly wall
+   clock speed, and which decoder/pixel format served the stream.
+4. Unsubscribes and stops the publisher.
+
+Usage::
+
+    # a file the backend can open directly
+    python scripts/check_source_decode.py --profile det_720p --url /data/clips/street.mp4
+
+    # through a local RTSP server
+    python scripts/check_source_decode.py --profile det_720p \
+        --publish-file /data/clips/street.mp4 \
+        --url rtsp://127.0.0.1:8554/decode_check
+
+The command exits with status 0 when all checks pass, otherwise 1.
+"""
+
+from __future__ import annotations
+
+import argparse
+import subprocess
+import sys
+import time
+import uuid
+from typing import Iterable, Optional
+
+import requests
+
+
+def post_json(base_url: str, path: str, payload: dict, timeout: float) -> dict:
+    url = f"{base_url.rstrip('/')}{path}"
+    response = requests.post(url, json=payload, timeout=timeout)
+    response.raise_for_status()
+    data = response.json()
+    if not isinstance(data, dict) or not data.get("success"):
+        raise ValueError(f"endpoint {url} reported failure: {data!r}")
+    return data
+
+
+def find_source_stats(base_url: str, key: str, timeout: float) -> Optional[dict]:
+    response = requests.get(f"{base_url}/api/pipelines", timeout=timeout)
+    response.raise_for_status()
+    for item in response.json().get("data", []):
+        if item.get("key") == key:
+            return item.get("source_stats")
+    return None
+
+
+def start_publisher(path: str, url: str) -> subprocess.Popen:
+    command = [
+        "ffmpeg", "-hide_banner", "-loglevel", "error",
+        "-re", "-stream_loop", "-1", "-i", path,
+        "-c", "copy", "-f", "rtsp", "-rtsp_transport", "tcp", url,
+    ]
+    print(f"[info] publishing {path} to {url}")
+    return subprocess.Popen(command)
+
+
+def main(argv: Iterable[str]) -> int:
+    parser = argparse.ArgumentParser(description="Check source decoding, timestamps and pixel format")
+    parser.add_argument("--base", default="http://127.0.0.1:8082", help="Analysis API base URL")
+    parser.add_argument("--profile", required=True, help="Profile to subscribe with")
+    parser.add_argument("--url", required=True, help="Source URL or local file path")
+    parser.add_argument("--publish-file", default=None, help="Publish this file to --url with ffmpeg first")
+    parser.add_argument("--seconds", type=float, default=10.0, help="How long to sample")
+    parser.add_argument("--expect-decoder", default=None, help="Require source_stats.decoder (ffmpeg/opencv)")
+    parser.add_argument("--pts-tolerance", type=float, default=0.2, help="Allowed relative drift of stream time")
+    parser.add_argument("--timeout", type=float, default=10.0, help="HTTP timeout in seconds")
+    args = parser.parse_args(list(argv))
+
+    base_url = args.base.rstrip('/')
+    stream_id = f"decode_{int(time.time())}_{uuid.uuid4().hex[:6]}"
+    key = f"{stream_id}:{args.profile}"
+    publisher: Optional[subprocess.Popen] = None
+    subscribed = False
+
+    try:
+        if args.publish_file:
+            publisher = start_publisher(args.publish_file, args.url)
+            time.sleep(2.0)
+
+        post_json(base_url, "/api/subscribe", {"stream": stream_id, "profile": args.profile, "url": args.url}, args.timeout)
+        subscribed = True
+        print(f"[info] subscribed {stream_id} with profile {args.profile}")
+
+        # Wait for the first frame, then measure over --seconds.
+        deadline = time.monotonic() + args.timeout
+        first = None
+        while time.monotonic() < deadline:
+            stats = find_source_stats(base_url, key, args.timeout)
+            if stats and stats.get("last_frame_id", 0) > 0:
+                first = (time.monotonic(), stats)
+                break
+            time.sleep(0.5)
+        if first is None:
+            raise ValueError("no frame decoded before the timeout")
+
+        time.sleep(args.seconds)
+        last_stats = find_source_stats(base_url, key, args.timeout)
+        if not last_stats:
+            raise ValueError("pipeline disappeared while sampling")
+        wall_ms = (time.monotonic() - first[0]) * 1000.0
+        frames = last_stats["last_frame_id"] - first[1]["last_frame_id"]
+        pts_ms = last_stats.get("last_pts_ms", 0.0) - first[1].get("last_pts_ms", 0.0)
+
+        print(f"[info] decoder={last_stats.get('decoder')} pixel_format={last_stats.get('pixel_format')}")
+        print(f"[info] {frames} frames in {wall_ms / 1000.0:.1f}s, stream time advanced {pts_ms / 1000.0:.1f}s, "
+              f"dropped={last_stats.get('dropped_frames')}")
+
+        if args.expect_decoder and last_stats.get("decoder") != args.expect_decoder:
+            raise ValueError(f"decoder is {last_stats.get('decoder')!r}, expected {args.expect_decoder!r}")
+        if frames <= 0:
+            raise ValueError("frame counter did not advance")
+        if abs(pts_ms - wall_ms) > wall_ms * args.pts_tolerance:
+            raise ValueError(f"stream time drifted from wall clock: {pts_ms:.0f} ms vs {wall_ms:.0f} ms")
+
+        print("\nSource decode check passed.")
+        return 0
+
+    except Exception as exc:  # noqa: BLE001 - convert any failures into non-zero exit code
+        print(f"[error] {exc}")
+        return 1
+
+    finally:
+        if subscribed:
+            try:
+                post_json(base_url, "/api/unsubscribe", {"stream": stream_id, "profile": args.profile}, args.timeout)
+            except Exception as exc:  # noqa: BLE001
+                print(f"[warn] unsubscribe failed: {exc}")
+        if publisher:
+            publisher.terminate()
+            publisher.wait(timeout=5)
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
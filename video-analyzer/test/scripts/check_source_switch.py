@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+"""Check hot source switching and the switch rate limit.
+
+This helper assumes the Video Analyzer backend is already running. It:
+
+1. Issues `/api/subscribe` for a temporary stream ID on --url.
+2. Waits for frames, then calls `/api/source/switch` to --switch-url.
+3. Polls `source_stats` from `/api/pipelines` until `switches` increments and
+   checks `last_switch_gap_ms` against --max-gap-ms.
+4. Switches again straight away and expects `429` while
+   `security.switch_limits.source_per_stream_per_sec` is set (skip with
+   --no-limit-check).
+5. Unsubscribes.
+
+Usage::
+
+    python scripts/check_source_switch.py --profile det_720p \
+        --url rtsp://127.0.0.1:8554/camera_01 \
+        --switch-url rtsp://127.0.0.1:8554/camera_02
+
+The command exits with status 0 when all checks pass, otherwise 1.
+"""
+
+from __future__ import annotations
+
+import argparse
+import sys
+import time
+import uuid
+from typing import Iterable, Optional
+
+import requests
+
+
+def post_json(base_url: str, path: str, payload: dict, timeout: float) -> dict:
+    url = f"{base_url.rstrip('/')}{path}"
+    response = requests.post(url, json=payload, timeout=timeout)
+    response.raise_for_status()
+    data = response.json()
+    if not isinstance(data, dict) or not data.get("success"):
+        raise ValueError(f"endpoint {url} reported failure: {data!r}")
+    return data
+
+
+def find_source_stats(base_url: str, key: str, timeout: float) -> Optional[dict]:
+    response = requests.get(f"{base_url}/api/pipelines", timeout=timeout)
+    response.raise_for_status()
+    for item in response.json().get("data", []):
+        if item.get("key") == key:
+            return item.get("source_stats")
+    return None
+
+
+def wait_for(base_url: str, key: str, timeout: float, predicate) -> dict:
+    deadline = time.monotonic() + timeout
+    while time.monotonic() < deadline:
+        stats = find_source_stats(base_url, key, timeout)
+        if stats and predicate(stats):
+            return stats
+        time.sleep(0.2)
+    raise ValueError("timed out waiting for source_stats")
+
+
+def main(argv: Iterable[str]) -> int:
+    parser = argparse.ArgumentParser(description="Check hot source switching and switch limits")
+    parser.add_argument("--base", default="http://127.0.0.1:8082", help="Analysis API base URL")
+    parser.add_argument("--profile", required=True, help="Profile to subscribe with")
+    parser.add_argument("--url", required=True, help="Initial source URL")
+    parser.add_argument("--switch-url", required=True, help="URL to switch to")
+    parser.add_argument("--max-gap-ms", type=float, default=500.0, help="Largest acceptable switch gap")
+    parser.add_argument("--no-limit-check", action="store_true", help="Skip the 429 rate limit check")
+    parser.add_argument("--timeout", type=float, default=15.0, help="HTTP / wait timeout in seconds")
+    args = parser.parse_args(list(argv))
+
+    base_url = args.base.rstrip('/')
+    stream_id = f"switch_{int(time.time())}_{uuid.uuid4().hex[:6]}"
+    key = f"{stream_id}:{args.profile}"
+    subscribed = False
+    switch_payload = {"stream": stream_id, "profile": args.profile, "url": args.switch_url}
+
+    try:
+        post_json(base_url, "/api/subscribe", {"stream": stream_id, "profile": args.profile, "url": args.url}, args.timeout)
+        subscribed = True
+        print(f"[info] subscribed {stream_id} with profile {args.profile}")
+
+        before = wait_for(base_url, key, args.timeout, lambda s: s.get("last_frame_id", 0) > 0)
+        post_json(base_url, "/api/source/switch", switch_payload, args.timeout)
+        print(f"[info] switching to {args.switch_url}")
+
+        # The switch is prefetched in the background; a URI that does not
+        # open shows up as a failed switch instead.
+        after = wait_for(base_url, key, args.timeout,
+                         lambda s: not s.get("switch_pending")
+                         and (s.get("switches", 0) > before.get("switches", 0)
+                              or s.get("failed_switches", 0) > before.get("failed_switches", 0)))
+        if after.get("failed_switches", 0) > before.get("failed_switches", 0):
+            raise ValueError(f"switch to {args.switch_url} failed: {after.get('last_switch_error')}")
+        gap_ms = after.get("last_switch_gap_ms", 0.0)
+        print(f"[info] switched, gap {gap_ms:.1f} ms, frames {before['last_frame_id']} -> {after['last_frame_id']}")
+        if gap_ms > args.max_gap_ms:
+            raise ValueError(f"switch gap {gap_ms:.1f} ms exceeds {args.max_gap_ms:.1f} ms")
+
+        if not args.no_limit_check:
+            response = requests.post(f"{base_url}/api/source/switch", json=switch_payload, timeout=args.timeout)
+            if response.status_code != 429:
+                raise ValueError(f"immediate second switch returned {response.status_code}, expected 429")
+            print(f"[info] second switch limited, Retry-After {response.headers.get('Retry-After')} s")
+
+        print("\nSource switch check passed.")
+        return 0
+
+    except Exception as exc:  # noqa: BLE001 - convert any failures into non-zero exit code
+        print(f"[error] {exc}")
+        return 1
+
+    finally:
+        if subscribed:
+            try:
+                post_json(base_url, "/api/unsubscribe", {"stream": stream_id, "profile": args.profile}, args.timeout)
+            except Exception as exc:  # noqa: BLE001
+                print(f"[warn] unsubscribe failed: {exc}")
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,161 @@
+#!/usr/bin/env python3
+"""Receive a pipeline's RTP video track through WHEP with a local peer.
+
+This helper assumes the Video Analyzer backend is already running and that
+the chosen profile publishes with ``publish.transport: rtp``. It:
+
+1. Issues `/api/subscribe` for a temporary stream ID (or reuses --stream).
+2. Creates a recvonly aiortc peer, POSTs its offer to `/api/whep/...` and
+   applies the returned answer.
+3. Decodes video frames for --seconds and checks enough of them arrive.
+4. Prints the session's RTCP figures (RTT, loss, jitter) and the keyframe
+   request count from `/api/pipelines`.
+5. DELETEs the WHEP session and unsubscribes.
+
+Usage (after setting ``publish.transport: rtp`` on det_720p)::
+
+    python scripts/check_whep_loopback.py \
+        --base http://127.0.0.1:8082 \
+        --profile det_720p \
+        --url rtsp://127.0.0.1:8554/camera_01
+
+The command exits with status 0 when frames were received, otherwise 1.
+"""
+
+from __future__ import annotations
+
+import argparse
+import asyncio
+import sys
+import time
+import uuid
+from typing import Iterable, Optional
+
+import requests
+from aiortc import RTCPeerConnection, RTCSessionDescription
+
+
+def post_json(base_url: str, path: str, payload: dict, timeout: float) -> dict:
+    url = f"{base_url.rstrip('/')}{path}"
+    response = requests.post(url, json=payload, timeout=timeout)
+    response.raise_for_status()
+    data = response.json()
+    if not isinstance(data, dict) or not data.get("success"):
+        raise ValueError(f"endpoint {url} reported failure: {data!r}")
+    return data
+
+
+def find_transport_stats(base_url: str, key: str, timeout: float) -> Optional[dict]:
+    response = requests.get(f"{base_url}/api/pipelines", timeout=timeout)
+    response.raise_for_status()
+    for item in response.json().get("data", []):
+        if item.get("key") == key:
+            return item.get("transport_stats")
+    return None
+
+
+async def receive(base_url: str, stream_id: str, profile: str, seconds: float, timeout: float) -> int:
+    pc = RTCPeerConnection()
+    pc.addTransceiver("video", direction="recvonly")
+    frames = 0
+    first_frame_at: Optional[float] = None
+    started = time.monotonic()
+    done = asyncio.Event()
+
+    @pc.on("track")
+    def on_track(track):  # noqa: ANN001 - aiortc callback
+        async def consume():
+            nonlocal frames, first_frame_at
+            while not done.is_set():
+                try:
+                    await track.recv()
+                except Exception:  # noqa: BLE001 - track ended
+                    return
+                frames += 1
+                if first_frame_at is None:
+                    first_frame_at = time.monotonic()
+
+        asyncio.ensure_future(consume())
+
+    # aiortc gathers all candidates in setLocalDescription, matching WHEP's
+    # non-trickle exchange.
+    await pc.setLocalDescription(await pc.createOffer())
+    response = requests.post(
+        f"{base_url}/api/whep/{stream_id}/{profile}",
+        data=pc.localDescription.sdp,
+        headers={"Content-Type": "application/sdp"},
+        timeout=timeout,
+    )
+    if response.status_code != 201:
+        await pc.close()
+        raise ValueError(f"WHEP offer rejected ({response.status_code}): {response.text}")
+    location = response.headers.get("Location", "")
+    await pc.setRemoteDescription(RTCSessionDescription(sdp=response.text, type="answer"))
+    print(f"[info] WHEP session created: {location}")
+
+    await asyncio.sleep(seconds)
+    done.set()
+
+    stats = find_transport_stats(base_url, f"{stream_id}:{profile}", timeout)
+    if stats:
+        print(f"[info] keyframe requests: {stats.get('keyframe_requests')}")
+        for client in stats.get("clients", []):
+            print(
+                "[info] session {client_id}: packets={packets} rtt={rtt_ms:.1f}ms "
+                "lost={packets_lost} ({fraction_lost:.1%}) jitter={jitter_ms:.1f}ms".format(**client)
+            )
+
+    if location:
+        requests.delete(f"{base_url}{location}", timeout=timeout)
+    await pc.close()
+
+    if first_frame_at is not None:
+        print(f"[info] first frame after {first_frame_at - started:.2f}s, {frames} frames in {seconds:.0f}s")
+    return frames
+
+
+def main(argv: Iterable[str]) -> int:
+    parser = argparse.ArgumentParser(description="Check WHEP video track delivery with a loopback peer")
+    parser.add_argument("--base", default="http://127.0.0.1:8082", help="Analysis API base URL")
+    parser.add_argument("--profile", required=True, help="Profile publishing with transport: rtp")
+    parser.add_argument("--url", default=None, help="Source URL; subscribes a temporary stream when given")
+    parser.add_argument("--stream", default=None, help="Existing stream id to watch instead of subscribing")
+    parser.add_argument("--seconds", type=float, default=5.0, help="How long to receive")
+    parser.add_argument("--min-frames", type=int, default=10, help="Frames required to pass")
+    parser.add_argument("--timeout", type=float, default=10.0, help="HTTP timeout in seconds")
+    args = parser.parse_args(list(argv))
+
+    if not args.url and not args.stream:
+        parser.error("one of --url or --stream is required")
+
+    base_url = args.base.rstrip('/')
+    stream_id = args.stream or f"whep_{int(time.time())}_{uuid.uuid4().hex[:6]}"
+    subscribed = False
+
+    try:
+        if not args.stream:
+            post_json(base_url, "/api/subscribe", {"stream": stream_id, "profile": args.profile, "url": args.url}, args.timeout)
+            subscribed = True
+            print(f"[info] subscribed {stream_id} with profile {args.profile}")
+
+        frames = asyncio.run(receive(base_url, stream_id, args.profile, args.seconds, args.timeout))
+        if frames < args.min_frames:
+            raise ValueError(f"only {frames} frames decoded, expected at least {args.min_frames}")
+
+        print("\nWHEP loopback passed.")
+        return 0
+
+    except Exception as exc:  # noqa: BLE001 - convert any failures into non-zero exit code
+        print(f"[error] {exc}")
+        return 1
+
+    finally:
+        if subscribed:
+            try:
+                post_json(base_url, "/api/unsubscribe", {"stream": stream_id, "profile": args.profile}, args.timeout)
+            except Exception as exc:  # noqa: BLE001
+                print(f"[warn] unsubscribe failed: {exc}")
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,72 @@
+#!/usr/bin/env python3
+"""Record raw model outputs for the postprocessing microbenchmarks.
+
+Runs an ONNX model on one image (letterboxed to the model input, RGB, scaled
+to [0, 1]) and writes every output as raw float32, the format the benchmarks
+under `bench/` read. Output 0 goes to `--out`, output i > 0 to `--out.i`.
+Running a YOLO and a DETR model on the same image gives comparable heads.
+
+Usage example::
+
+    python scripts/record_model_outputs.py --model model/yolov12x.onnx \
+        --image frame.jpg --out yolov12x_head.f32
+    yolo_decode_bench --tensor yolov12x_head.f32 --shape 1x84x8400
+
+    python scripts/record_model_outputs.py --model model/rtdetr-l.onnx \
+        --image frame.jpg --out rtdetr_head.f32
+    postproc_bench --yolo yolov12x_head.f32 --detr rtdetr_head.f32 --detr-shape 1x300x84
+"""
+
+from __future__ import annotations
+
+import argparse
+import sys
+
+import cv2
+import numpy as np
+import onnxruntime as ort
+
+
+def letterbox(image: np.ndarray, width: int, height: int) -> np.ndarray:
+    scale = min(width / image.shape[1], height / image.shape[0])
+    resized_w = max(1, round(image.shape[1] * scale))
+    resized_h = max(1, round(image.shape[0] * scale))
+    resized = cv2.resize(image, (resized_w, resized_h), interpolation=cv2.INTER_LINEAR)
+    canvas = np.full((height, width, 3), 114, dtype=np.uint8)
+    top = (height - resized_h) // 2
+    left = (width - resized_w) // 2
+    canvas[top:top + resized_h, left:left + resized_w] = resized
+    return canvas
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--model", required=True, help="ONNX detection/segmentation model")
+    parser.add_argument("--image", required=True, help="input image (any OpenCV-readable format)")
+    parser.add_argument("--out", required=True, help="destination for output 0; further outputs get a .N suffix")
+    args = parser.parse_args()
+
+    image = cv2.imread(args.image)
+    if image is None:
+        print(f"cannot read {args.image}", file=sys.stderr)
+        return 1
+
+    session = ort.InferenceSession(args.model, providers=["CPUExecutionProvider"])
+    model_input = session.get_inputs()[0]
+    height = model_input.shape[2] if isinstance(model_input.shape[2], int) else 640
+    width = model_input.shape[3] if isinstance(model_input.shape[3], int) else 640
+
+    boxed = letterbox(image, width, height)
+    blob = cv2.cvtColor(boxed, cv2.COLOR_BGR2RGB).astype(np.float32) / 255.0
+    blob = np.ascontiguousarray(blob.transpose(2, 0, 1)[None])
+
+    outputs = session.run(None, {model_input.name: blob})
+    for index, output in enumerate(outputs):
+        path = args.out if index == 0 else f"{args.out}.{index}"
+        output.astype(np.float32).tofile(path)
+        print(f"wrote {path} shape={'x'.join(str(d) for d in output.shape)}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
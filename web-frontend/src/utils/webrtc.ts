@@ -21,6 +21,7 @@ export class WebRTCClient {
   private pendingIceCandidates: any[] = [];
   private pendingStream: MediaStream | null = null;
   private dataChannel: RTCDataChannel | null = null;
+  private metaChannel: RTCDataChannel | null = null; // 检测结果元数据通道
   private jpegBuffer: ArrayBuffer[] = [];
   private currentFrameSize: number = 0;
   private frameReceiving: boolean = false;
@@ -31,6 +32,7 @@ export class WebRTCClient {
   private onDisconnected?: () => void;
   private onVideoStream?: (stream: MediaStream) => void;
   private onJpegFrame?: (jpegData: ArrayBuffer) => void;
+  private onMetadata?: (record: ArrayBuffer) => void;
   private onError?: (error: string) => void;
 
   constructor(config: WebRTCConfig) {
@@ -101,12 +103,14 @@ export class WebRTCClient {
     onDisconnected?: () => void;
     onVideoStream?: (stream: MediaStream) => void;
     onJpegFrame?: (jpegData: ArrayBuffer) => void;
+    onMetadata?: (record: ArrayBuffer) => void;
     onError?: (error: string) => void;
   }): void {
     this.onConnected = handlers.onConnected;
     this.onDisconnected = handlers.onDisconnected;
     this.onVideoStream = handlers.onVideoStream;
     this.onJpegFrame = handlers.onJpegFrame;
+    this.onMetadata = handlers.onMetadata;
     this.onError = handlers.onError;
   }
 
@@ -243,6 +247,17 @@ export class WebRTCClient {
     // 处理数据通道
     this.peerConnection.ondatachannel = (event) => {
       console.log("📡 收到数据通道:", event.channel.label);
+
+      // 检测元数据走独立的 "meta" 通道，每条消息是一条完整记录，不能进入视频帧解析
+      if (event.channel.label === "meta") {
+        this.metaChannel = event.channel;
+        this.metaChannel.binaryType = "arraybuffer";
+        this.metaChannel.onmessage = (metaEvent) => {
+          this.onMetadata?.(metaEvent.data);
+        };
+        return;
+      }
+
       this.dataChannel = event.channel;
 
       this.dataChannel.binaryType = "arraybuffer";